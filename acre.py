@@ -35,8 +35,19 @@ parser.add_option("-d", "--debug", action = "store_true", dest = "debugMode",
     default = False, help = "display debug info")
 parser.add_option("-s", "--stat", action = "store_true", dest = "statMode",
     default = False, help = "display stats")
+parser.add_option("-k", "--rules", dest = "rules", default = "all",
+    help = "comma separated list of rules to check (anchor-usage, anchor-middle, " +
+    "charset, duplicate-punc, optional-brace, wild-punctuation, repeat-punctuation, " +
+    "digit-too-optional, or all)")
 opts, args = parser.parse_args()
 
+# convert the rules to a rule mask
+try:
+  ruleMask = egret_ext.rule_mask(opts.rules)
+except egret_ext.error as e:
+  print(str(e))
+  sys.exit(-1)
+
 # check for valid command lines
 if opts.fileName != None and opts.regex != None:
   print("Cannot specify both a regular expression and input file")
@@ -64,7 +75,7 @@ try:
 
   # execute regex-test
   # start_time = time.process_time()
-  alerts = egret_ext.run(regexStr, "evil", True, False, opts.debugMode, opts.statMode)
+  alerts = egret_ext.run(regexStr, "evil", True, False, opts.debugMode, opts.statMode, ruleMask)
   # elapsed_time = time.process_time() - start_time
 
 except re.error as e:
@@ -25,8 +25,9 @@ from optparse import OptionParser
 #import time
 
 # Precondition: regexStr successfully compiles and all strings in testStrings
-# match the regular expression
-def get_group_info(regexStr, testStrings, namedOnly):
+# match the regular expression.  groupMap holds the groups found by the engine
+# (strings without an entry are matched again to get their groups).
+def get_group_info(regexStr, testStrings, namedOnly, groupMap = {}):
    # check for empty list
    if len(testStrings) == 0:
        return {}
@@ -35,18 +36,10 @@ def get_group_info(regexStr, testStrings, namedOnly):
    regex = re.compile(regexStr)
 
    # determine if there are named groups, numbered groups, or no groups
-   match = regex.fullmatch(testStrings[0])
-   if len(match.groupdict()) != 0:
+   if len(regex.groupindex) != 0:
        useNames = True
-       names = list(match.groupdict().keys())
-       nameList = []
-       for name in names:
-           r = r"\?P<" + name
-           start = re.search(r, regexStr).start()
-           nameList.append((start, name))
-       nameList = sorted(nameList)
-       groupHdr = [ name for (start, name) in nameList ]
-   elif len(match.groups()) != 0:
+       groupHdr = sorted([ (num, name) for (name, num) in regex.groupindex.items() ])
+   elif regex.groups != 0:
        if namedOnly:
            return None
        useNames = False
@@ -56,15 +49,16 @@ def get_group_info(regexStr, testStrings, namedOnly):
    # get groups for each string
    groupDict = {}
    for testStr in testStrings:
-       match = regex.fullmatch(testStr)
+       groups = groupMap.get(testStr)
+       if groups == None:
+           groups = regex.fullmatch(testStr).groups()
        if useNames:
-           g = match.groupdict()
            groupList = []
-           for i in groupHdr:
-               groupList.append({i: g[i]})
+           for (num, name) in groupHdr:
+               groupList.append({name: groups[num - 1]})
            groupDict[testStr] = groupList
        else:
-           groupDict[testStr] = match.groups()
+           groupDict[testStr] = groups
 
    return groupDict
 
@@ -108,12 +102,17 @@ else:
 try:
     regex = re.compile(regexStr)
 
-    # execute regex-test
+    # execute regex-test (strings are classified by the engine)
     #start_time = time.process_time()
-    inputStrs = egret_ext.run(regexStr, opts.baseSubstring,
-        False, False, opts.debugMode, opts.statMode)
-    status = inputStrs[0]
-    hasError = (status[0:5] == "ERROR")
+    (alerts, matches, nonMatches, undecided, groups) = egret_ext.run_match(regexStr,
+        opts.baseSubstring, [], False, opts.debugMode, opts.statMode)
+    groupMap = {}
+    for (matchStr, g) in zip(matches, groups):
+        if g != None:
+            groupMap[matchStr] = g
+    hasError = (len(alerts) > 0 and alerts[0][0:5] == "ERROR")
+    if hasError:
+        status = alerts[0]
 
 except re.error as e:
     status = "ERROR (compiler error): Regular expression did not compile: " + str(e)
@@ -121,35 +120,24 @@ except re.error as e:
 
 if hasError:
     alerts = [status]
-else:
-    idx = 0
-    line = inputStrs[idx]
-    while line != "BEGIN":
-        idx += 1;
-        line = inputStrs[idx]
-    if idx == 0:
-        alerts = []
-        inputStrs = inputStrs[1:]
-    else:
-        alerts = inputStrs[:idx]
-        inputStrs = inputStrs[idx+1:]
 
 if not hasError:
 
-  # test each string against the regex
-  matches = []
-  nonMatches = []
-  for inputStr in inputStrs:
-    search = regex.fullmatch(inputStr)
-    if search:
-        matches.append(inputStr)
-    else:
-        nonMatches.append(inputStr)
+  # test each string the engine could not classify against the regex
+  if len(undecided) > 0:
+    for inputStr in undecided:
+      search = regex.fullmatch(inputStr)
+      if search:
+          matches.append(inputStr)
+      else:
+          nonMatches.append(inputStr)
+    matches.sort()
+    nonMatches.sort()
   #elapsed_time = time.process_time() - start_time
 
   # display groups if requested
   if opts.showGroups or opts.showNamedGroups:
-      groupDict = get_group_info(regexStr, matches, opts.showNamedGroups)
+      groupDict = get_group_info(regexStr, matches, opts.showNamedGroups, groupMap)
       if groupDict == None:
           showGroups = False
           if opts.showGroups:
@@ -203,7 +191,7 @@ if opts.outputFile:
     outFile.write("Matches:\n")
 else:
     print("Matches:")
-for inputStr in sorted(matches):
+for inputStr in matches:
     if inputStr == "":
         dispStr = "<empty>"
     else:
@@ -222,7 +210,7 @@ if opts.outputFile:
     outFile.write("\nNon-matches:\n")
 else:
     print("\nNon-matches:")
-for inputStr in sorted(nonMatches):
+for inputStr in nonMatches:
     if inputStr == "":
         dispStr = "<empty>"
     else:
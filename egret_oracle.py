@@ -0,0 +1,233 @@
+# egret_oracle.py: Compares the EGRET matcher with Python re and std::regex
+#
+# Copyright (C) 2016-2018  Eric Larson and Anna Kirk
+# elarson@seattleu.edu
+#
+# This file is part of EGRET.
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+# Each regex in the corpus (one per line) is run through EGRET.  Every
+# generated string is classified by the native matcher (along with the groups
+# of each match), by Python re, and by std::regex when the regex and the string
+# mean the same thing in the ECMAScript grammar.  Python re is the reference:
+# any other verdict that differs is reported along with the regex and string.
+# The regexes are checked in parallel worker processes.  A regex whose check
+# raises an exception or kills its worker is reported as an error.
+
+import multiprocessing
+import re
+import signal
+import sys
+import time
+import egret_ext
+from concurrent.futures import ProcessPoolExecutor
+from concurrent.futures.process import BrokenProcessPool
+from optparse import OptionParser
+
+# every ASCII character is also classified on its own since the generated strings
+# rarely contain control characters
+probeStrings = [ chr(c) for c in range(128) ]
+
+# Python constructs that std::regex rejects or reads differently
+stdUnsupported = re.compile(r"\(\?|\\[AZ0-9]|\{,|\[:|\[\^?\]")
+
+class Timeout(Exception):
+    pass
+
+def raise_timeout(signum, frame):
+    raise Timeout()
+
+def std_compatible(regexStr):
+    return stdUnsupported.search(regexStr) == None
+
+# std::regex reads bytes, '.' does not match '\r', '$' does not match before a
+# final newline, and '\s' does not match the separators \x1c-\x1f
+def std_comparable(testStr):
+    return all(ord(c) < 128 and not 0x1c <= ord(c) <= 0x1f for c in testStr) and \
+        '\n' not in testStr and '\r' not in testStr
+
+def verdict_str(accepted):
+    if accepted:
+        return "ACCEPT"
+    else:
+        return "REJECT"
+
+def new_counts():
+    return { 'regexes': 1, 'strings': 0, 'undecided': 0, 'stdStrings': 0,
+             'stdSkipped': 0, 'groups': 0, 'skipped': 0, 'timeouts': 0,
+             'errors': 0, 'disagreements': 0 }
+
+# Checks the strings of one regex.  Returns (counts, reports, error) where error
+# is None unless the check raised an exception.
+def check_regex(args):
+    counts = new_counts()
+    try:
+        reports = check_strings(args, counts)
+    except Exception as e:
+        signal.alarm(0)
+        counts['errors'] = 1
+        return (counts, [], "%s: %s" % (type(e).__name__, e))
+    counts['disagreements'] = len(reports)
+    return (counts, reports, None)
+
+# Checks the strings of one regex and updates the counts.  Returns the reports.
+def check_strings(args, counts):
+    (regexStr, baseSubstring, timeout) = args
+    reports = []
+
+    try:
+        regex = re.compile(regexStr)
+    except re.error:
+        counts['skipped'] = 1
+        return reports
+
+    (alerts, matches, nonMatches, undecided, groups) = \
+      egret_ext.run_match(regexStr, baseSubstring, probeStrings, False, False, False)
+    if len(alerts) > 0 and alerts[0][0:5] == "ERROR":
+        counts['skipped'] = 1
+        return reports
+
+    testStrings = matches + nonMatches + undecided
+    native = {}
+    for testStr in matches:
+        native[testStr] = True
+    for testStr in nonMatches:
+        native[testStr] = False
+
+    # std::regex classifies every string it can compare in one call (it skips
+    # long strings and regexes with large repeat counts)
+    std = {}
+    if std_compatible(regexStr):
+        stdStrings = [ s for s in testStrings if std_comparable(s) ]
+        stdVerdicts = egret_ext.std_match(regexStr, stdStrings)
+        if stdVerdicts == None:
+            counts['stdSkipped'] += len(stdStrings)
+        else:
+            for (testStr, verdict) in zip(stdStrings, stdVerdicts):
+                if verdict == None:
+                    counts['stdSkipped'] += 1
+                else:
+                    std[testStr] = verdict
+
+    groupMap = {}
+    for (matchStr, g) in zip(matches, groups):
+        if g != None:
+            groupMap[matchStr] = g
+
+    # Python re can take exponential time on evil strings
+    signal.alarm(timeout)
+    try:
+        for testStr in testStrings:
+            counts['strings'] += 1
+            search = regex.fullmatch(testStr)
+            expected = search != None
+
+            if testStr in native:
+                if native[testStr] != expected:
+                    reports.append((regexStr, testStr, "native",
+                        verdict_str(native[testStr]), verdict_str(expected)))
+            else:
+                counts['undecided'] += 1
+
+            if testStr in std:
+                counts['stdStrings'] += 1
+                if std[testStr] != expected:
+                    reports.append((regexStr, testStr, "std::regex",
+                        verdict_str(std[testStr]), verdict_str(expected)))
+
+            if search and testStr in groupMap:
+                counts['groups'] += 1
+                if groupMap[testStr] != search.groups():
+                    reports.append((regexStr, testStr, "groups",
+                        str(groupMap[testStr]), str(search.groups())))
+    except Timeout:
+        counts['timeouts'] = 1
+    signal.alarm(0)
+
+    return reports
+
+def init_worker():
+    signal.signal(signal.SIGALRM, raise_timeout)
+
+# Checks the regexes in worker processes and returns the results in order.  When a
+# worker dies, the pool is broken and the checks it did not finish are retried
+# one at a time in a new pool, so only the regex that kills its worker fails.
+def check_all(work, jobs):
+    results = []
+    retry = []
+    with ProcessPoolExecutor(jobs, initializer = init_worker) as executor:
+        futures = [ executor.submit(check_regex, w) for w in work ]
+        for (w, future) in zip(work, futures):
+            try:
+                results.append(future.result())
+            except BrokenProcessPool:
+                results.append(None)
+                retry.append(len(results) - 1)
+    for i in retry:
+        try:
+            with ProcessPoolExecutor(1, initializer = init_worker) as executor:
+                results[i] = executor.submit(check_regex, work[i]).result()
+        except BrokenProcessPool:
+            counts = new_counts()
+            counts['errors'] = 1
+            results[i] = (counts, [], "worker process died")
+    return results
+
+parser = OptionParser(usage = "usage: %prog [options] [corpus ...]")
+parser.add_option("-r", "--regex", dest = "regex", help = "regular expression")
+parser.add_option("-b", "--base_substring", dest = "baseSubstring",
+    default = "evil", help = "base substring for regex strings")
+parser.add_option("-j", "--jobs", dest = "jobs", type = "int",
+    default = multiprocessing.cpu_count(), help = "number of worker processes")
+parser.add_option("-t", "--timeout", dest = "timeout", type = "int",
+    default = 10, help = "seconds allowed for Python re on each regex")
+opts, args = parser.parse_args()
+
+# read the regexes (one per line)
+regexes = []
+if opts.regex != None:
+    regexes.append(opts.regex)
+for fileName in args:
+    with open(fileName) as inFile:
+        for line in inFile:
+            line = line.rstrip('\n')
+            if line != "":
+                regexes.append(line)
+if len(regexes) == 0:
+    parser.error("no regular expressions given")
+
+startTime = time.time()
+totals = {}
+work = [ (r, opts.baseSubstring, opts.timeout) for r in regexes ]
+for (w, (counts, reports, error)) in zip(work, check_all(work, opts.jobs)):
+    for key in counts:
+        totals[key] = totals.get(key, 0) + counts[key]
+    for (regexStr, testStr, backend, got, expected) in reports:
+        print("DISAGREE %s: regex %r string %r: %s (Python re: %s)" %
+            (backend, regexStr, testStr, got, expected))
+    if error != None:
+        print("ERROR: regex %r: %s" % (w[0], error))
+elapsedTime = time.time() - startTime
+
+print("Regexes: %d (skipped %d, timed out %d, errors %d)" %
+    (totals['regexes'], totals['skipped'], totals['timeouts'], totals['errors']))
+print("Strings: %d (native undecided %d, std::regex compared %d, std::regex skipped %d, groups compared %d)" %
+    (totals['strings'], totals['undecided'], totals['stdStrings'], totals['stdSkipped'],
+     totals['groups']))
+print("Disagreements: %d" % totals['disagreements'])
+print("Time: %.2f seconds" % elapsedTime)
+
+if totals['disagreements'] > 0 or totals['errors'] > 0:
+    sys.exit(1)
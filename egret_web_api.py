@@ -26,43 +26,60 @@ def run_egret(regexStr, baseSubstring, testList):
         regex = re.compile(regexStr)
     except re.error as e:
         status = "ERROR (compiler error): Regular expression did not compile: " + str(e)
-        return ([], [], status, [])
+        return ([], [], status, [], {})
         
-    inputStrs = egret_ext.run(regexStr, baseSubstring, False, True, False, False)
+    # generated strings and test list are classified by the engine
+    (alerts, matches, nonMatches, undecided, groups) = \
+      egret_ext.run_match(regexStr, baseSubstring, list(testList), True, False, False)
 
-    idx = 0
-    line = inputStrs[idx]
-    if line[0:5] == "ERROR":
-        return ([], [], line, [])
+    return egret_results(regex, alerts, matches, nonMatches, undecided, groups)
 
-    while line != "BEGIN":
-      idx += 1;
-      line = inputStrs[idx]
+# Runs both EGRET and ACRE with one run of the engine.  Returns the results of
+# run_egret and run_acre.
+def run_egret_acre(regexStr, baseSubstring, testList):
+    # ACRE examples always use the default base substring
+    if baseSubstring != "evil":
+        return (run_egret(regexStr, baseSubstring, testList), run_acre(regexStr))
 
-    if idx == 0:
-      alerts = []
-      inputStrs = inputStrs[1:]
-    else:
-      alerts = inputStrs[:idx]
-      inputStrs = inputStrs[idx+1:]
+    try:
+        regex = re.compile(regexStr)
+    except re.error as e:
+        status = "ERROR (compiler error): Regular expression did not compile: " + str(e)
+        return (([], [], status, [], {}), (None, status))
+
+    (checkAlerts, alerts, matches, nonMatches, undecided, groups) = \
+      egret_ext.run_check_match(regexStr, baseSubstring, list(testList), True, False, False)
+
+    return (egret_results(regex, alerts, matches, nonMatches, undecided, groups),
+        acre_results(regexStr, checkAlerts))
+
+# Converts the engine results for run_egret
+def egret_results(regex, alerts, matches, nonMatches, undecided, groups):
+    if len(alerts) > 0 and alerts[0][0:5] == "ERROR":
+        return ([], [], alerts[0], [], {})
+
+    # groups found by the engine
+    groupMap = {}
+    for (matchStr, g) in zip(matches, groups):
+        if g != None:
+            groupMap[matchStr] = g
 
     warnings = ""
     for a in alerts:
       warnings += a
 
-    matches = []
-    nonMatches = []
-
-    inputStrs = sorted(list(set(inputStrs) | set(testList)))
-    
-    for inputStr in inputStrs:
-        search = regex.fullmatch(inputStr)
-        if search:
-            matches.append(inputStr)
-        else:
-            nonMatches.append(inputStr)
+    # classify any strings the engine could not handle
+    if len(undecided) > 0:
+        for inputStr in undecided:
+            search = regex.fullmatch(inputStr)
+            if search:
+                matches.append(inputStr)
+            else:
+                nonMatches.append(inputStr)
+        matches.sort()
+        nonMatches.sort()
 
-    return (matches, nonMatches, None, warnings)
+    return (matches, nonMatches, None, warnings, groupMap)
 
 # Precondition: regexStr successfully compiles
 def run_test_string(regexStr, testStr):
@@ -73,8 +90,9 @@ def run_test_string(regexStr, testStr):
         return "REJECTED"
 
 # Precondition: regexStr successfully compiles and all strings in testStrings
-# match the regular expression
-def get_group_info(regexStr, testStrings):
+# match the regular expression.  groupMap holds the groups found by the engine
+# (strings without an entry are matched again to get their groups).
+def get_group_info(regexStr, testStrings, groupMap = {}):
     # check for empty list
     if len(testStrings) == 0:
         return (None, None, None)
@@ -83,34 +101,29 @@ def get_group_info(regexStr, testStrings):
     regex = re.compile(regexStr)
 
     # determine if there are named groups, numbered groups, or no groups
-    match = regex.fullmatch(testStrings[0])
-    if len(match.groupdict()) != 0:
+    if len(regex.groupindex) != 0:
         useNames = True
-        names = list(match.groupdict().keys())
-        nameList = []
-        for name in names:
-            r = r"\?P<" + name
-            start = re.search(r, regexStr).start()
-            nameList.append((start, name))
-        nameList = sorted(nameList)
-        groupHdr = [ name for (start, name) in nameList ]
-    elif len(match.groups()) != 0:
+        nameList = sorted([ (num, name) for (name, num) in regex.groupindex.items() ])
+        groupNums = [ num for (num, name) in nameList ]
+        groupHdr = [ name for (num, name) in nameList ]
+    elif regex.groups != 0:
         useNames = False
-        groupHdr = [ str(i) for i in range(0, len(match.groups())) ]
+        groupHdr = [ str(i) for i in range(0, regex.groups) ]
     else:
         return (None, None, None)
 
     # get groups for each string
     groupRows = []
     for testStr in testStrings:
-        match = regex.fullmatch(testStr)
+        groups = groupMap.get(testStr)
+        if groups == None:
+            groups = regex.fullmatch(testStr).groups()
         if useNames:
-            g = match.groupdict()
             row = []
-            for i in groupHdr:
-                row.append(g[i])
+            for num in groupNums:
+                row.append(groups[num - 1])
         else:
-            row = list(match.groups())
+            row = list(groups)
         row.insert(0, testStr)
         groupRows.append(row)
 
@@ -125,7 +138,10 @@ def run_acre(regexStr):
     return (None, errorMsg)
         
   alerts = egret_ext.run(regexStr, "evil", True, True, False, False)
+  return acre_results(regexStr, alerts)
 
+# Converts the checker alerts for run_acre
+def acre_results(regexStr, alerts):
   first_line = alerts[0]
   if first_line[0:5] == "ERROR":
     return (None, first_line)
@@ -0,0 +1,239 @@
+/*  BitMatcher.cpp: Bit-parallel matcher for small regexes
+
+    Copyright (C) 2016-2018  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <bitset>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "BitMatcher.h"
+#include "Matcher.h"
+#include "Stats.h"
+using namespace std;
+
+// Maximum number of words in a position set.
+static const unsigned int MAX_BIT_WORDS = 4;
+
+bool
+BitMatcher::build(Matcher *m)
+{
+  matcher = m;
+  vector <MatchState> &states = matcher->states;
+  vector <bitset <256> > &classes = matcher->classes;
+
+  // collect the positions and the program states where they end
+  vector <unsigned int> targets;
+  vector <int> pos_classes;
+  vector <vector <unsigned int> > leaving(states.size());
+  has_dollar = false;
+  for (unsigned int s = 0; s < states.size(); s++) {
+    vector <MatchEdge>::iterator it;
+    for (it = states[s].edges.begin(); it != states[s].edges.end(); it++) {
+      if (it->type == MATCH_CHAR_SET) {
+        leaving[s].push_back(targets.size());
+        targets.push_back(it->to);
+        pos_classes.push_back(it->index);
+      }
+      if (it->type == MATCH_DOLLAR) has_dollar = true;
+    }
+  }
+
+  if (targets.size() > MAX_BIT_WORDS * 64) {
+    num_positions = 0;
+    return false;
+  }
+  num_positions = targets.size();
+  num_words = num_positions == 0 ? 1 : (num_positions + 63) / 64;
+
+  // character masks
+  char_masks.assign(256 * num_words, 0);
+  for (unsigned int p = 0; p < num_positions; p++) {
+    for (unsigned int c = 0; c < 256; c++) {
+      if (classes[pos_classes[p]][c]) char_masks[c * num_words + p / 64] |= (uint64_t) 1 << (p % 64);
+    }
+  }
+
+  // first positions and the empty string
+  vector <bool> reached;
+  first.assign(num_words, 0);
+  reach(matcher->initial, true, false, reached);
+  for (unsigned int s = 0; s < states.size(); s++) {
+    if (!reached[s]) continue;
+    for (unsigned int i = 0; i < leaving[s].size(); i++) {
+      unsigned int p = leaving[s][i];
+      first[p / 64] |= (uint64_t) 1 << (p % 64);
+    }
+  }
+  reach(matcher->initial, true, true, reached);
+  empty_accept = reached[matcher->final];
+
+  // follow sets and last positions
+  vector <uint64_t> follow(num_positions * num_words, 0);
+  last.assign(num_words, 0);
+  for (unsigned int p = 0; p < num_positions; p++) {
+    reach(targets[p], false, false, reached);
+    for (unsigned int s = 0; s < states.size(); s++) {
+      if (!reached[s]) continue;
+      for (unsigned int i = 0; i < leaving[s].size(); i++) {
+        unsigned int q = leaving[s][i];
+        follow[p * num_words + q / 64] |= (uint64_t) 1 << (q % 64);
+      }
+    }
+    reach(targets[p], false, true, reached);
+    if (reached[matcher->final]) last[p / 64] |= (uint64_t) 1 << (p % 64);
+  }
+
+  // characters that keep each looping position the only active position
+  loop_span.assign(num_positions, -1);
+  loop_spans.clear();
+  for (unsigned int p = 0; p < num_positions; p++) {
+    uint64_t *follow_p = &follow[p * num_words];
+    if (!((follow_p[p / 64] >> (p % 64)) & 1)) continue;
+    bitset <256> chars = classes[pos_classes[p]];
+    for (unsigned int q = 0; q < num_positions; q++) {
+      if (q != p && ((follow_p[q / 64] >> (q % 64)) & 1)) chars &= ~classes[pos_classes[q]];
+    }
+    if (chars.none()) continue;
+    CharSpan span;
+    span.build(chars);
+    loop_span[p] = loop_spans.size();
+    loop_spans.push_back(span);
+  }
+
+  // Each table entry is the union of the follow sets of the positions in
+  // an 8 position chunk.  The entry for a value is built from the entry with
+  // its lowest bit cleared.
+  unsigned int num_chunks = num_words * 8;
+  follow_table.assign(num_chunks * 256 * num_words, 0);
+  for (unsigned int chunk = 0; chunk < num_chunks; chunk++) {
+    for (unsigned int value = 1; value < 256; value++) {
+      unsigned int bit = 0;
+      while (!(value & (1 << bit))) bit++;
+      unsigned int p = chunk * 8 + bit;
+      uint64_t *entry = &follow_table[(chunk * 256 + value) * num_words];
+      uint64_t *prev = &follow_table[(chunk * 256 + (value & (value - 1))) * num_words];
+      for (unsigned int w = 0; w < num_words; w++) {
+        entry[w] = prev[w];
+        if (p < num_positions) entry[w] |= follow[p * num_words + w];
+      }
+    }
+  }
+
+  return true;
+}
+
+void
+BitMatcher::reach(unsigned int state, bool at_start, bool at_end, vector <bool> &reached)
+{
+  vector <MatchState> &states = matcher->states;
+  reached.assign(states.size(), false);
+  vector <unsigned int> stack(1, state);
+
+  while (!stack.empty()) {
+    unsigned int curr = stack.back();
+    stack.pop_back();
+    if (reached[curr]) continue;
+    reached[curr] = true;
+
+    vector <MatchEdge>::iterator it;
+    for (it = states[curr].edges.begin(); it != states[curr].edges.end(); it++) {
+      if (it->type == MATCH_EPSILON || (it->type == MATCH_CARET && at_start) ||
+          ((it->type == MATCH_DOLLAR || it->type == MATCH_END) && at_end)) {
+        stack.push_back(it->to);
+      }
+    }
+  }
+}
+
+bool
+BitMatcher::match(const string &str, bool &accepted)
+{
+  // Dollar can also match before a final newline, which depends on the
+  // position of the character.  Leave these strings to the simulation.
+  if (has_dollar && !str.empty() && str[str.size() - 1] == '\n') return false;
+
+  if (str.empty()) {
+    accepted = empty_accept;
+    return true;
+  }
+
+  uint64_t curr[MAX_BIT_WORDS];
+  uint64_t next[MAX_BIT_WORDS];
+  const uint64_t *mask = &char_masks[(unsigned char) str[0] * num_words];
+  for (unsigned int w = 0; w < num_words; w++) curr[w] = first[w] & mask[w];
+
+  for (unsigned int pos = 1; pos < str.size(); pos++) {
+
+    // skip the characters that keep a looping position the only active position
+    if (!loop_spans.empty()) {
+      int span = find_loop_span(curr);
+      if (span != -1) {
+        unsigned int end = loop_spans[span].find_end(str.data(), pos, str.size());
+        num_span_chars += end - pos;
+        pos = end;
+        if (pos == str.size()) break;
+      }
+    }
+
+    for (unsigned int w = 0; w < num_words; w++) next[w] = 0;
+
+    // union of the follow sets, 8 positions at a time
+    bool active = false;
+    for (unsigned int w = 0; w < num_words; w++) {
+      uint64_t word = curr[w];
+      for (unsigned int chunk = w * 8; word != 0; chunk++, word >>= 8) {
+        unsigned int value = word & 0xff;
+        if (value == 0) continue;
+        const uint64_t *entry = &follow_table[(chunk * 256 + value) * num_words];
+        for (unsigned int i = 0; i < num_words; i++) next[i] |= entry[i];
+        active = true;
+      }
+    }
+    if (!active) break;
+
+    mask = &char_masks[(unsigned char) str[pos] * num_words];
+    for (unsigned int w = 0; w < num_words; w++) curr[w] = next[w] & mask[w];
+  }
+
+  accepted = false;
+  for (unsigned int w = 0; w < num_words; w++) {
+    if (curr[w] & last[w]) accepted = true;
+  }
+  return true;
+}
+
+int
+BitMatcher::find_loop_span(const uint64_t *curr)
+{
+  int position = -1;
+  for (unsigned int w = 0; w < num_words; w++) {
+    if (curr[w] == 0) continue;
+    if (position != -1 || (curr[w] & (curr[w] - 1)) != 0) return -1;
+    position = w * 64 + __builtin_ctzll(curr[w]);
+  }
+  return position == -1 ? -1 : loop_span[position];
+}
+
+void
+BitMatcher::add_stats(Stats &stats)
+{
+  stats.add("MATCHER", "Bit-parallel positions", num_positions);
+  stats.add("MATCHER", "Bit-parallel span characters", num_span_chars);
+}
@@ -0,0 +1,88 @@
+/*  BitMatcher.h: Bit-parallel matcher for small regexes
+
+    Copyright (C) 2016-2018  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// The bit-parallel matcher uses the Glushkov automaton of the matcher
+// program: each character edge of the program is a position, and the set of
+// active positions (the edges that consumed the last character) is kept in a
+// few machine words.  Reading a character is the union of the follow sets of
+// the active positions, intersected with the positions that accept the
+// character.  The follow sets are looked up 8 positions at a time using
+// precomputed tables, so each character only takes a few word operations.
+//
+// A position that follows itself stays the only active position while the
+// characters are in its class but not in the class of the other positions that
+// follow it.  Runs of these characters are skipped with a character span.
+//
+// The matcher is only built for programs with at most MAX_BIT_WORDS * 64
+// positions.
+
+#ifndef BIT_MATCHER_H
+#define BIT_MATCHER_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "CharSpan.h"
+#include "Stats.h"
+using namespace std;
+
+class Matcher;		// breaks a circular dependency Matcher --> BitMatcher --> Matcher
+
+class BitMatcher {
+
+public:
+
+  BitMatcher() { matcher = NULL; num_positions = 0; num_span_chars = 0; }
+
+  // build the matcher for the program of the matcher, returns false if the program is too large
+  bool build(Matcher *m);
+
+  // determines if string is accepted, returns false if the string cannot be decided
+  bool match(const string &str, bool &accepted);
+
+  // add bit-parallel matcher stats
+  void add_stats(Stats &stats);
+
+private:
+
+  Matcher *matcher;			// matcher containing program
+  unsigned int num_positions;		// number of positions (character edges)
+  unsigned int num_words;		// number of words in a position set
+  vector <uint64_t> first;		// positions that can read the first character
+  vector <uint64_t> last;		// positions that can end the string
+  vector <uint64_t> char_masks;		// positions that accept each character
+  vector <uint64_t> follow_table;	// union of follow sets for each 8 position chunk and value
+  bool empty_accept;			// true if the empty string is accepted
+  bool has_dollar;			// true if program contains dollar edges
+  vector <int> loop_span;		// span for each position that can stay active alone (-1 if none)
+  vector <CharSpan> loop_spans;		// characters that keep a looping position active alone
+
+  // stats
+  int num_span_chars;
+
+  // returns the span for the active positions if there is a single looping position (-1 if not)
+  int find_loop_span(const uint64_t *curr);
+
+  // finds the program states reachable from state using empty edges
+  void reach(unsigned int state, bool at_start, bool at_end, vector <bool> &reached);
+};
+
+#endif // BIT_MATCHER_H
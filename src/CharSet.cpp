@@ -21,7 +21,11 @@
 
 #include <algorithm>
 #include <cassert>
+#include <climits>
+#include <cstring>
 #include <iostream>
+#include <map>
+#include <mutex>
 #include <set>
 #include <sstream>
 #include <string>
@@ -31,11 +35,87 @@
 #include "Util.h"
 using namespace std;
 
+// Character class bitmaps (bit c % 64 of word c / 64 is set if c is in the class)
+static constexpr uint64_t DIGIT_CLASS[4] = { 0x03ff000000000000ULL, 0, 0, 0 };
+static constexpr uint64_t WORD_CLASS[4] = { 0x03ff000000000000ULL, 0x07fffffe87fffffeULL, 0, 0 };
+static constexpr uint64_t SPACE_CLASS[4] = { 0x00000001f0003e00ULL, 0, 0, 0 };
+static constexpr uint64_t WILDCARD_CLASS[4] = { ~(1ULL << '\n'), ~0ULL, ~0ULL, ~0ULL };
+
+// Characters in the order get_valid_character prefers them in check mode and for
+// complemented sets in test generation mode
+static const char CHECK_ORDER[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789"
+  "!\"#$%&'*+/:;<=>?@\\^_`~-.{[(}]),| ";
+static const char COMPLEMENT_ORDER[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789"
+  " !\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~";
+
+static void
+add_class(bitset <256> &bits, const uint64_t table[4], bool negate)
+{
+  for (unsigned int c = 0; c < 256; c++) {
+    if (((table[c / 64] >> (c % 64)) & 1) != negate) bits.set(c);
+  }
+}
+
+static void
+set_order(uint64_t order_bits[2], const char *order, const bitset <256> &valid)
+{
+  order_bits[0] = 0;
+  order_bits[1] = 0;
+  for (unsigned int i = 0; order[i] != '\0'; i++) {
+    if (valid.test((unsigned char) order[i])) order_bits[i / 64] |= 1ULL << (i % 64);
+  }
+}
+
+// returns the first valid character in the order other than except (or -1 if none)
+static int
+first_in_order(const uint64_t order_bits[2], const char *order, char except)
+{
+  uint64_t bits[2] = { order_bits[0], order_bits[1] };
+  const char *pos = (except == '\0') ? NULL : strchr(order, except);
+  if (pos != NULL) {
+    unsigned int i = pos - order;
+    bits[i / 64] &= ~(1ULL << (i % 64));
+  }
+  if (bits[0] != 0) return order[__builtin_ctzll(bits[0])];
+  if (bits[1] != 0) return order[64 + __builtin_ctzll(bits[1])];
+  return -1;
+}
+
+// Analysis results for each canonical form, shared by all regexes (and threads).
+// The table is emptied when it reaches MAX_INTERNED forms so it does not grow
+// without bound in a long-running server (character sets keep their results).
+static const unsigned int MAX_INTERNED = 4096;
+static map <string, shared_ptr <CharSetInfo> > interned_info;
+static mutex interned_lock;
+
 // CONSTRUCTION FUNCTIONS
 void
 CharSet::add_item(CharSetItem item)
 {
   items.push_back(item);
+  info.reset();
+}
+
+void
+CharSet::intern()
+{
+  string key = get_canonical_form();
+
+  lock_guard <mutex> guard(interned_lock);
+  map <string, shared_ptr <CharSetInfo> >::iterator it = interned_info.find(key);
+  if (it == interned_info.end()) {
+    if (interned_info.size() >= MAX_INTERNED) interned_info.clear();
+    shared_ptr <CharSetInfo> new_info(new CharSetInfo());
+    new_info->string_candidate = scan_string_candidate();
+    new_info->allows_punc = scan_allows_punctuation();
+    new_info->only_punc = scan_only_punc(false);
+    new_info->only_punc_and_spaces = scan_only_punc(true);
+    new_info->as_string = scan_charset_as_string();
+    scan_bitmaps(*new_info);
+    new_info->disjoint_ranges = scan_disjoint_ranges();
+    it = interned_info.insert(make_pair(key, new_info)).first;
+  }
+  info = it->second;
 }
 
 // PROPERTY FUNCTIONS
@@ -56,6 +136,65 @@ CharSet::is_wildcard()
 
 bool
 CharSet::is_string_candidate()
+{
+  return get_info()->string_candidate;
+}
+
+bool
+CharSet::allows_punctuation()
+{
+  return get_info()->allows_punc;
+}
+
+bool
+CharSet::only_has_punc_and_spaces()
+{
+  return get_info()->only_punc_and_spaces;
+}
+
+string
+CharSet::get_charset_as_string()
+{
+  return get_info()->as_string;
+}
+
+string
+CharSet::get_canonical_form()
+{
+  // The canonical form is the complement flag, the sorted character classes, the
+  // sorted ranges, and the sorted characters (duplicates are kept).
+  string classes;
+  vector <pair <char, char> > ranges;
+  string chars;
+  vector <CharSetItem>::iterator it;
+  for (it = items.begin(); it != items.end(); it++) {
+    switch (it->type) {
+      case CHARACTER_ITEM:
+        chars += it->character;
+        break;
+      case CHAR_CLASS_ITEM:
+        if (classes.find(it->character) == string::npos) classes += it->character;
+        break;
+      case CHAR_RANGE_ITEM:
+        ranges.push_back(make_pair(it->range_start, it->range_end));
+        break;
+    }
+  }
+  sort(classes.begin(), classes.end());
+  sort(ranges.begin(), ranges.end());
+  sort(chars.begin(), chars.end());
+
+  stringstream s;
+  s << (complement ? '^' : '[') << classes << ':' << ranges.size() << ':';
+  for (unsigned int i = 0; i < ranges.size(); i++) {
+    s << ranges[i].first << ranges[i].second;
+  }
+  s << chars;
+  return s.str();
+}
+
+bool
+CharSet::scan_string_candidate()
 {
   // In for order a char set to be a string candidate, one of the
   // following must be true:
@@ -102,7 +241,7 @@ CharSet::is_string_candidate()
 }
 
 bool
-CharSet::allows_punctuation()
+CharSet::scan_allows_punctuation()
 {
   if (complement) return true;
 
@@ -131,13 +270,7 @@ CharSet::allows_punctuation()
 }
 
 bool
-CharSet::only_has_punc_and_spaces()
-{
-  return only_has_punc(true);
-}
-
-bool
-CharSet::only_has_punc(bool allow_spaces)
+CharSet::scan_only_punc(bool allow_spaces)
 {
   vector <CharSetItem>::iterator it;
   if (complement) return false;
@@ -191,96 +324,81 @@ CharSet::only_has_punc(bool allow_spaces)
 }
 
 bool
-CharSet::is_valid_character(char character)
+CharSet::scan_disjoint_ranges()
+{
+  vector <pair <char, char> > ranges;
+  vector <CharSetItem>::iterator it;
+  for (it = items.begin(); it != items.end(); it++) {
+    if (it->type == CHAR_RANGE_ITEM) ranges.push_back(make_pair(it->range_start, it->range_end));
+  }
+  sort(ranges.begin(), ranges.end());
+  for (unsigned int i = 1; i < ranges.size(); i++) {
+    if (ranges[i].first <= ranges[i - 1].second) return false;
+  }
+  return true;
+}
+
+void
+CharSet::scan_bitmaps(CharSetInfo &new_info)
 {
+  bitset <256> members;
+  bitset <256> explicit_chars;
   vector <CharSetItem>::iterator it;
   for (it = items.begin(); it != items.end(); it++) {
     switch (it->type) {
       case CHARACTER_ITEM:
-	if (character == it->character) return !complement;
-	break;
+        members.set((unsigned char) it->character);
+        explicit_chars.set((unsigned char) it->character);
+        break;
       case CHAR_CLASS_ITEM:
         switch (it->character) {
-          case 'w':
-	    if (character >= 'a' && character <= 'z') return !complement; 
-	    if (character >= 'A' && character <= 'Z') return !complement; 
-	    if (character >= '0' && character <= '9') return !complement; 
-	    if (character == '_') return !complement; 
-	    break;
-	  case 'd':
-	    if (character >= '0' && character <= '9') return !complement; 
-	    break;
-	  case 's':
-	    if (character == ' ') return !complement;
-	    break;
-	  case 'W':
-	  {
-	    bool matches_w = false;
-	    if (character >= 'a' && character <= 'z') matches_w = true;
-	    if (character >= 'A' && character <= 'Z') matches_w = true;
-	    if (character >= '0' && character <= '9') matches_w = true;
-	    if (character == '_') matches_w = true;
-	    if (!matches_w) return !complement;
-	    break;
-	  }
-	  case 'D':
-	    if (!(character >= '0' && character <= '9')) return !complement; 
-	    break;
-	  case 'S':
-	    if (character != ' ') return !complement;
-	    break;
-	  case '.':		
-            return !complement;
-	  default:
-	  {
-	    stringstream s;
-	    s << "ERROR (internal): Invalid character class in character set: "
-	      << it->character;
-	    throw EgretException(s.str());
-	  }
-  	}
+          case 'w':	add_class(members, WORD_CLASS, false); break;
+          case 'd':	add_class(members, DIGIT_CLASS, false); break;
+          case 's':	add_class(members, SPACE_CLASS, false); break;
+          case 'W':	add_class(members, WORD_CLASS, true); break;
+          case 'D':	add_class(members, DIGIT_CLASS, true); break;
+          case 'S':	add_class(members, SPACE_CLASS, true); break;
+          case '.':	add_class(members, WILDCARD_CLASS, false); break;
+          default:
+          {
+            stringstream s;
+            s << "ERROR (internal): Invalid character class in character set: "
+              << it->character;
+            throw EgretException(s.str());
+          }
+        }
         break;
-
       case CHAR_RANGE_ITEM:
-        if (character >= it->range_start && character <= it->range_end) return !complement;
+        for (int c = it->range_start; c <= it->range_end; c++) {
+          members.set((unsigned char) c);
+        }
         break;
     }
   }
-  return complement;
-}
-
-bool
-CharSet::has_character_item(char character)
-{
-  if (complement) return false;
-
-  vector <CharSetItem>::iterator it;
-  for (it = items.begin(); it != items.end(); it++) {
-    if (it->type == CHARACTER_ITEM && character == it->character)
-      return true;
-  }
 
-  return false;
+  new_info.valid = complement ? ~members : members;
+  new_info.valid_span.build(new_info.valid);
+  if (!complement) new_info.explicit_chars = explicit_chars;
+  set_order(new_info.check_order, CHECK_ORDER, new_info.valid);
+  set_order(new_info.complement_order, COMPLEMENT_ORDER, new_info.valid);
 }
 
 string
-CharSet::get_charset_as_string()
+CharSet::scan_charset_as_string()
 {
-  vector <CharSetItem>::iterator it;
+  // ranges contribute their endpoints
   string ret = "";
-  vector <CharSetItem> sorted_items = items;
-
-  struct sortClass {
-    bool operator() (CharSetItem x, CharSetItem y) {
-      return (x.character <= y.character);
+  vector <CharSetItem>::iterator it;
+  for (it = items.begin(); it != items.end(); it++) {
+    if (it->type == CHAR_RANGE_ITEM) {
+      ret.push_back(it->range_start);
+      ret.push_back(it->range_end);
+    }
+    else {
+      ret.push_back(it->character);
     }
-  } sortObject;
-  
-  sort(sorted_items.begin(), sorted_items.end(), sortObject);
-
-  for (it = sorted_items.begin(); it != sorted_items.end(); it++) {
-    ret.push_back(it->character);
   }
+  sort(ret.begin(), ret.end());
   
   return ret;
 }
@@ -289,31 +407,11 @@ char
 CharSet::get_valid_character(char except)
 {
   vector <CharSetItem>::iterator it;
-  const char PUNC_ARRAY[32] = { '!', '\"', '#', '$', '%', '&', '\'', '*', '+', '/',
-        ':', ';', '<', '=', '>', '?', '@', '\\', '^', '_', '`', '~', '-', '.',
-        '{', '[', '(', '}', ']', ')', ',', '|'};
-
   if (Util::get()->is_check_mode()) {
     // TODO: The first of the function for test generation could be skipped over or test
     // generation could use this function.
-    for (char c = 'a'; c <= 'z'; c++) {
-      if (except == c) continue;
-      if (is_valid_character(c)) return c;
-    }
-    for (char c = 'A'; c <= 'Z'; c++) {
-      if (except == c) continue;
-      if (is_valid_character(c)) return c;
-    }
-    for (char c = '0'; c <= '9'; c++) {
-      if (except == c) continue;
-      if (is_valid_character(c)) return c;
-    }
-    for (unsigned int i = 0; i < 32; i++) {
-      char c = PUNC_ARRAY[i];
-      if (except == c) continue;
-      if (is_valid_character(c)) return c;
-    }
-    if ((except != ' ') && is_valid_character(' ')) return ' ';
+    int c = first_in_order(get_info()->check_order, CHECK_ORDER, except);
+    if (c != -1) return c;
     // TODO: Refactor this function, can't find a character, go to the test generation algorithm
   }
 
@@ -367,36 +465,8 @@ CharSet::get_valid_character(char except)
   }
 
   // At this point, the character set is complemented. Find the first valid character.
-  for (char c = 'a'; c <= 'z'; c++) {
-    if (except == c) continue;
-    if (is_valid_character(c)) return c;
-  }
-  for (char c = 'A'; c <= 'Z'; c++) {
-    if (except == c) continue;
-    if (is_valid_character(c)) return c;
-  }
-  for (char c = '0'; c <= '9'; c++) {
-    if (except == c) continue;
-    if (is_valid_character(c)) return c;
-  }
-  if ((except != ' ') && is_valid_character(' ')) return ' ';
-
-  for (char c = 33; c <= 47; c++) {
-    if (except == c) continue;
-    if (is_valid_character(c)) return c;
-  }
-  for (char c = 58; c <= 64; c++) {
-    if (except == c) continue;
-    if (is_valid_character(c)) return c;
-  }
-  for (char c = 91; c <= 96; c++) {
-    if (except == c) continue;
-    if (is_valid_character(c)) return c;
-  }
-  for (char c = 123; c <= 126; c++) {
-    if (except == c) continue;
-    if (is_valid_character(c)) return c;
-  }
+  int c = first_in_order(get_info()->complement_order, COMPLEMENT_ORDER, except);
+  if (c != -1) return c;
 
   throw EgretException("ERROR (internal): Could not valid character in char set");
 }
@@ -962,26 +1032,50 @@ CharSet::replace_charset_with_parens(Location loc)
 // TEST GENERATION FUNCTIONS
 
 vector <string>
-CharSet::gen_evil_strings(string test_string, const set <char> &punct_marks)
+CharSet::gen_evil_strings(string test_string, const set <char> &punct_marks,
+    vector <bool> &valid)
 {
-  set <char> test_chars  = create_test_chars(punct_marks);
+  bitset <256> test_chars = get_test_chars(punct_marks);
   string suffix = test_string.substr(prefix.size() + 1);
   vector <string> evil_strings;
 
-  set <char>::iterator cs;
-  for (cs = test_chars.begin(); cs != test_chars.end(); cs++) {
+  // the test characters are visited in char order
+  for (int i = CHAR_MIN; i <= CHAR_MAX; i++) {
+    char c = i;
+    if (!test_chars[(unsigned char) c]) continue;
     string new_string = prefix;
-    new_string += *cs;
+    new_string += c;
     new_string += suffix;
     evil_strings.push_back(new_string);
+    valid.push_back(is_valid_character(c));
   }
   return evil_strings;
 }
 
-set <char>
+bitset <256>
+CharSet::get_test_chars(const set <char> &punct_marks)
+{
+  // overlapping ranges are rare, and their test characters depend on the item order
+  CharSetInfo *set_info = get_info();
+  if (!set_info->disjoint_ranges) return create_test_chars(punct_marks);
+
+  string key(punct_marks.begin(), punct_marks.end());
+  {
+    lock_guard <mutex> guard(interned_lock);
+    map <string, bitset <256> >::iterator it = set_info->test_chars.find(key);
+    if (it != set_info->test_chars.end()) return it->second;
+  }
+
+  bitset <256> test_chars = create_test_chars(punct_marks);
+  lock_guard <mutex> guard(interned_lock);
+  set_info->test_chars[key] = test_chars;
+  return test_chars;
+}
+
+bitset <256>
 CharSet::create_test_chars(const set<char> &punct_marks)
 {
-  set <char> test_chars;
+  bitset <256> test_chars;
   bool lowercase_flag = false;
   bool uppercase_flag = false;
   bool digit_flag = false;
@@ -1005,7 +1099,7 @@ CharSet::create_test_chars(const set<char> &punct_marks)
   for (it = items.begin(); it != items.end(); it++) {
     if (it->type == CHARACTER_ITEM) {
       char c = it->character;
-      test_chars.insert(c);
+      test_chars.set((unsigned char) c);
 
       // Set flags properly
       if (islower(c)) {
@@ -1035,7 +1129,7 @@ CharSet::create_test_chars(const set<char> &punct_marks)
 	bool found_letter = false;
 	for (char c = start; c <= end; c++) {
 	  if (found_letter == false && lowercase[c - 'a'] == false) {
-	    test_chars.insert(c);
+	    test_chars.set((unsigned char) c);
 	    found_letter = true;
 	  }
 	  lowercase[c - 'a'] = true;
@@ -1048,7 +1142,7 @@ CharSet::create_test_chars(const set<char> &punct_marks)
 	bool found_letter = false;
 	for (char c = start; c <= end; c++) {
 	  if (found_letter == false && uppercase[c - 'A'] == false) {
-	    test_chars.insert(c);
+	    test_chars.set((unsigned char) c);
 	    found_letter = true;
 	  }
 	  uppercase[c - 'A'] = true;
@@ -1061,7 +1155,7 @@ CharSet::create_test_chars(const set<char> &punct_marks)
 	bool found_letter = false;
 	for (char c = start; c <= end; c++) {
 	  if (found_letter == false && digits[c - '0'] == false) {
-	    test_chars.insert(c);
+	    test_chars.set((unsigned char) c);
 	    found_letter = true;
 	  }
 	  digits[c - '0'] = true;
@@ -1085,7 +1179,7 @@ CharSet::create_test_chars(const set<char> &punct_marks)
 	  uppercase_flag = true;
 	  lowercase_flag = true;
 	  digit_flag = true;
-	  test_chars.insert('_');
+	  test_chars.set('_');
 	  break;
 
 	// \d - add digit
@@ -1095,7 +1189,7 @@ CharSet::create_test_chars(const set<char> &punct_marks)
 
         // \s - add space
         case 's':
-	  test_chars.insert(' ');
+	  test_chars.set(' ');
 	  break;
 
         // \W, \D, \S - add digit, lowercase, uppercase, '_', space, and punctuation
@@ -1106,8 +1200,8 @@ CharSet::create_test_chars(const set<char> &punct_marks)
 	  lowercase_flag = true;
 	  digit_flag = true;
 	  punct_flag = true;
-	  test_chars.insert('_');
-	  test_chars.insert(' ');
+	  test_chars.set('_');
+	  test_chars.set(' ');
 	  break;
 
 	// . (wildcard) - add digit, lowercase, space, and punctuation
@@ -1116,7 +1210,7 @@ CharSet::create_test_chars(const set<char> &punct_marks)
 	  lowercase_flag = true;
 	  digit_flag = true;
 	  punct_flag = true;
-	  test_chars.insert(' ');
+	  test_chars.set(' ');
 	  break;
 
 	default:
@@ -1136,14 +1230,14 @@ CharSet::create_test_chars(const set<char> &punct_marks)
     lowercase_flag = true;
     digit_flag = true;
     punct_flag = true;
-    test_chars.insert(' ');
+    test_chars.set(' ');
   }
 
   // If lowercase is flagged, then add one more lower case letter.
   if (lowercase_flag) {
     for (char c = 'a'; c <= 'z'; c++)  {
       if (lowercase[c - 'a'] == false)  {
-	test_chars.insert(c);
+	test_chars.set((unsigned char) c);
 	break;
       }
     }
@@ -1153,7 +1247,7 @@ CharSet::create_test_chars(const set<char> &punct_marks)
   if (uppercase_flag) {
     for (char c = 'A'; c <= 'Z'; c++)  {
       if (uppercase[c - 'A'] == false)  {
-	test_chars.insert(c);
+	test_chars.set((unsigned char) c);
 	break;
       }
     }
@@ -1163,7 +1257,7 @@ CharSet::create_test_chars(const set<char> &punct_marks)
   if (digit_flag) {
     for (char c = '0'; c <= '9'; c++)  {
       if (digits[c - '0'] == false)  {
-	test_chars.insert(c);
+	test_chars.set((unsigned char) c);
 	break;
       }
     }
@@ -1174,12 +1268,12 @@ CharSet::create_test_chars(const set<char> &punct_marks)
   if (punct_flag) {
     set<char>::iterator si;
     for (si = punct_marks.begin(); si != punct_marks.end(); si++) {
-      test_chars.insert(*si);
+      test_chars.set((unsigned char) *si);
     }
 
     // if no punctuation marks, add underscore
     if (punct_marks.empty()) {
-      test_chars.insert('_');
+      test_chars.set('_');
     }
   }
 
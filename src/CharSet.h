@@ -22,9 +22,14 @@
 #ifndef CHARSET_H
 #define CHARSET_H
 
+#include <bitset>
+#include <cstdint>
+#include <map>
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
+#include "CharSpan.h"
 #include "Util.h"
 using namespace std;
 
@@ -45,6 +50,25 @@ struct CharSetItem
   char range_end;	// for CHAR_RANGE_ITEM
 };
 
+// Analysis results shared by every character set with the same canonical form
+struct CharSetInfo
+{
+  bool string_candidate;	// character set is a string candidate
+  bool allows_punc;		// character set allows punctuation
+  bool only_punc;		// character set only has punctuation
+  bool only_punc_and_spaces;	// character set only has punctuation and spaces
+  string as_string;		// character set as a sorted string
+  bitset <256> valid;		// valid characters (complement applied)
+  CharSpan valid_span;		// finds runs of valid characters
+  bitset <256> explicit_chars;	// explicit characters (empty if complemented)
+  uint64_t check_order[2];	// valid characters in check mode preference order
+  uint64_t complement_order[2];	// valid characters in complemented set preference order
+  bool disjoint_ranges;		// true if no ranges overlap (test characters do not
+				// depend on the order of the ranges)
+  map <string, bitset <256> > test_chars;	// test characters for each set of punctuation
+						// marks (guarded by the interning lock)
+};
+
 class CharSet {
 
 public:
@@ -53,7 +77,7 @@ public:
 
   // setters
   void set_prefix(string p) { prefix = p; }
-  void set_complement(bool c) { complement = c; }
+  void set_complement(bool c) { complement = c; info.reset(); }
 
   // getters
   bool is_complement() { return complement; }
@@ -63,6 +87,10 @@ public:
   // add an item to the character set
   void add_item(CharSetItem item);
 
+  // finds the analysis results shared by identical character sets (called once the
+  // set is complete, since the results are read by checker threads)
+  void intern();
+
   // PROPERTY FUNCTIONS
 
   // returns true if character set is a single character
@@ -81,10 +109,19 @@ public:
   bool only_has_punc_and_spaces();
 
   // determines if a character is valid 
-  bool is_valid_character(char character);
+  bool is_valid_character(char character)
+    { return get_info()->valid.test((unsigned char) character); }
 
   // returns true if character is explicitly part of non-negated character set
-  bool has_character_item(char character);
+  bool has_character_item(char character)
+    { return get_info()->explicit_chars.test((unsigned char) character); }
+
+  // returns true if every character of the string is valid
+  bool is_valid_string(const string &str)
+    { return get_info()->valid_span.find_end(str.data(), 0, str.size()) == str.size(); }
+
+  // returns the valid characters as a bitmap
+  const bitset <256> &get_bitmap() { return get_info()->valid; }
 
   // returns the character set as a sorted string
   string get_charset_as_string();
@@ -106,8 +143,9 @@ public:
 
   // TEST GENERATION FUNCTIONS
 
-  // generate evil strings
-  vector <string> gen_evil_strings(string test_string, const set <char> &punct_marks);
+  // generate evil strings, valid is set for strings with a valid substituted character
+  vector <string> gen_evil_strings(string test_string, const set <char> &punct_marks,
+      vector <bool> &valid);
 
   // PRINT FUNCTION
 
@@ -120,9 +158,20 @@ private:
   bool complement;		// true if set is complemented
   string prefix;		// path string up to visiting this node
   bool checked;			// true of charset has been checked
+  shared_ptr <CharSetInfo> info;	// interned analysis results (empty if not interned)
+
+  // analysis functions (results are interned)
+  CharSetInfo *get_info() { if (!info) intern(); return info.get(); }
+  string get_canonical_form();
+  bool scan_string_candidate();
+  bool scan_allows_punctuation();
+  bool scan_only_punc(bool allow_spaces);
+  string scan_charset_as_string();
+  void scan_bitmaps(CharSetInfo &info);
+  bool scan_disjoint_ranges();
 
   // checker functions
-  bool only_has_punc(bool allow_spaces = false);
+  bool only_has_punc() { return get_info()->only_punc; }
   bool is_good_range(char start, char end);
   bool has_upper_range();
   bool has_lower_range();
@@ -133,8 +182,11 @@ private:
   void replace(string &str, string from, string to);
   string replace_charset_with_parens(Location loc);
   
+  // returns the test characters, which are shared by identical character sets
+  bitset <256> get_test_chars(const set <char> &punct_marks);
+
   // creates a set of test characters
-  set <char> create_test_chars(const set <char> &punct_marks);
+  bitset <256> create_test_chars(const set <char> &punct_marks);
 };
 
 #endif // CHARSET_H
@@ -0,0 +1,147 @@
+/*  CharSpan.cpp: Finds runs of characters from a set
+
+    Copyright (C) 2016-2018  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <bitset>
+#include <cstddef>
+#include "CharSpan.h"
+using namespace std;
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CHAR_SPAN_X86
+#include <immintrin.h>
+#endif
+
+#ifdef CHAR_SPAN_X86
+
+// Each kernel returns the position of the first character not in the set or
+// the position where fewer than a full vector of characters remain.
+
+__attribute__((target("sse4.2")))
+static size_t
+find_end_sse42(const char *str, size_t pos, size_t size,
+    const unsigned char *low_table, const unsigned char *high_table)
+{
+  const __m128i low = _mm_loadu_si128((const __m128i *) low_table);
+  const __m128i high = _mm_loadu_si128((const __m128i *) high_table);
+  const __m128i bits = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, (char) 128,
+      1, 2, 4, 8, 16, 32, 64, (char) 128);
+  const __m128i nibble = _mm_set1_epi8(0x0f);
+
+  for (; pos + 16 <= size; pos += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *) (str + pos));
+    __m128i lo = _mm_and_si128(v, nibble);
+    __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), nibble);
+    __m128i row = _mm_blendv_epi8(_mm_shuffle_epi8(low, lo), _mm_shuffle_epi8(high, lo), v);
+    __m128i bit = _mm_shuffle_epi8(bits, hi);
+    __m128i missing = _mm_cmpeq_epi8(_mm_and_si128(row, bit), _mm_setzero_si128());
+    unsigned int mask = _mm_movemask_epi8(missing);
+    if (mask != 0) return pos + __builtin_ctz(mask);
+  }
+  return pos;
+}
+
+__attribute__((target("avx2")))
+static size_t
+find_end_avx2(const char *str, size_t pos, size_t size,
+    const unsigned char *low_table, const unsigned char *high_table)
+{
+  const __m256i low = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) low_table));
+  const __m256i high = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) high_table));
+  const __m256i bits = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, (char) 128,
+      1, 2, 4, 8, 16, 32, 64, (char) 128, 1, 2, 4, 8, 16, 32, 64, (char) 128,
+      1, 2, 4, 8, 16, 32, 64, (char) 128);
+  const __m256i nibble = _mm256_set1_epi8(0x0f);
+
+  for (; pos + 32 <= size; pos += 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i *) (str + pos));
+    __m256i lo = _mm256_and_si256(v, nibble);
+    __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble);
+    __m256i row = _mm256_blendv_epi8(_mm256_shuffle_epi8(low, lo), _mm256_shuffle_epi8(high, lo), v);
+    __m256i bit = _mm256_shuffle_epi8(bits, hi);
+    __m256i missing = _mm256_cmpeq_epi8(_mm256_and_si256(row, bit), _mm256_setzero_si256());
+    unsigned int mask = _mm256_movemask_epi8(missing);
+    if (mask != 0) return pos + __builtin_ctz(mask);
+  }
+  return pos;
+}
+
+#endif // CHAR_SPAN_X86
+
+void
+CharSpan::build(const bitset <256> &c)
+{
+  chars = c;
+  for (unsigned int l = 0; l < 16; l++) {
+    low_table[l] = 0;
+    high_table[l] = 0;
+    for (unsigned int h = 0; h < 8; h++) {
+      if (chars[h * 16 + l]) low_table[l] |= 1 << h;
+      if (chars[(h + 8) * 16 + l]) high_table[l] |= 1 << h;
+    }
+  }
+}
+
+size_t
+CharSpan::find_end(const char *str, size_t pos, size_t size, SpanKernel kernel) const
+{
+#ifdef CHAR_SPAN_X86
+  switch (kernel) {
+    case SPAN_AVX2:
+      // the SSE4.2 kernel handles the last 16 to 31 characters
+      pos = find_end_avx2(str, pos, size, low_table, high_table);
+      // fall through
+    case SPAN_SSE42:
+      pos = find_end_sse42(str, pos, size, low_table, high_table);
+      break;
+    case SPAN_SCALAR:
+      break;
+  }
+#endif
+
+  // scalar loop for the characters left by the vector kernels
+  while (pos < size && chars[(unsigned char) str[pos]]) pos++;
+  return pos;
+}
+
+SpanKernel
+CharSpan::best_kernel()
+{
+  static const SpanKernel kernel = is_supported(SPAN_AVX2) ? SPAN_AVX2 :
+    (is_supported(SPAN_SSE42) ? SPAN_SSE42 : SPAN_SCALAR);
+  return kernel;
+}
+
+bool
+CharSpan::is_supported(SpanKernel kernel)
+{
+  switch (kernel) {
+#ifdef CHAR_SPAN_X86
+    case SPAN_AVX2:
+      return __builtin_cpu_supports("avx2");
+    case SPAN_SSE42:
+      return __builtin_cpu_supports("sse4.2");
+#endif
+    case SPAN_SCALAR:
+      return true;
+    default:
+      return false;
+  }
+}
@@ -0,0 +1,73 @@
+/*  CharSpan.h: Finds runs of characters from a set
+
+    Copyright (C) 2016-2018  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// A character span finds the first character of a string that is not in a
+// set.  On x86 processors, 16 (SSE4.2) or 32 (AVX2) characters are tested at
+// a time: the low four bits of each character look up a byte whose bits are
+// the high four bits of the characters in the set (one table for characters
+// below 128 and one for the rest), and the high four bits select the bit to
+// test.  The kernel is chosen once based on the processor, and other
+// processors use the scalar loop.
+
+#ifndef CHAR_SPAN_H
+#define CHAR_SPAN_H
+
+#include <bitset>
+#include <cstddef>
+using namespace std;
+
+typedef enum {
+  SPAN_SCALAR,
+  SPAN_SSE42,
+  SPAN_AVX2
+} SpanKernel;
+
+class CharSpan {
+
+public:
+
+  CharSpan() {}
+
+  // builds the lookup tables for the set of characters
+  void build(const bitset <256> &c);
+
+  // returns the position of the first character at or after pos that is not in
+  // the set (size if every character is in the set)
+  size_t find_end(const char *str, size_t pos, size_t size) const
+    { return find_end(str, pos, size, best_kernel()); }
+
+  // find_end using the given kernel (which must be supported)
+  size_t find_end(const char *str, size_t pos, size_t size, SpanKernel kernel) const;
+
+  // returns the fastest kernel supported by the processor
+  static SpanKernel best_kernel();
+
+  // returns true if the processor supports the kernel
+  static bool is_supported(SpanKernel kernel);
+
+private:
+
+  bitset <256> chars;			// characters in the set
+  unsigned char low_table[16];		// bit h of entry l is set if h * 16 + l is in the set
+  unsigned char high_table[16];		// bit h of entry l is set if (h + 8) * 16 + l is in the set
+};
+
+#endif // CHAR_SPAN_H
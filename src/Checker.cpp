@@ -19,33 +19,84 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <exception>
 #include <iostream>
 #include <set>
 #include <sstream>
+#include <thread>
 #include <vector>
 #include "Checker.h"
 #include "Path.h"
 #include "Util.h"
+#include "egret.h"
 using namespace std;
 
+// Minimum number of paths checked by each worker thread.
+static const unsigned int MIN_PATHS_PER_THREAD = 64;
+
 // Checker
 
 void 
 Checker::check()
 {
-  check_anchor_usage();
-  check_anchor_in_middle();
-  check_charsets();
-  check_optional_braces();
-  check_wild_punctuation();
-  check_repeat_punctuation();
-  check_digit_too_optional();
+  // Check the paths, spread over worker threads when there are many of them.
+  // Each thread checks a contiguous range of paths.
+  results.assign(paths.size(), PathCheck());
+  unsigned int num_threads = thread::hardware_concurrency();
+  if (num_threads > paths.size() / MIN_PATHS_PER_THREAD) {
+    num_threads = paths.size() / MIN_PATHS_PER_THREAD;
+  }
+  if (num_threads <= 1) {
+    check_paths(0, paths.size());
+  }
+  else {
+    vector <thread> workers;
+    vector <exception_ptr> errors(num_threads);
+    Util *util = Util::get();
+    unsigned int chunk = (paths.size() + num_threads - 1) / num_threads;
+    for (unsigned int t = 0; t < num_threads; t++) {
+      unsigned int start = t * chunk;
+      unsigned int end = min(start + chunk, (unsigned int) paths.size());
+      workers.push_back(thread([this, start, end, t, &errors, util]() {
+        Util::share(util);
+        try {
+          check_paths(start, end);
+        }
+        catch (...) {
+          errors[t] = current_exception();
+        }
+      }));
+    }
+    for (unsigned int t = 0; t < num_threads; t++) {
+      workers[t].join();
+    }
+    for (unsigned int t = 0; t < num_threads; t++) {
+      if (errors[t]) rethrow_exception(errors[t]);
+    }
+  }
+
+  // Report the alerts one rule at a time (alerts are only found for the selected rules)
+  if (rules & CHECK_ANCHOR_USAGE) report_anchor_usage();
+  report_anchor_in_middle();
+  report_charsets();
+  for (unsigned int i = 0; i < results.size(); i++) add_alerts(results[i].optional_braces);
+  for (unsigned int i = 0; i < results.size(); i++) add_alerts(results[i].wild_punctuation);
+  for (unsigned int i = 0; i < results.size(); i++) add_alerts(results[i].repeat_punctuation);
+  for (unsigned int i = 0; i < results.size(); i++) add_alerts(results[i].digit_too_optional);
 }
 
-// CHECKER FUNCTIONS
+void
+Checker::check_paths(unsigned int start, unsigned int end)
+{
+  for (unsigned int i = start; i < end; i++) {
+    paths[i].check(results[i], rules);
+  }
+}
+
+// REPORTING FUNCTIONS
 
 void
-Checker::check_anchor_usage()
+Checker::report_anchor_usage()
 {
   bool all_start_with_caret = false;
   bool all_end_with_dollar = false;
@@ -55,27 +106,24 @@ Checker::check_anchor_usage()
   // get end of line marker
   string eol = Util::get()->is_web_mode() ? "<br>" : "\n";
 
-  bool is_first_string = true;
   string first_string;
-  vector <Path>::iterator path_iter;
-  for (path_iter = paths.begin(); path_iter != paths.end(); path_iter++) {
+  for (unsigned int i = 0; i < paths.size(); i++) {
 
     // check for leading carets and trailing dollars
-    bool start_with_caret = path_iter->has_leading_caret();
-    bool end_with_dollar = path_iter->has_trailing_dollar();
+    bool start_with_caret = results[i].leading_caret;
+    bool end_with_dollar = results[i].trailing_dollar;
 
     // for first path, record whether the path starts with ^ and/or ends with $
-    if (is_first_string) {
+    if (i == 0) {
       all_start_with_caret = start_with_caret;
       all_end_with_dollar = end_with_dollar;
-      is_first_string = false;
-      first_string = path_iter->get_test_string();
+      first_string = paths[i].get_test_string();
     }
 
     // print warning (but only for first occurrence of each anchor)
     if (!warn_caret_start) {
       if (all_start_with_caret && !start_with_caret) {
-	string curr_string = path_iter->get_test_string();
+	string curr_string = paths[i].get_test_string();
 
         stringstream s;
         s << "Some but not all strings start with a ^ anchor" << eol;
@@ -86,7 +134,7 @@ Checker::check_anchor_usage()
         warn_caret_start = true;
       }
       if (!all_start_with_caret && start_with_caret) {
-	string curr_string = path_iter->get_test_string();
+	string curr_string = paths[i].get_test_string();
 
         stringstream s;
         s << "Some but not all strings start with a ^ anchor" << eol;
@@ -99,7 +147,7 @@ Checker::check_anchor_usage()
     }
     if (!warn_dollar_end) {
       if (all_end_with_dollar && !end_with_dollar) {
-	string curr_string = path_iter->get_test_string();
+	string curr_string = paths[i].get_test_string();
 
         stringstream s;
         s << "Some but not all strings end with a $ anchor" << eol;
@@ -110,7 +158,7 @@ Checker::check_anchor_usage()
         warn_dollar_end = true;
       }
       if (!all_end_with_dollar && end_with_dollar) {
-	string curr_string = path_iter->get_test_string();
+	string curr_string = paths[i].get_test_string();
 
         stringstream s;
         s << "Some but not all strings end with a $ anchor" << eol;
@@ -125,56 +173,35 @@ Checker::check_anchor_usage()
 }
 
 void
-Checker::check_anchor_in_middle()
-{
-  vector <Path>::iterator path_iter;
-  for (path_iter = paths.begin(); path_iter != paths.end(); path_iter++) {
-    if (path_iter->check_anchor_in_middle()) return;
-  }
-}
-
-void
-Checker::check_charsets()
-{
-  vector <Path>::iterator path_iter;
-  for (path_iter = paths.begin(); path_iter != paths.end(); path_iter++) {
-    path_iter->check_charsets();
-  }
-}
-
-void
-Checker::check_optional_braces()
+Checker::report_anchor_in_middle()
 {
-  vector <Path>::iterator path_iter;
-  for (path_iter = paths.begin(); path_iter != paths.end(); path_iter++) {
-    path_iter->check_optional_braces();
-  }
-}
-
-void
-Checker::check_wild_punctuation()
-{
-  vector <Path>::iterator path_iter;
-  for (path_iter = paths.begin(); path_iter != paths.end(); path_iter++) {
-    path_iter->check_wild_punctuation();
+  for (unsigned int i = 0; i < results.size(); i++) {
+    if (!results[i].anchor_middle.empty()) {
+      add_alerts(results[i].anchor_middle);
+      return;
+    }
   }
 }
 
 void
-Checker::check_repeat_punctuation()
+Checker::report_charsets()
 {
-  vector <Path>::iterator path_iter;
-  for (path_iter = paths.begin(); path_iter != paths.end(); path_iter++) {
-    path_iter->check_repeat_punctuation();
+  // each character set is checked once (by the first path that contains it)
+  for (unsigned int i = 0; i < results.size(); i++) {
+    vector <CharSetCheck>::iterator it;
+    for (it = results[i].charsets.begin(); it != results[i].charsets.end(); it++) {
+      if (rules & CHECK_CHARSET) it->charset->check(&paths[i], it->loc);
+      add_alerts(it->duplicates);
+    }
   }
 }
 
 void
-Checker::check_digit_too_optional()
+Checker::add_alerts(vector <Alert> &alerts)
 {
-  vector <Path>::iterator path_iter;
-  for (path_iter = paths.begin(); path_iter != paths.end(); path_iter++) {
-    path_iter->check_digit_too_optional();
+  vector <Alert>::iterator it;
+  for (it = alerts.begin(); it != alerts.end(); it++) {
+    Util::get()->add_alert(*it);
   }
 }
 
@@ -186,9 +213,9 @@ Checker::fix_anchors()
 
   vector <Token>::iterator vi;
   for (vi = tokens.begin(); vi != tokens.end(); vi++) {
-    TokenType type = vi->type;
+    TokenType type = vi->get_type();
     if (type == CARET || type == DOLLAR) continue;
-    for (int i = vi->loc.first; i <= vi->loc.second; i++) {
+    for (unsigned int i = vi->start; i <= vi->end; i++) {
       new_regex += regex[i];
     }
   }
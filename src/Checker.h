@@ -22,7 +22,6 @@
 #ifndef CHECKER_H
 #define CHECKER_H
 
-#include <set>
 #include <string>
 #include <vector>
 #include "Scanner.h"
@@ -33,41 +32,36 @@ class Checker {
 
 public:
 
-  Checker(vector <Path> p, vector <Token> t) {
-    paths = p;
-    tokens = t;
-  }
+  // the paths (already processed) and tokens are used in place, not copied, only
+  // the rules in the rule mask are checked
+  Checker(vector <Path> &p, vector <Token> &t, unsigned int r) : paths(p), tokens(t), rules(r) {}
 
   // checker entry point
   void check();
 
 private:
 
-  vector <Path> paths;		// list of paths
-  vector <Token> tokens;        // set of tokens - used for generated fixes
+  vector <Path> &paths;		// list of paths
+  vector <Token> &tokens;       // set of tokens - used for generated fixes
+  unsigned int rules;		// rule mask (CheckRule values)
+  vector <PathCheck> results;	// results of checking each path
 
-  // CHECKER FUNCTIONS
+  // checks paths start to end - 1 (run by each worker thread)
+  void check_paths(unsigned int start, unsigned int end);
 
-  // check anchor usage
-  void check_anchor_usage();
+  // REPORTING FUNCTIONS (report the alerts of each rule in path order)
 
-  // check anchor in middle
-  void check_anchor_in_middle();
+  // report anchor usage
+  void report_anchor_usage();
 
-  // check chararacter sets
-  void check_charsets();
+  // report anchor in middle (only the first one)
+  void report_anchor_in_middle();
 
-  // check optional braces
-  void check_optional_braces();
+  // check character sets and report them along with duplicate punctuation sets
+  void report_charsets();
 
-  // checks if wildcard is just before/after punctuation mark
-  void check_wild_punctuation();
-
-  // checks if punctuation can be repeated in certain situations
-  void check_repeat_punctuation();
-
-   // checks if digits are too optional
-   void check_digit_too_optional();
+  // adds alerts found for a rule
+  void add_alerts(vector <Alert> &alerts);
 
   // fix anchors
   string fix_anchors();
@@ -0,0 +1,309 @@
+/*  CodeGenerator.cpp: Generates C++ source code for a regex matcher
+
+    Copyright (C) 2016-2018  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "CodeGenerator.h"
+#include "DFA.h"
+#include "Matcher.h"
+#include "Stats.h"
+#include "Util.h"
+using namespace std;
+
+void
+CodeGenerator::build(Matcher *m)
+{
+  matcher = m;
+
+  if (!matcher->is_supported()) {
+    throw EgretException("ERROR (codegen): Regex contains elements that cannot be compiled into a matcher");
+  }
+  if (matcher->has_backreferences()) {
+    throw EgretException("ERROR (codegen): Regex contains backreferences which cannot be compiled into a matcher");
+  }
+
+  dfa.build(matcher);
+  if (!dfa.build_all()) {
+    throw EgretException("ERROR (codegen): Matcher for regex is too large");
+  }
+}
+
+string
+CodeGenerator::gen_function(string name, string regex)
+{
+  ostringstream out;
+  unsigned int num_states = dfa.dfa_states.size();
+
+  // the regex is written as a string literal so a final backslash or a newline
+  // cannot end or continue the comment
+  out << "// Matcher generated by EGRET for the regular expression:" << endl;
+  out << "//   " << string_literal(regex) << endl;
+  out << endl;
+  out << "#include <string>" << endl;
+  out << endl;
+  out << "bool" << endl;
+  out << name << "(const std::string &str)" << endl;
+  out << "{" << endl;
+  out << "  int state = 0;" << endl;
+  out << "  for (std::string::size_type pos = 0; pos < str.size(); pos++) {" << endl;
+
+  // states without program states reject the string, the other states
+  // (always including the start state) are numbered in order
+  vector <int> numbers(num_states, -1);
+  int num_live = 0;
+  for (unsigned int state = 0; state < num_states; state++) {
+    if (state == 0 || !dfa.dfa_states[state].prog_states.empty()) numbers[state] = num_live++;
+  }
+
+  // states where a dollar can match before a final newline
+  vector <int> newline_states;
+  for (unsigned int state = 0; state < num_states; state++) {
+    if (numbers[state] != -1 && dfa.accepts_final_newline(state)) newline_states.push_back(numbers[state]);
+  }
+
+  // one case per state, the character is only declared if a condition tests it
+  ostringstream cases;
+  bool uses_char = !newline_states.empty();
+  cases << "    switch (state) {" << endl;
+  for (unsigned int state = 0; state < num_states; state++) {
+    if (numbers[state] == -1) continue;
+    cases << "      case " << numbers[state] << ":" << endl;
+
+    map <int, vector <bool> > targets;
+    for (unsigned int c = 0; c < 256; c++) {
+      int target = numbers[dfa.transitions[state * dfa.num_byte_classes + dfa.byte_class[c]]];
+      if (target == -1) continue;
+      if (targets.find(target) == targets.end()) targets[target] = vector <bool>(256, false);
+      targets[target][c] = true;
+    }
+
+    map <int, vector <bool> >::iterator it;
+    for (it = targets.begin(); it != targets.end(); it++) {
+      string condition = gen_condition(it->second);
+      if (condition != "true") uses_char = true;
+      cases << "        if (" << condition << ") {" << endl;
+      cases << "          state = " << it->first << ";" << endl;
+      cases << "          break;" << endl;
+      cases << "        }" << endl;
+    }
+    cases << "        return false;" << endl;
+  }
+  cases << "    }" << endl;
+
+  if (uses_char) out << "    unsigned char c = str[pos];" << endl;
+  if (!newline_states.empty()) {
+    out << endl;
+    out << "    // dollar matches before a final newline" << endl;
+    out << "    if (c == '\\n' && pos + 1 == str.size()) {" << endl;
+    out << "      switch (state) {" << endl;
+    for (unsigned int i = 0; i < newline_states.size(); i++) {
+      out << "        case " << newline_states[i] << ":" << endl;
+    }
+    out << "          return true;" << endl;
+    out << "      }" << endl;
+    out << "    }" << endl;
+    out << endl;
+  }
+
+  out << cases.str();
+  out << "  }" << endl;
+  out << endl;
+
+  // accepting states
+  vector <int> accept_states;
+  for (unsigned int state = 0; state < num_states; state++) {
+    if (numbers[state] != -1 && !dfa.get_accepting(state).empty()) accept_states.push_back(numbers[state]);
+  }
+  if (accept_states.empty()) {
+    out << "  return false;" << endl;
+  }
+  else {
+    out << "  switch (state) {" << endl;
+    for (unsigned int i = 0; i < accept_states.size(); i++) {
+      out << "    case " << accept_states[i] << ":" << endl;
+    }
+    out << "      return true;" << endl;
+    out << "    default:" << endl;
+    out << "      return false;" << endl;
+    out << "  }" << endl;
+  }
+  out << "}" << endl;
+
+  return out.str();
+}
+
+string
+CodeGenerator::gen_test(string name, const vector <string> &strings,
+    const vector <MatchVerdict> &verdicts)
+{
+  ostringstream out;
+
+  // the expected verdicts do not come from the DFA: they are known from generating
+  // the strings or found by the backtracking search of the matcher
+  map <string, MatchVerdict> tests;
+  for (unsigned int i = 0; i < strings.size(); i++) {
+    if (i < verdicts.size() && verdicts[i] != MATCH_UNKNOWN) tests[strings[i]] = verdicts[i];
+  }
+
+  // the empty string makes sure there is at least one test
+  set <string> test_strings(strings.begin(), strings.end());
+  test_strings.insert("");
+  set <string>::iterator it;
+  for (it = test_strings.begin(); it != test_strings.end(); it++) {
+    if (tests.find(*it) != tests.end()) continue;
+    vector <int> spans;
+    MatchVerdict verdict = matcher->match_groups(*it, spans);
+    if (verdict != MATCH_UNKNOWN) tests[*it] = verdict;
+  }
+
+  out << endl;
+  out << "#ifdef EGRET_MATCHER_TEST" << endl;
+  out << endl;
+  out << "#include <iostream>" << endl;
+  out << endl;
+  out << "// EGRET test strings and their expected verdicts" << endl;
+  out << "static const struct {" << endl;
+  out << "  const char *str;" << endl;
+  out << "  unsigned int length;" << endl;
+  out << "  bool match;" << endl;
+  out << "} tests[] = {" << endl;
+  map <string, MatchVerdict>::iterator test;
+  for (test = tests.begin(); test != tests.end(); test++) {
+    out << "  { " << string_literal(test->first) << ", " << test->first.size() << ", ";
+    out << (test->second == MATCH_ACCEPT ? "true" : "false") << " }," << endl;
+  }
+  out << "};" << endl;
+  out << endl;
+  out << "int" << endl;
+  out << "main()" << endl;
+  out << "{" << endl;
+  out << "  unsigned int num_tests = sizeof(tests) / sizeof(tests[0]);" << endl;
+  out << "  unsigned int failures = 0;" << endl;
+  out << "  for (unsigned int i = 0; i < num_tests; i++) {" << endl;
+  out << "    std::string str(tests[i].str, tests[i].length);" << endl;
+  out << "    if (" << name << "(str) != tests[i].match) {" << endl;
+  out << "      std::cout << \"FAILED: \" << str << std::endl;" << endl;
+  out << "      failures++;" << endl;
+  out << "    }" << endl;
+  out << "  }" << endl;
+  out << "  std::cout << num_tests - failures << \" of \" << num_tests << \" tests passed\" << std::endl;" << endl;
+  out << "  return failures == 0 ? 0 : 1;" << endl;
+  out << "}" << endl;
+  out << endl;
+  out << "#endif // EGRET_MATCHER_TEST" << endl;
+
+  return out.str();
+}
+
+string
+CodeGenerator::gen_condition(const vector <bool> &chars)
+{
+  vector <string> terms;
+  unsigned int c = 0;
+  while (c < 256) {
+    if (!chars[c]) {
+      c++;
+      continue;
+    }
+    unsigned int start = c;
+    while (c < 256 && chars[c]) c++;
+    unsigned int end = c - 1;
+
+    if (start == 0 && end == 255) return "true";
+    // c is unsigned char so 0 and 255 are not tested
+    if (start == end) {
+      terms.push_back("c == " + char_literal(start));
+    }
+    else if (start == 0) {
+      terms.push_back("c <= " + char_literal(end));
+    }
+    else if (end == 255) {
+      terms.push_back("c >= " + char_literal(start));
+    }
+    else {
+      terms.push_back("c >= " + char_literal(start) + " && c <= " + char_literal(end));
+    }
+  }
+
+  if (terms.size() == 1) return terms[0];
+  string condition = "";
+  for (unsigned int i = 0; i < terms.size(); i++) {
+    if (i > 0) condition += " || ";
+    condition += "(" + terms[i] + ")";
+  }
+  return condition;
+}
+
+string
+CodeGenerator::char_literal(unsigned int c)
+{
+  switch (c) {
+    case '\n':
+      return "'\\n'";
+    case '\t':
+      return "'\\t'";
+    case '\r':
+      return "'\\r'";
+    case '\'':
+      return "'\\''";
+    case '\\':
+      return "'\\\\'";
+  }
+  if (c >= 32 && c < 127) return string("'") + (char) c + "'";
+
+  ostringstream out;
+  out << c;
+  return out.str();
+}
+
+string
+CodeGenerator::string_literal(const string &str)
+{
+  string literal = "\"";
+  for (unsigned int i = 0; i < str.size(); i++) {
+    unsigned char c = str[i];
+    if (c == '"' || c == '\\' || c == '?') {
+      literal += '\\';
+      literal += c;
+    }
+    else if (c >= 32 && c < 127) {
+      literal += c;
+    }
+    else {
+      // octal escapes always use three digits so they do not absorb following digits
+      literal += '\\';
+      literal += (char) ('0' + ((c >> 6) & 7));
+      literal += (char) ('0' + ((c >> 3) & 7));
+      literal += (char) ('0' + (c & 7));
+    }
+  }
+  literal += "\"";
+  return literal;
+}
+
+void
+CodeGenerator::add_stats(Stats &stats)
+{
+  stats.add("CODEGEN", "Generated DFA states", dfa.dfa_states.size());
+}
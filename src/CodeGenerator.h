@@ -0,0 +1,75 @@
+/*  CodeGenerator.h: Generates C++ source code for a regex matcher
+
+    Copyright (C) 2016-2018  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// The code generator builds the complete DFA for the matcher program and
+// emits it as a self-contained C++ function: each DFA state is a case of a
+// switch statement and each transition is a test on character ranges.  The
+// test driver checks the generated function on the EGRET test strings and is
+// only compiled when EGRET_MATCHER_TEST is defined.  Its expected verdicts are
+// independent of the DFA: they are known from generating the strings or found
+// by the backtracking search of the matcher.
+
+#ifndef CODE_GENERATOR_H
+#define CODE_GENERATOR_H
+
+#include <string>
+#include <vector>
+#include "DFA.h"
+#include "Matcher.h"
+#include "Stats.h"
+using namespace std;
+
+class CodeGenerator {
+
+public:
+
+  CodeGenerator() { matcher = NULL; }
+
+  // build the complete DFA for the matcher
+  void build(Matcher *m);
+
+  // returns the source code of a function that matches the regex
+  string gen_function(string name, string regex);
+
+  // returns the source code of a test driver for the strings (verdicts are the
+  // ones known from generating the strings)
+  string gen_test(string name, const vector <string> &strings,
+      const vector <MatchVerdict> &verdicts);
+
+  // add code generator stats
+  void add_stats(Stats &stats);
+
+private:
+
+  Matcher *matcher;	// matcher for the regex
+  DFA dfa;		// complete DFA
+
+  // returns the C++ condition that tests if c is in the characters
+  string gen_condition(const vector <bool> &chars);
+
+  // returns a C++ character literal
+  string char_literal(unsigned int c);
+
+  // returns a C++ string literal
+  string string_literal(const string &str);
+};
+
+#endif // CODE_GENERATOR_H
@@ -0,0 +1,335 @@
+/*  DFA.cpp: Lazily constructed DFA used to classify test strings
+
+    Copyright (C) 2016-2018  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+#include "DFA.h"
+#include "Matcher.h"
+#include "Stats.h"
+using namespace std;
+
+// Memory budget for the state cache (in bytes).
+static const unsigned int DFA_MEMORY_BUDGET = 8 * 1024 * 1024;
+
+void
+DFA::build(Matcher *m)
+{
+  matcher = m;
+  dfa_states.clear();
+  transitions.clear();
+  lookup.clear();
+  loop_spans.clear();
+  memory = 0;
+  full = false;
+  num_fallbacks = 0;
+  num_span_chars = 0;
+
+  // determine which program states are needed: states that consume
+  // characters, states that wait for the end of the string, and the final states
+  vector <MatchState> &states = matcher->states;
+  vector <unsigned int> &finals = matcher->finals;
+  needed.assign(states.size(), false);
+  for (unsigned int i = 0; i < finals.size(); i++) {
+    needed[finals[i]] = true;
+  }
+  has_dollar = false;
+  for (unsigned int s = 0; s < states.size(); s++) {
+    vector <MatchEdge>::iterator it;
+    for (it = states[s].edges.begin(); it != states[s].edges.end(); it++) {
+      if (it->type == MATCH_CHAR_SET) needed[s] = true;
+      if (it->type == MATCH_DOLLAR) {
+        needed[s] = true;
+        has_dollar = true;
+      }
+    }
+  }
+
+  compute_byte_classes();
+
+  // The start state is the only state where the caret edges can be traversed
+  // so it is not added to the lookup table.
+  DFAState start;
+  start.prog_states.push_back(matcher->initial);
+  closure(start.prog_states, true, false);
+  start.accept_known = false;
+  start.loop_span = -2;
+  dfa_states.push_back(start);
+  transitions.assign(num_byte_classes, -1);
+}
+
+void
+DFA::compute_byte_classes()
+{
+  // characters with the same membership in every character class are equivalent
+  vector <bitset <256> > &classes = matcher->classes;
+  map <string, unsigned char> signatures;
+  for (unsigned int c = 0; c < 256; c++) {
+    string signature(classes.size(), '0');
+    for (unsigned int i = 0; i < classes.size(); i++) {
+      if (classes[i][c]) signature[i] = '1';
+    }
+    map <string, unsigned char>::iterator it = signatures.find(signature);
+    if (it == signatures.end()) {
+      unsigned char id = signatures.size();
+      signatures[signature] = id;
+      byte_class[c] = id;
+    }
+    else {
+      byte_class[c] = it->second;
+    }
+  }
+  num_byte_classes = signatures.size();
+}
+
+void
+DFA::closure(vector <unsigned int> &prog_states, bool at_start, bool at_end,
+    bool before_newline)
+{
+  vector <MatchState> &states = matcher->states;
+  vector <bool> visited(states.size(), false);
+  vector <unsigned int> stack = prog_states;
+  prog_states.clear();
+
+  while (!stack.empty()) {
+    unsigned int state = stack.back();
+    stack.pop_back();
+    if (visited[state]) continue;
+    visited[state] = true;
+    if (needed[state]) prog_states.push_back(state);
+
+    vector <MatchEdge>::iterator it;
+    for (it = states[state].edges.begin(); it != states[state].edges.end(); it++) {
+      if (it->type == MATCH_EPSILON || (it->type == MATCH_CARET && at_start) ||
+          (it->type == MATCH_DOLLAR && at_end) ||
+          (it->type == MATCH_END && at_end && !before_newline)) {
+        stack.push_back(it->to);
+      }
+    }
+  }
+
+  sort(prog_states.begin(), prog_states.end());
+}
+
+int
+DFA::get_state(vector <unsigned int> &prog_states)
+{
+  map <vector <unsigned int>, int>::iterator it = lookup.find(prog_states);
+  if (it != lookup.end()) return it->second;
+  if (full) return -1;
+
+  // state set is stored twice (state and lookup table)
+  unsigned int cost = sizeof(DFAState) + 2 * prog_states.size() * sizeof(unsigned int) +
+    num_byte_classes * sizeof(int) + 64;
+  if (memory + cost > DFA_MEMORY_BUDGET) {
+    full = true;
+    return -1;
+  }
+  memory += cost;
+
+  DFAState state;
+  state.prog_states = prog_states;
+  state.accept_known = false;
+  state.loop_span = -2;
+  dfa_states.push_back(state);
+  transitions.resize(transitions.size() + num_byte_classes, -1);
+  lookup[prog_states] = dfa_states.size() - 1;
+  return dfa_states.size() - 1;
+}
+
+int
+DFA::next_state(int state, unsigned char c)
+{
+  unsigned int index = state * num_byte_classes + byte_class[c];
+  if (transitions[index] != -1) return transitions[index];
+
+  vector <unsigned int> next;
+  step(state, c, next);
+
+  int next_state = get_state(next);
+  if (next_state != -1) transitions[index] = next_state;
+  return next_state;
+}
+
+void
+DFA::step(int state, unsigned char c, vector <unsigned int> &next)
+{
+  vector <MatchState> &states = matcher->states;
+  vector <bitset <256> > &classes = matcher->classes;
+  vector <unsigned int>::iterator it;
+  for (it = dfa_states[state].prog_states.begin(); it != dfa_states[state].prog_states.end(); it++) {
+    vector <MatchEdge>::iterator e;
+    for (e = states[*it].edges.begin(); e != states[*it].edges.end(); e++) {
+      if (e->type == MATCH_CHAR_SET && classes[e->index][c]) next.push_back(e->to);
+    }
+  }
+  closure(next, false, false);
+}
+
+int
+DFA::get_loop_span(int state)
+{
+  if (dfa_states[state].loop_span != -2) return dfa_states[state].loop_span;
+
+  // The transitions that are not computed yet are found without adding
+  // states, so the cache is not filled by characters that are never read.
+  vector <int> loops(num_byte_classes, -1);
+  bitset <256> chars;
+  for (unsigned int c = 0; c < 256; c++) {
+    unsigned char b = byte_class[c];
+    if (loops[b] == -1) {
+      int next = transitions[state * num_byte_classes + b];
+      if (next != -1) {
+        loops[b] = (next == state);
+      }
+      else {
+        vector <unsigned int> next_states;
+        step(state, c, next_states);
+        loops[b] = (next_states == dfa_states[state].prog_states);
+      }
+    }
+    if (loops[b]) chars.set(c);
+  }
+
+  int span = -1;
+  if (chars.any()) {
+    span = loop_spans.size();
+    loop_spans.push_back(CharSpan());
+    loop_spans.back().build(chars);
+  }
+  dfa_states[state].loop_span = span;
+  return span;
+}
+
+vector <unsigned int> &
+DFA::get_accepting(int state)
+{
+  DFAState &dfa_state = dfa_states[state];
+  if (!dfa_state.accept_known) {
+    vector <unsigned int> prog_states = dfa_state.prog_states;
+    closure(prog_states, state == 0, true);
+    vector <unsigned int> &finals = matcher->finals;
+    for (unsigned int i = 0; i < finals.size(); i++) {
+      if (binary_search(prog_states.begin(), prog_states.end(), finals[i])) {
+        dfa_state.accepting.push_back(i);
+      }
+    }
+    dfa_state.accept_known = true;
+  }
+  return dfa_state.accepting;
+}
+
+bool
+DFA::match(const string &str, bool &accepted)
+{
+  vector <unsigned int> accepting;
+  if (!match_all(str, accepting)) return false;
+  accepted = !accepting.empty();
+  return true;
+}
+
+bool
+DFA::match_all(const string &str, vector <unsigned int> &accepting)
+{
+  // Dollar can also match before a final newline, which depends on the
+  // position of the character.  Leave these strings to the simulation.
+  if (has_dollar && !str.empty() && str[str.size() - 1] == '\n') {
+    num_fallbacks++;
+    return false;
+  }
+
+  int state = 0;
+  for (unsigned int pos = 0; pos < str.size(); pos++) {
+    int next = next_state(state, str[pos]);
+    if (next == -1) {
+      num_fallbacks++;
+      return false;
+    }
+
+    // skip the rest of the characters that stay in a looping state
+    if (next == state) {
+      int span = get_loop_span(state);
+      if (span != -1) {
+        unsigned int end = loop_spans[span].find_end(str.data(), pos + 1, str.size());
+        num_span_chars += end - pos - 1;
+        pos = end - 1;
+      }
+    }
+    state = next;
+
+    // no program states left - string is rejected
+    if (dfa_states[state].prog_states.empty()) {
+      accepting.clear();
+      return true;
+    }
+  }
+
+  accepting = get_accepting(state);
+  return true;
+}
+
+bool
+DFA::build_all()
+{
+  // states are added to the end of the list, so the list is also the worklist
+  for (unsigned int state = 0; state < dfa_states.size(); state++) {
+    for (unsigned int c = 0; c < 256; c++) {
+      if (next_state(state, c) == -1) return false;
+    }
+  }
+  return true;
+}
+
+bool
+DFA::accepts_final_newline(int state)
+{
+  if (!has_dollar) return false;
+
+  // follow the dollar edges, read the newline, and reach the end of string
+  vector <unsigned int> prog_states = dfa_states[state].prog_states;
+  closure(prog_states, state == 0, true, true);
+  vector <MatchState> &states = matcher->states;
+  vector <bitset <256> > &classes = matcher->classes;
+  vector <unsigned int> next;
+  vector <unsigned int>::iterator it;
+  for (it = prog_states.begin(); it != prog_states.end(); it++) {
+    vector <MatchEdge>::iterator e;
+    for (e = states[*it].edges.begin(); e != states[*it].edges.end(); e++) {
+      if (e->type == MATCH_CHAR_SET && classes[e->index]['\n']) next.push_back(e->to);
+    }
+  }
+  closure(next, false, true);
+
+  vector <unsigned int> &finals = matcher->finals;
+  for (unsigned int i = 0; i < finals.size(); i++) {
+    if (binary_search(next.begin(), next.end(), finals[i])) return true;
+  }
+  return false;
+}
+
+void
+DFA::add_stats(Stats &stats)
+{
+  stats.add("MATCHER", "DFA states", dfa_states.size());
+  stats.add("MATCHER", "DFA fallbacks", num_fallbacks);
+  stats.add("MATCHER", "DFA span characters", num_span_chars);
+}
@@ -0,0 +1,127 @@
+/*  DFA.h: Lazily constructed DFA used to classify test strings
+
+    Copyright (C) 2016-2018  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// The DFA is built on demand from the matcher program using subset
+// construction: a DFA state is the set of program states reachable after
+// reading a prefix of the string, and a transition is only computed the first
+// time it is needed.  Characters are grouped into byte classes (characters
+// that no character class can tell apart) to keep the transition table small.
+// A DFA built for a union of programs records which of the final states are
+// reached, so a single pass over a string classifies it against every program.
+//
+// A state that reads a character and stays in the same state often does so
+// for a run of characters.  The characters that keep each such state are found
+// the first time it loops, and the run is skipped with a character span.
+//
+// The states are kept in a cache with a fixed memory budget.  Once the cache
+// is full, strings that need a new state are left undecided and the matcher
+// falls back to simulating the program.
+
+#ifndef DFA_H
+#define DFA_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include "CharSpan.h"
+#include "Stats.h"
+using namespace std;
+
+class Matcher;		// breaks a circular dependency Matcher --> DFA --> Matcher
+
+struct DFAState {
+  vector <unsigned int> prog_states;	// sorted set of program states
+  bool accept_known;			// true if accepting has been computed
+  vector <unsigned int> accepting;	// final states reached at end of string (index into finals)
+  int loop_span;			// span of characters that stay in state (-1 if none, -2 if not found)
+};
+
+class DFA {
+
+  friend class CodeGenerator;
+
+public:
+
+  DFA() { matcher = NULL; num_fallbacks = 0; num_span_chars = 0; }
+
+  // build an empty DFA for the program of the matcher
+  void build(Matcher *m);
+
+  // determines if string is accepted, returns false if the string cannot be decided
+  bool match(const string &str, bool &accepted);
+
+  // finds the final states (index into the finals of the matcher) reached at the end
+  // of the string, returns false if the string cannot be decided
+  bool match_all(const string &str, vector <unsigned int> &accepting);
+
+  // builds every state reachable from the start state, returns false if the cache fills up
+  bool build_all();
+
+  // returns true if a final newline read from DFA state can follow a dollar and end the match
+  bool accepts_final_newline(int state);
+
+  // add DFA stats
+  void add_stats(Stats &stats);
+
+private:
+
+  Matcher *matcher;			// matcher containing program
+  unsigned char byte_class[256];	// byte class for each character
+  unsigned int num_byte_classes;	// number of byte classes
+  vector <bool> needed;			// program states kept in DFA states
+  vector <DFAState> dfa_states;		// cached states (start state is first)
+  vector <int> transitions;		// next state for each state and byte class (-1 if not computed)
+  map <vector <unsigned int>, int> lookup;	// program state set -> DFA state
+  unsigned int memory;			// estimated memory used by cache
+  bool has_dollar;			// true if program contains dollar edges
+  bool full;				// true if cache is full
+  vector <CharSpan> loop_spans;		// characters that stay in looping states
+
+  // stats
+  int num_fallbacks;
+  int num_span_chars;
+
+  // computes byte classes for the character classes of the program
+  void compute_byte_classes();
+
+  // follows empty edges from the program states, keeping the states needed for matching
+  // (before_newline is set when dollars are followed before a final newline, where \Z
+  // does not match)
+  void closure(vector <unsigned int> &prog_states, bool at_start, bool at_end,
+      bool before_newline = false);
+
+  // returns DFA state for set of program states, creating it if necessary (-1 if cache is full)
+  int get_state(vector <unsigned int> &prog_states);
+
+  // returns next DFA state upon reading character (-1 if cache is full)
+  int next_state(int state, unsigned char c);
+
+  // finds the program states reached from DFA state upon reading character
+  void step(int state, unsigned char c, vector <unsigned int> &next);
+
+  // returns the span of characters that stay in DFA state (-1 if none)
+  int get_loop_span(int state);
+
+  // returns the final states reached at end of string from DFA state
+  vector <unsigned int> &get_accepting(int state);
+};
+
+#endif // DFA_H
@@ -72,6 +72,31 @@ Edge::process_edge(string test_string, Path *path)
   }
 }
 
+void
+Edge::process_check_edge(const string &test_string, Path *path)
+{
+  // The checker only uses the substrings (for its examples), the prefixes are
+  // only needed for evil strings.
+  switch (type) {
+    case STRING_EDGE:
+      if (!processed) regex_str->set_substring(Util::get()->get_base_substring());
+      break;
+    case BEGIN_LOOP_EDGE:
+      regex_loop->set_curr_prefix(test_string);
+      break;
+    case END_LOOP_EDGE:
+      regex_loop->set_curr_substring(test_string);
+      break;
+    case BACKREFERENCE_EDGE:
+      backref->set_curr_substring(path->gen_backref_string(backref->get_group_loc()));
+      if (!processed) backref->set_substring_from_curr();
+      break;
+    default:
+      break;
+  }
+  processed = true;
+}
+
 string
 Edge::get_substring()
 {
@@ -96,6 +121,36 @@ Edge::get_substring()
   }
 }
 
+bool
+Edge::is_valid_substring()
+{
+  switch (type) {
+    case CHAR_SET_EDGE:
+      return char_set->is_valid_character(char_set->get_valid_character());
+    case STRING_EDGE:
+      return regex_str->is_valid_substring(regex_str->get_substring());
+    case BACKREFERENCE_EDGE:
+      return false;
+    default:
+      return true;
+  }
+}
+
+bool
+Edge::accepts_character(char c)
+{
+  switch (type) {
+    case CHARACTER_EDGE:
+      return character == c;
+    case CHAR_SET_EDGE:
+      return char_set->is_valid_character(c);
+    case STRING_EDGE:
+      return regex_str->get_charset()->is_valid_character(c);
+    default:
+      return false;
+  }
+}
+
 bool
 Edge::is_opt_repeat_begin()
 {
@@ -181,6 +236,13 @@ Edge::get_repeat_upper_limit()
   return regex_loop->get_repeat_upper();
 }
 
+bool
+Edge::is_lazy_repeat()
+{
+  if (type == STRING_EDGE) return regex_str->is_lazy();
+  return regex_loop->is_lazy();
+}
+
 bool
 Edge::is_zero_repeat_begin()
 {
@@ -238,7 +300,6 @@ Edge::gen_min_iter_string(string &min_iter_string)
       regex_str->gen_min_iter_string(min_iter_string);
       break;
     case BEGIN_LOOP_EDGE:
-      regex_loop->set_curr_prefix(min_iter_string);
       break;
     case END_LOOP_EDGE:
       regex_loop->gen_min_iter_string(min_iter_string);
@@ -250,17 +311,21 @@ Edge::gen_min_iter_string(string &min_iter_string)
 }
 
 vector <string>
-Edge::gen_evil_strings(string path_string, const set <char> &punct_marks)
+Edge::gen_evil_strings(string path_string, const set <char> &punct_marks, vector <bool> &valid)
 {
   switch (type) {
     case CHAR_SET_EDGE:
-      return char_set->gen_evil_strings(path_string, punct_marks);
+      return char_set->gen_evil_strings(path_string, punct_marks, valid);
     case STRING_EDGE:
-      return regex_str->gen_evil_strings(path_string, punct_marks);
+      return regex_str->gen_evil_strings(path_string, punct_marks, valid);
     case END_LOOP_EDGE:
-      return regex_loop->gen_evil_strings(path_string);
+      return regex_loop->gen_evil_strings(path_string, valid);
     case BACKREFERENCE_EDGE:
-      return backref->gen_evil_strings(path_string);
+    {
+      vector <string> evil_strings = backref->gen_evil_strings(path_string);
+      valid.insert(valid.end(), evil_strings.size(), false);
+      return evil_strings;
+    }
     default:
     {
       vector <string> empty;
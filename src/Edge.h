@@ -67,13 +67,28 @@ public:
     if (type == STRING_EDGE) return regex_str->get_charset();
     return char_set;
   }
+  RegexLoop *get_regex_loop()	{ return regex_loop; }
+  Backref *get_backref()	{ return backref; }
 
   // process an edge, returns true if edge should be used in creating evil strings
   bool process_edge(string test_string, Path *path);
 
+  // process an edge for the checker, only sets the substrings (no prefixes)
+  void process_check_edge(const string &test_string, Path *path);
+
+  // marks the edge as unprocessed
+  void clear_processed() { processed = false; }
+
   // get substring associated with edge
   string get_substring();
 
+  // returns true if the substring of the edge is matched by the edge (false for
+  // backreferences, loops and anchors are checked by the path)
+  bool is_valid_substring();
+
+  // returns true if the edge can consume the character
+  bool accepts_character(char c);
+
   // edge property functions - used by checker
   bool is_opt_repeat_begin();
   bool is_opt_repeat_end();
@@ -86,6 +101,7 @@ public:
   char get_repeat_punc_char();
   int get_repeat_lower_limit();
   int get_repeat_upper_limit();
+  bool is_lazy_repeat();
   bool is_zero_repeat_begin();
   bool is_zero_repeat_end();
   bool is_digit_too_optional_candidate();
@@ -96,8 +112,9 @@ public:
   // generate minimum iteration string
   void gen_min_iter_string(string &min_iter_string);
 
-  // generate evil strings
-  vector <string> gen_evil_strings(string path_string, const set <char> &punct_marks);
+  // generate evil strings, valid is set for strings where the edge still matches its substring
+  vector <string> gen_evil_strings(string path_string, const set <char> &punct_marks,
+      vector <bool> &valid);
 
   // print the edge
   void print();
@@ -106,7 +123,7 @@ private:
   EdgeType type;		// type of edge
   Location loc;                 // location within original regex
   bool processed;		// set if edge is processed
-  char character;		// character (for CHARACTER_EDGE)
+  char character;		// character (for CHARACTER_EDGE, 'Z' for a \Z DOLLAR_EDGE)
   CharSet *char_set;		// character set (for CHAR_SET_EDGE)
   RegexString *regex_str;	// regex string (for STRING_EDGE)
   RegexLoop *regex_loop;	// regex loop (for BEGIN_LOOP_EDGE and END_LOOP_EDGE)
@@ -0,0 +1,32 @@
+/*  MatchVerdict.h: Verdict of matching a string against a regex
+
+    Copyright (C) 2016-2018  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MATCH_VERDICT_H
+#define MATCH_VERDICT_H
+
+// Match verdict
+typedef enum {
+  MATCH_ACCEPT,
+  MATCH_REJECT,
+  MATCH_UNKNOWN
+} MatchVerdict;
+
+#endif // MATCH_VERDICT_H
@@ -0,0 +1,703 @@
+/*  Matcher.cpp: Native matcher used to classify test strings
+
+    Copyright (C) 2016-2018  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <bitset>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include "CharSpan.h"
+#include "Edge.h"
+#include "Matcher.h"
+#include "NFA.h"
+#include "Util.h"
+using namespace std;
+
+// Limits on the size of the program and the work done by the backtracking search.
+// Exceeding either one results in MATCH_UNKNOWN.
+static const unsigned int MAX_PROGRAM_STATES = 100000;
+static const long BACKTRACK_LIMIT = 1000000;
+
+static bool
+compare_groups(const NFAGroup &g1, const NFAGroup &g2)
+{
+  return g1.number < g2.number;
+}
+
+static CharSpan
+ascii_span()
+{
+  bitset <256> ascii;
+  for (unsigned int c = 0; c < 0x80; c++) ascii.set(c);
+  CharSpan span;
+  span.build(ascii);
+  return span;
+}
+
+// returns true if every character of the string is ASCII (the only strings supported)
+static bool
+is_ascii(const string &str)
+{
+  static const CharSpan span = ascii_span();
+  return span.find_end(str.data(), 0, str.size()) == str.size();
+}
+
+// PROGRAM CONSTRUCTION FUNCTIONS
+
+void
+Matcher::build(NFA &nfa)
+{
+  states.clear();
+  classes.clear();
+  loop_ends.clear();
+  has_backrefs = false;
+  exact_groups = true;
+  num_accepted = 0;
+  num_rejected = 0;
+  num_unknown = 0;
+  num_group_matches = 0;
+
+  // Ignored elements (lookaheads, word boundaries, flags) are not in the NFA
+  // so strings cannot be matched faithfully.
+  supported = !nfa.has_ignored_elements();
+  if (!supported) return;
+
+  groups = nfa.get_groups();
+  sort(groups.begin(), groups.end(), compare_groups);
+
+  // locate the end of each loop
+  for (unsigned int from = 0; from < nfa.get_size(); from++) {
+    for (unsigned int to = 0; to < nfa.get_size(); to++) {
+      Edge *edge = nfa.get_edge(from, to);
+      if (edge != NULL && edge->get_type() == END_LOOP_EDGE) {
+        loop_ends[edge->get_regex_loop()] = make_pair(from, to);
+      }
+    }
+  }
+
+  pair <unsigned int, unsigned int> ends = expand(nfa, nfa.get_initial(), nfa.get_final());
+  initial = ends.first;
+  final = ends.second;
+  finals.assign(1, final);
+
+  // NFA no longer needed
+  loop_ends.clear();
+
+  // pick the matcher based on the size of the program
+  bit_parallel = false;
+  if (supported && !has_backrefs) {
+    bit_parallel = bit_matcher.build(this);
+    if (!bit_parallel) dfa.build(this);
+  }
+}
+
+vector <unsigned int>
+Matcher::build_union(const vector <Matcher *> &matchers)
+{
+  states.clear();
+  classes.clear();
+  groups.clear();
+  finals.clear();
+  has_backrefs = false;
+  exact_groups = false;
+  bit_parallel = false;
+  supported = true;
+  num_accepted = 0;
+  num_rejected = 0;
+  num_unknown = 0;
+
+  // the initial state has an empty edge to the initial state of each program
+  vector <unsigned int> included;
+  initial = add_state();
+  for (unsigned int i = 0; i < matchers.size(); i++) {
+    Matcher *matcher = matchers[i];
+    if (!matcher->supported || matcher->has_backrefs) continue;
+    if (states.size() + matcher->states.size() > MAX_PROGRAM_STATES) continue;
+
+    // copy the program, captures are not needed
+    unsigned int offset = states.size();
+    for (unsigned int s = 0; s < matcher->states.size(); s++) {
+      MatchState state;
+      state.edges = matcher->states[s].edges;
+      vector <MatchEdge>::iterator it;
+      for (it = state.edges.begin(); it != state.edges.end(); it++) {
+        it->to += offset;
+        if (it->type == MATCH_CHAR_SET) it->index = add_class(matcher->classes[it->index]);
+      }
+      states.push_back(state);
+    }
+    add_edge(initial, matcher->initial + offset, MATCH_EPSILON);
+    finals.push_back(matcher->final + offset);
+    included.push_back(i);
+  }
+  final = finals.empty() ? initial : finals[0];
+
+  dfa.build(this);
+  return included;
+}
+
+pair <unsigned int, unsigned int>
+Matcher::expand(NFA &nfa, unsigned int entry, unsigned int exit)
+{
+  map <unsigned int, unsigned int> mapping;	// NFA state -> program state
+  vector <unsigned int> worklist;
+  vector <bool> visited(nfa.get_size(), false);
+
+  unsigned int prog_entry = get_state(entry, mapping);
+  worklist.push_back(entry);
+  visited[entry] = true;
+
+  while (!worklist.empty() && supported) {
+    unsigned int state = worklist.back();
+    worklist.pop_back();
+    if (state == exit) continue;
+
+    unsigned int from = get_state(state, mapping);
+    for (unsigned int to = 0; to < nfa.get_size(); to++) {
+      Edge *edge = nfa.get_edge(state, to);
+      if (edge == NULL) continue;
+
+      unsigned int next = to;
+      switch (edge->get_type()) {
+        case CHARACTER_EDGE:
+          add_edge(from, get_state(to, mapping), MATCH_CHAR_SET, add_class(edge->get_character()));
+          break;
+        case CHAR_SET_EDGE:
+          add_edge(from, get_state(to, mapping), MATCH_CHAR_SET, add_class(edge->get_charset()));
+          break;
+        case STRING_EDGE:
+          add_repeat(from, get_state(to, mapping), add_class(edge->get_charset()),
+              edge->get_repeat_lower_limit(), edge->get_repeat_upper_limit(),
+              edge->is_lazy_repeat());
+          break;
+        case BEGIN_LOOP_EDGE:
+        {
+          // the loop body lies between the begin and end loop edges,
+          // continue the expansion after the end loop edge
+          RegexLoop *loop = edge->get_regex_loop();
+          pair <unsigned int, unsigned int> loop_end = loop_ends[loop];
+          next = loop_end.second;
+          add_loop(nfa, from, get_state(next, mapping), to, loop_end.first,
+              loop->get_repeat_lower(), loop->get_repeat_upper(), loop->is_lazy());
+          break;
+        }
+        case END_LOOP_EDGE:
+          throw EgretException("ERROR (internal): Unexpected end loop edge in matcher");
+        case CARET_EDGE:
+          add_edge(from, get_state(to, mapping), MATCH_CARET);
+          break;
+        case DOLLAR_EDGE:
+          // \Z does not match before a final newline
+          add_edge(from, get_state(to, mapping),
+              edge->get_character() == 'Z' ? MATCH_END : MATCH_DOLLAR);
+          break;
+        case BACKREFERENCE_EDGE:
+        {
+          Location group_loc = edge->get_backref()->get_group_loc();
+          int group = -1;
+          for (unsigned int i = 0; i < groups.size(); i++) {
+            if (groups[i].loc == group_loc) group = i;
+          }
+          if (group == -1) {
+            supported = false;
+          }
+          add_edge(from, get_state(to, mapping), MATCH_BACKREFERENCE, group);
+          has_backrefs = true;
+          break;
+        }
+        case EPSILON_EDGE:
+          add_edge(from, get_state(to, mapping), MATCH_EPSILON);
+          break;
+      }
+
+      if (!visited[next]) {
+        visited[next] = true;
+        worklist.push_back(next);
+      }
+    }
+  }
+
+  return make_pair(prog_entry, get_state(exit, mapping));
+}
+
+unsigned int
+Matcher::get_state(unsigned int state, map <unsigned int, unsigned int> &mapping)
+{
+  map <unsigned int, unsigned int>::iterator it = mapping.find(state);
+  if (it != mapping.end()) return it->second;
+
+  unsigned int prog_state = add_state();
+  mapping[state] = prog_state;
+
+  // record group boundaries
+  for (unsigned int i = 0; i < groups.size(); i++) {
+    if (groups[i].initial == state) states[prog_state].saves.push_back(2 * i);
+    if (groups[i].final == state) states[prog_state].saves.push_back(2 * i + 1);
+  }
+
+  return prog_state;
+}
+
+unsigned int
+Matcher::add_state()
+{
+  if (states.size() >= MAX_PROGRAM_STATES) {
+    supported = false;
+  }
+  states.push_back(MatchState());
+  return states.size() - 1;
+}
+
+void
+Matcher::add_edge(unsigned int from, unsigned int to, MatchEdgeType type, int index)
+{
+  MatchEdge edge = { type, to, index };
+  states[from].edges.push_back(edge);
+}
+
+int
+Matcher::add_class(CharSet *char_set)
+{
+  return add_class(char_set->get_bitmap());
+}
+
+int
+Matcher::add_class(char c)
+{
+  bitset <256> char_class;
+  char_class.set((unsigned char) c);
+  return add_class(char_class);
+}
+
+int
+Matcher::add_class(const bitset <256> &char_class)
+{
+  for (unsigned int i = 0; i < classes.size(); i++) {
+    if (classes[i] == char_class) return i;
+  }
+  classes.push_back(char_class);
+  return classes.size() - 1;
+}
+
+void
+Matcher::add_repeat(unsigned int from, unsigned int to, int char_class, int lower, int upper,
+    bool lazy)
+{
+  unsigned int curr = from;
+  for (int i = 0; i < lower; i++) {
+    unsigned int next = add_state();
+    add_edge(curr, next, MATCH_CHAR_SET, char_class);
+    curr = next;
+  }
+
+  // The order of the edges is the order the backtracking search tries them:
+  // another character first (greedy) or leaving first (lazy).
+  if (upper == -1) {
+
+    // the repeated edge needs its own state so the captures saved at from are not
+    // saved again on each character
+    if (curr == from) {
+      curr = add_state();
+      add_edge(from, curr, MATCH_EPSILON);
+    }
+    if (lazy) add_edge(curr, to, MATCH_EPSILON);
+    add_edge(curr, curr, MATCH_CHAR_SET, char_class);
+    if (!lazy) add_edge(curr, to, MATCH_EPSILON);
+    return;
+  }
+
+  for (int i = lower; i < upper; i++) {
+    unsigned int next = add_state();
+    if (lazy) add_edge(curr, to, MATCH_EPSILON);
+    add_edge(curr, next, MATCH_CHAR_SET, char_class);
+    if (!lazy) add_edge(curr, to, MATCH_EPSILON);
+    curr = next;
+  }
+  add_edge(curr, to, MATCH_EPSILON);
+}
+
+void
+Matcher::add_loop(NFA &nfa, unsigned int from, unsigned int to, unsigned int entry,
+    unsigned int exit, int lower, int upper, bool lazy)
+{
+  // required iterations
+  unsigned int curr = from;
+  for (int i = 0; i < lower && supported; i++) {
+    pair <unsigned int, unsigned int> body = expand(nfa, entry, exit);
+    add_edge(curr, body.first, MATCH_EPSILON);
+    curr = body.second;
+  }
+
+  // unbounded loop: body returns to a loop head (edge order as in add_repeat)
+  if (upper == -1) {
+    unsigned int head = add_state();
+    unsigned int body_start = states.size();
+    pair <unsigned int, unsigned int> body = expand(nfa, entry, exit);
+    add_edge(curr, head, MATCH_EPSILON);
+    if (lazy) add_edge(head, to, MATCH_EPSILON);
+    add_edge(head, body.first, MATCH_EPSILON);
+    add_edge(body.second, head, MATCH_EPSILON);
+    if (!lazy) add_edge(head, to, MATCH_EPSILON);
+    check_empty_iteration(body_start, body);
+    return;
+  }
+
+  // bounded loop: each additional iteration is optional
+  for (int i = lower; i < upper && supported; i++) {
+    unsigned int body_start = states.size();
+    pair <unsigned int, unsigned int> body = expand(nfa, entry, exit);
+    check_empty_iteration(body_start, body);
+    if (lazy) add_edge(curr, to, MATCH_EPSILON);
+    add_edge(curr, body.first, MATCH_EPSILON);
+    if (!lazy) add_edge(curr, to, MATCH_EPSILON);
+    curr = body.second;
+  }
+  add_edge(curr, to, MATCH_EPSILON);
+}
+
+void
+Matcher::check_empty_iteration(unsigned int body_start, pair <unsigned int, unsigned int> body)
+{
+  // Python can match an optional iteration of a body that matches the empty
+  // string, which the search skips.  Groups in such a body may differ.
+  if (!supported || !is_nullable(body.first, body.second)) return;
+  for (unsigned int s = body_start; s < states.size(); s++) {
+    if (!states[s].saves.empty()) exact_groups = false;
+  }
+}
+
+bool
+Matcher::is_nullable(unsigned int entry, unsigned int exit)
+{
+  vector <bool> visited(states.size(), false);
+  vector <unsigned int> stack(1, entry);
+  while (!stack.empty()) {
+    unsigned int state = stack.back();
+    stack.pop_back();
+    if (state == exit) return true;
+    if (visited[state]) continue;
+    visited[state] = true;
+
+    // backreferences can match the empty string
+    vector <MatchEdge>::iterator it;
+    for (it = states[state].edges.begin(); it != states[state].edges.end(); it++) {
+      if (it->type != MATCH_CHAR_SET) stack.push_back(it->to);
+    }
+  }
+  return false;
+}
+
+// MATCHING FUNCTIONS
+
+MatchVerdict
+Matcher::match(const string &str)
+{
+  if (!supported) return MATCH_UNKNOWN;
+
+  // only ASCII strings are supported
+  if (!is_ascii(str)) return MATCH_UNKNOWN;
+
+  // The search skips empty iterations of a loop, but Python can match them and
+  // change the groups a backreference refers to, so the verdict is not known.
+  if (has_backrefs) {
+    if (!exact_groups) return MATCH_UNKNOWN;
+    vector <int> captures;
+    return backtrack(str, captures);
+  }
+
+  // use the simulation if the string cannot be decided
+  bool accepted;
+  bool decided = bit_parallel ? bit_matcher.match(str, accepted) : dfa.match(str, accepted);
+  if (!decided) accepted = simulate(str);
+  return accepted ? MATCH_ACCEPT : MATCH_REJECT;
+}
+
+MatchVerdict
+Matcher::match_groups(const string &str, vector <int> &spans)
+{
+  if (!supported || !exact_groups) return MATCH_UNKNOWN;
+
+  // only ASCII strings are supported
+  if (!is_ascii(str)) return MATCH_UNKNOWN;
+
+  // the search tries the edges in the same order as Python so the first
+  // match found has the same groups
+  MatchVerdict verdict = backtrack(str, spans);
+  if (verdict == MATCH_ACCEPT) num_group_matches++;
+  return verdict;
+}
+
+bool
+Matcher::match_union(const string &str, vector <unsigned int> &accepting)
+{
+  // only ASCII strings are supported
+  if (!is_ascii(str)) return false;
+
+  return dfa.match_all(str, accepting);
+}
+
+void
+Matcher::classify(const vector <string> &strings, vector <string> &accepted,
+    vector <string> &rejected, vector <string> &unknown)
+{
+  vector <string>::const_iterator it;
+  for (it = strings.begin(); it != strings.end(); it++) {
+    switch (match(*it)) {
+      case MATCH_ACCEPT:
+        accepted.push_back(*it);
+        num_accepted++;
+        break;
+      case MATCH_REJECT:
+        rejected.push_back(*it);
+        num_rejected++;
+        break;
+      case MATCH_UNKNOWN:
+        unknown.push_back(*it);
+        num_unknown++;
+        break;
+    }
+  }
+
+  sort(accepted.begin(), accepted.end());
+  sort(rejected.begin(), rejected.end());
+  sort(unknown.begin(), unknown.end());
+}
+
+bool
+Matcher::can_traverse(const MatchEdge &edge, const string &str, unsigned int pos)
+{
+  switch (edge.type) {
+    case MATCH_EPSILON:
+      return true;
+    case MATCH_CARET:
+      return pos == 0;
+    case MATCH_DOLLAR:
+      return pos == str.size() || (pos + 1 == str.size() && str[pos] == '\n');
+    case MATCH_END:
+      return pos == str.size();
+    default:
+      return false;
+  }
+}
+
+bool
+Matcher::simulate(const string &str)
+{
+  // Thread lists are sparse sets: a state is in the list if
+  // dense[sparse[state]] == state for an index less than the list size.
+  unsigned int num_states = states.size();
+  vector <unsigned int> curr_dense(num_states), curr_sparse(num_states);
+  vector <unsigned int> next_dense(num_states), next_sparse(num_states);
+  unsigned int curr_size = 0;
+  unsigned int next_size = 0;
+  vector <unsigned int> stack;
+
+  for (unsigned int pos = 0; pos <= str.size(); pos++) {
+
+    // add the initial state at the start
+    if (pos == 0) stack.push_back(initial);
+
+    // follow the empty edges from each new state
+    while (!stack.empty()) {
+      unsigned int state = stack.back();
+      stack.pop_back();
+      unsigned int idx = next_sparse[state];
+      if (idx < next_size && next_dense[idx] == state) continue;
+      next_sparse[state] = next_size;
+      next_dense[next_size++] = state;
+
+      vector <MatchEdge>::iterator it;
+      for (it = states[state].edges.begin(); it != states[state].edges.end(); it++) {
+        if (can_traverse(*it, str, pos)) stack.push_back(it->to);
+      }
+    }
+
+    // next list becomes the current list
+    curr_dense.swap(next_dense);
+    curr_sparse.swap(next_sparse);
+    curr_size = next_size;
+    next_size = 0;
+
+    if (pos == str.size() || curr_size == 0) break;
+
+    // step each thread over the current character
+    unsigned char c = str[pos];
+    for (unsigned int i = 0; i < curr_size; i++) {
+      vector <MatchEdge> &edges = states[curr_dense[i]].edges;
+      vector <MatchEdge>::iterator it;
+      for (it = edges.begin(); it != edges.end(); it++) {
+        if (it->type == MATCH_CHAR_SET && classes[it->index][c]) {
+          stack.push_back(it->to);
+        }
+      }
+    }
+  }
+
+  unsigned int idx = curr_sparse[final];
+  return idx < curr_size && curr_dense[idx] == final;
+}
+
+MatchVerdict
+Matcher::backtrack(const string &str, vector <int> &captures)
+{
+  struct Frame {
+    unsigned int state;			// current state
+    unsigned int pos;			// current position
+    unsigned int next_edge;		// next edge to try
+    int prev_visit;			// previous visit position for state
+    vector <pair <int, int> > undo;	// capture slots to restore
+  };
+
+  captures.assign(2 * groups.size(), -1);
+  vector <int> visiting(states.size(), -1);	// position of state on current path
+  vector <Frame> stack;
+  long steps = 0;
+
+  Frame frame = { initial, 0, 0, -1, vector <pair <int, int> >() };
+  for (unsigned int i = 0; i < states[initial].saves.size(); i++) {
+    int slot = states[initial].saves[i];
+    frame.undo.push_back(make_pair(slot, captures[slot]));
+    captures[slot] = 0;
+  }
+  visiting[initial] = 0;
+  stack.push_back(frame);
+
+  while (!stack.empty()) {
+    if (++steps > BACKTRACK_LIMIT) return MATCH_UNKNOWN;
+
+    Frame &top = stack.back();
+    if (top.state == final && top.pos == str.size()) return MATCH_ACCEPT;
+
+    // all edges tried - restore captures and back up
+    if (top.next_edge == states[top.state].edges.size()) {
+      vector <pair <int, int> >::reverse_iterator it;
+      for (it = top.undo.rbegin(); it != top.undo.rend(); it++) {
+        captures[it->first] = it->second;
+      }
+      visiting[top.state] = top.prev_visit;
+      stack.pop_back();
+      continue;
+    }
+
+    // try the next edge
+    MatchEdge &edge = states[top.state].edges[top.next_edge++];
+    unsigned int pos = top.pos;
+    int new_pos = -1;
+    switch (edge.type) {
+      case MATCH_CHAR_SET:
+        if (pos < str.size() && classes[edge.index][(unsigned char) str[pos]]) new_pos = pos + 1;
+        break;
+      case MATCH_BACKREFERENCE:
+      {
+        // backreferences to groups that did not participate fail
+        int start = captures[2 * edge.index];
+        int end = captures[2 * edge.index + 1];
+        if (start == -1 || end < start) break;
+        unsigned int length = end - start;
+        if (pos + length <= str.size() && str.compare(pos, length, str, start, length) == 0) {
+          new_pos = pos + length;
+        }
+        break;
+      }
+      default:
+        if (can_traverse(edge, str, pos)) new_pos = pos;
+    }
+
+    // skip failed edges and empty cycles
+    if (new_pos == -1 || visiting[edge.to] == new_pos) continue;
+
+    Frame next = { edge.to, (unsigned int) new_pos, 0, visiting[edge.to], vector <pair <int, int> >() };
+    vector <int> &saves = states[edge.to].saves;
+    for (unsigned int i = 0; i < saves.size(); i++) {
+      next.undo.push_back(make_pair(saves[i], captures[saves[i]]));
+      captures[saves[i]] = new_pos;
+    }
+    visiting[edge.to] = new_pos;
+    stack.push_back(next);
+  }
+
+  return MATCH_REJECT;
+}
+
+// PRINT AND STAT FUNCTIONS
+
+void
+Matcher::print()
+{
+  cout << "Matcher: " << endl;
+  if (!supported) {
+    cout << "Unsupported regex" << endl << endl;
+    return;
+  }
+  cout << "Number of states: " << states.size() << " ";
+  cout << "Initial state: " << initial << " ";
+  cout << "Final state: " << final << endl;
+
+  for (unsigned int from = 0; from < states.size(); from++) {
+    cout << "State " << from << ":";
+    for (unsigned int i = 0; i < states[from].saves.size(); i++) {
+      cout << " save " << states[from].saves[i];
+    }
+    cout << endl;
+
+    vector <MatchEdge>::iterator it;
+    for (it = states[from].edges.begin(); it != states[from].edges.end(); it++) {
+      cout << "  To state " << it->to << " on ";
+      switch (it->type) {
+        case MATCH_CHAR_SET:
+          cout << "CLASS " << it->index;
+          break;
+        case MATCH_EPSILON:
+          cout << "EPSILON";
+          break;
+        case MATCH_CARET:
+          cout << "CARET";
+          break;
+        case MATCH_DOLLAR:
+          cout << "DOLLAR";
+          break;
+        case MATCH_END:
+          cout << "END";
+          break;
+        case MATCH_BACKREFERENCE:
+          cout << "BACKREFERENCE " << it->index;
+          break;
+      }
+      cout << endl;
+    }
+  }
+
+  cout << endl;
+}
+
+void
+Matcher::add_stats(Stats &stats)
+{
+  stats.add("MATCHER", "Matcher states", supported ? states.size() : 0);
+  stats.add("MATCHER", "Matcher char classes", supported ? classes.size() : 0);
+  stats.add("MATCHER", "Accepted strings", num_accepted);
+  stats.add("MATCHER", "Rejected strings", num_rejected);
+  stats.add("MATCHER", "Undecided strings", num_unknown);
+  stats.add("MATCHER", "Matches with group spans", num_group_matches);
+  bit_matcher.add_stats(stats);
+  dfa.add_stats(stats);
+}
@@ -0,0 +1,186 @@
+/*  Matcher.h: Native matcher used to classify test strings
+
+    Copyright (C) 2016-2018  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// The NFA used for path generation does not contain back edges: loops are
+// represented by BEGIN_LOOP/END_LOOP edges that carry the repeat bounds and
+// regex strings are single edges.  The matcher expands the NFA into a
+// program where loops are unrolled into real cycles.  Strings are matched
+// using a Pike VM (Thompson simulation) unless the regex contains
+// backreferences, in which case a bounded backtracking search is used.
+//
+// The matcher only handles ASCII strings.  Strings it cannot decide (non-ASCII
+// strings, regexes with ignored elements, or backtracking searches that exceed
+// the step limit) are reported as MATCH_UNKNOWN so the caller can fall back
+// to another matcher.
+
+#ifndef MATCHER_H
+#define MATCHER_H
+
+#include <bitset>
+#include <map>
+#include <string>
+#include <vector>
+#include "BitMatcher.h"
+#include "DFA.h"
+#include "Edge.h"
+#include "MatchVerdict.h"
+#include "NFA.h"
+#include "Stats.h"
+#include "Util.h"
+using namespace std;
+
+typedef enum {
+  MATCH_CHAR_SET,	// consumes a character in a character class
+  MATCH_EPSILON,	// consumes nothing
+  MATCH_CARET,		// consumes nothing, only at start of string
+  MATCH_DOLLAR,		// consumes nothing, only at end of string (or before final newline)
+  MATCH_END,		// consumes nothing, only at end of string (\Z)
+  MATCH_BACKREFERENCE	// consumes the string captured by a group
+} MatchEdgeType;
+
+struct MatchEdge {
+  MatchEdgeType type;
+  unsigned int to;	// destination state
+  int index;		// character class (MATCH_CHAR_SET) or group (MATCH_BACKREFERENCE)
+};
+
+struct MatchState {
+  vector <MatchEdge> edges;	// outgoing edges
+  vector <int> saves;		// capture slots set to the current position upon entry
+};
+
+class Matcher {
+
+  friend class BitMatcher;
+  friend class DFA;
+
+public:
+
+  Matcher() { supported = false; bit_parallel = false; exact_groups = false; }
+
+  // build the matcher from the NFA
+  void build(NFA &nfa);
+
+  // returns true if the matcher can decide strings for this regex
+  bool is_supported() { return supported; }
+
+  // determines if string is accepted by the regex
+  MatchVerdict match(const string &str);
+
+  // determines if string is accepted and finds the start and end of each group (in group
+  // number order, -1 if the group did not participate), returns MATCH_UNKNOWN if the
+  // groups may differ from the groups found by Python
+  MatchVerdict match_groups(const string &str, vector <int> &spans);
+
+  // returns the number of capturing groups
+  unsigned int get_num_groups() { return groups.size(); }
+
+  // build a matcher for the union of the programs of the matchers, returns the
+  // indices of the matchers that were included (others make the program too large)
+  vector <unsigned int> build_union(const vector <Matcher *> &matchers);
+
+  // returns true if the regex contains backreferences
+  bool has_backreferences() { return has_backrefs; }
+
+  // finds the programs of a union that accept the string (index into the included
+  // matchers), returns false if the string cannot be decided
+  bool match_union(const string &str, vector <unsigned int> &accepting);
+
+  // partitions the strings into sorted lists of accepted, rejected, and undecided strings
+  void classify(const vector <string> &strings, vector <string> &accepted,
+      vector <string> &rejected, vector <string> &unknown);
+
+  // print the matcher program
+  void print();
+
+  // add matcher stats
+  void add_stats(Stats &stats);
+
+private:
+
+  vector <MatchState> states;		// program states
+  unsigned int initial;			// initial state
+  unsigned int final;			// final (accepting) state
+  vector <unsigned int> finals;		// final state of each program (union programs have several)
+  vector <bitset <256> > classes;	// character classes
+  vector <NFAGroup> groups;		// capturing groups (sorted by number)
+  map <RegexLoop *, pair <unsigned int, unsigned int> > loop_ends;	// NFA end loop edges
+  bool has_backrefs;			// true if program contains backreferences
+  bool exact_groups;			// true if the search finds the same groups as Python
+  bool supported;			// true if matcher can be used
+  BitMatcher bit_matcher;		// bit-parallel matcher (small programs without backreferences)
+  bool bit_parallel;			// true if bit-parallel matcher is used
+  DFA dfa;				// lazy DFA (larger programs without backreferences)
+
+  // stats
+  int num_accepted;
+  int num_rejected;
+  int num_unknown;
+  int num_group_matches;
+
+  // PROGRAM CONSTRUCTION FUNCTIONS
+
+  // expands the portion of the NFA between entry and exit into new program states,
+  // returns the program states that correspond to entry and exit
+  pair <unsigned int, unsigned int> expand(NFA &nfa, unsigned int entry, unsigned int exit);
+
+  // returns program state for NFA state, creating it if necessary
+  unsigned int get_state(unsigned int state, map <unsigned int, unsigned int> &mapping);
+
+  // adds a new program state
+  unsigned int add_state();
+
+  // adds an edge to the program
+  void add_edge(unsigned int from, unsigned int to, MatchEdgeType type, int index = -1);
+
+  // adds a character class, returns its index
+  int add_class(CharSet *char_set);
+  int add_class(char c);
+  int add_class(const bitset <256> &char_class);
+
+  // adds edges that repeat the character class between lower and upper times
+  void add_repeat(unsigned int from, unsigned int to, int char_class, int lower, int upper,
+      bool lazy);
+
+  // adds copies of a loop body (NFA states entry to exit) between lower and upper times
+  void add_loop(NFA &nfa, unsigned int from, unsigned int to, unsigned int entry,
+      unsigned int exit, int lower, int upper, bool lazy);
+
+  // clears exact_groups if an optional iteration of the loop body (program states starting
+  // at body_start) can be empty and contains captures
+  void check_empty_iteration(unsigned int body_start, pair <unsigned int, unsigned int> body);
+
+  // returns true if program state exit can be reached from entry without consuming characters
+  bool is_nullable(unsigned int entry, unsigned int exit);
+
+  // MATCHING FUNCTIONS
+
+  // Pike VM simulation (no backreferences)
+  bool simulate(const string &str);
+
+  // bounded backtracking search (supports backreferences), also finds the group captures
+  MatchVerdict backtrack(const string &str, vector <int> &captures);
+
+  // returns true if an empty edge can be traversed at pos
+  bool can_traverse(const MatchEdge &edge, const string &str, unsigned int pos);
+};
+
+#endif // MATCHER_H
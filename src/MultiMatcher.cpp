@@ -0,0 +1,84 @@
+/*  MultiMatcher.cpp: Classifies strings against several regexes at once
+
+    Copyright (C) 2016-2018  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <string>
+#include <vector>
+#include "Matcher.h"
+#include "MultiMatcher.h"
+#include "Stats.h"
+using namespace std;
+
+void
+MultiMatcher::build(const vector <Matcher *> &m)
+{
+  matchers = m;
+  num_strings = 0;
+  num_single_pass = 0;
+
+  vector <Matcher *> candidates;
+  vector <unsigned int> candidate_regexes;
+  for (unsigned int i = 0; i < matchers.size(); i++) {
+    if (matchers[i] == NULL) continue;
+    candidates.push_back(matchers[i]);
+    candidate_regexes.push_back(i);
+  }
+
+  vector <unsigned int> included = combined.build_union(candidates);
+  combined_regexes.clear();
+  for (unsigned int i = 0; i < included.size(); i++) {
+    combined_regexes.push_back(candidate_regexes[included[i]]);
+  }
+}
+
+void
+MultiMatcher::match(const string &str, vector <MatchVerdict> &verdicts)
+{
+  verdicts.assign(matchers.size(), MATCH_UNKNOWN);
+  num_strings++;
+
+  // one pass over the string for the combined regexes
+  vector <unsigned int> accepting;
+  if (!combined_regexes.empty() && combined.match_union(str, accepting)) {
+    for (unsigned int i = 0; i < combined_regexes.size(); i++) {
+      verdicts[combined_regexes[i]] = MATCH_REJECT;
+    }
+    for (unsigned int i = 0; i < accepting.size(); i++) {
+      verdicts[combined_regexes[accepting[i]]] = MATCH_ACCEPT;
+    }
+    num_single_pass++;
+  }
+
+  // everything else uses the matcher of the regex
+  for (unsigned int i = 0; i < matchers.size(); i++) {
+    if (matchers[i] != NULL && verdicts[i] == MATCH_UNKNOWN) {
+      verdicts[i] = matchers[i]->match(str);
+    }
+  }
+}
+
+void
+MultiMatcher::add_stats(Stats &stats)
+{
+  stats.add("MULTI", "Regexes", matchers.size());
+  stats.add("MULTI", "Combined regexes", combined_regexes.size());
+  stats.add("MULTI", "Strings", num_strings);
+  stats.add("MULTI", "Single pass strings", num_single_pass);
+}
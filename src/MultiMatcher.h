@@ -0,0 +1,63 @@
+/*  MultiMatcher.h: Classifies strings against several regexes at once
+
+    Copyright (C) 2016-2018  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// The programs of the regexes are combined into a single union program that
+// is matched with a lazy DFA whose states record which regexes accept, so a
+// string is classified against all of the combined regexes in one pass.
+// Regexes that cannot be combined (backreferences, or a union that would be
+// too large) and strings the DFA cannot decide use the matcher of the regex.
+
+#ifndef MULTI_MATCHER_H
+#define MULTI_MATCHER_H
+
+#include <string>
+#include <vector>
+#include "Matcher.h"
+#include "Stats.h"
+using namespace std;
+
+class MultiMatcher {
+
+public:
+
+  MultiMatcher() { num_strings = 0; num_single_pass = 0; }
+
+  // build the combined matcher from the matcher of each regex (NULL if regex has errors)
+  void build(const vector <Matcher *> &m);
+
+  // determines the verdict of each regex for the string (MATCH_UNKNOWN for NULL matchers)
+  void match(const string &str, vector <MatchVerdict> &verdicts);
+
+  // add multi-regex matcher stats
+  void add_stats(Stats &stats);
+
+private:
+
+  vector <Matcher *> matchers;		// matcher for each regex
+  Matcher combined;			// matcher for the union of the combined regexes
+  vector <unsigned int> combined_regexes;	// regex for each program in the union
+
+  // stats
+  int num_strings;
+  int num_single_pass;
+};
+
+#endif // MULTI_MATCHER_H
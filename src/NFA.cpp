@@ -32,13 +32,15 @@
 using namespace std;
 
 // TODO: No location information for epsilon edge.  OK?
-static Edge EPSILON = Edge(EPSILON_EDGE);
+// (one per thread since processing the paths marks the edge)
+static thread_local Edge EPSILON = Edge(EPSILON_EDGE);
 
 NFA::NFA(unsigned int _size, unsigned int _initial, unsigned int  _final)
 {
   size = _size;
   initial = _initial;
   final = _final;
+  ignored = false;
 
   assert(initial < size);
   assert(final < size);
@@ -56,6 +58,8 @@ NFA::NFA(const NFA &other)
   initial = other.initial;
   final = other.final;
   edge_table = other.edge_table;
+  groups = other.groups;
+  ignored = other.ignored;
 }
 
 NFA &
@@ -68,6 +72,8 @@ NFA::operator=(const NFA & other)
   final = other.final;
   size = other.size;
   edge_table = other.edge_table;
+  groups = other.groups;
+  ignored = other.ignored;
 
   return *this;
 }
@@ -75,52 +81,120 @@ NFA::operator=(const NFA & other)
 void
 NFA::build(ParseTree &tree)
 {
-  // Build NFA
-  NFA nfa = build_nfa_from_tree(tree.get_root());
+  // Build NFA (ignored flag is set while building)
+  ignored = false;
+  NFA nfa = build_nfa_from_tree(tree);
 
   // Copy NFA
   initial = nfa.initial;
   final = nfa.final;
   size = nfa.size;
   edge_table = nfa.edge_table;
+  groups = nfa.groups;
 }
 
 NFA
-NFA::build_nfa_from_tree(ParseNode *tree)
+NFA::build_nfa_from_tree(ParseTree &tree)
 {
-  assert(tree);
+  assert(tree.get_root() != NO_NODE);
+
+  // The tree is walked in postorder with an explicit stack (a node is visited
+  // again once its children are built), and the NFAs of the children are on
+  // top of the results when their parent is built.
+  vector <pair <unsigned int, bool> > stack;	// node, set if children are built
+  vector <NFA> results;
+  stack.push_back(make_pair(tree.get_root(), false));
+
+  while (!stack.empty()) {
+    const ParseNode &node = tree.get_node(stack.back().first);
+    bool children_built = stack.back().second;
+
+    if (!children_built) {
+      stack.back().second = true;
+      switch (node.get_type()) {
+      case ALTERNATION_NODE:
+      case CONCAT_NODE:
+        stack.push_back(make_pair(node.right, false));
+        stack.push_back(make_pair(node.left, false));
+        continue;
+      case REPEAT_NODE:
+        // regex strings are built without the repeated node
+        if (is_regex_string(tree, node)) break;
+        stack.push_back(make_pair(node.left, false));
+        continue;
+      case GROUP_NODE:
+        stack.push_back(make_pair(node.left, false));
+        continue;
+      default:
+        break;
+      }
+    }
 
-  switch (tree->type) {
+    stack.pop_back();
+    build_nfa_node(tree, node, results);
+  }
 
-  case ALTERNATION_NODE:
-    return build_nfa_alternation(tree);
+  assert(results.size() == 1);
+  return move(results.back());
+}
 
+void
+NFA::build_nfa_node(ParseTree &tree, const ParseNode &node, vector <NFA> &results)
+{
+  switch (node.get_type()) {
+
+  case ALTERNATION_NODE:
   case CONCAT_NODE:
-    return build_nfa_concat(tree);
+  {
+    NFA nfa2 = move(results.back());
+    results.pop_back();
+    NFA nfa1 = move(results.back());
+    results.pop_back();
+    if (node.get_type() == ALTERNATION_NODE) {
+      results.push_back(build_nfa_alternation(nfa1, nfa2));
+    }
+    else {
+      results.push_back(concat_nfa(move(nfa1), move(nfa2)));
+    }
+    break;
+  }
 
   case REPEAT_NODE:
-    return build_nfa_repeat(tree);
+    if (is_regex_string(tree, node)) {
+      results.push_back(build_nfa_string(tree, node));
+    }
+    else {
+      build_nfa_repeat(tree, node, results.back());
+    }
+    break;
 
   case GROUP_NODE:
-    return build_nfa_group(tree);
+    build_nfa_group(tree, node, results.back());
+    break;
 
   case CHARACTER_NODE:
-    return build_nfa_character(tree);
+    results.push_back(build_nfa_character(node));
+    break;
 
   case CARET_NODE:
-    return build_nfa_caret(tree);
+    results.push_back(build_nfa_caret(node));
+    break;
 
   case DOLLAR_NODE:
-    return build_nfa_dollar(tree);
+    results.push_back(build_nfa_dollar(node));
+    break;
 
   case CHAR_SET_NODE:
-    return build_nfa_char_set(tree);
+    results.push_back(build_nfa_char_set(tree, node));
+    break;
 
   case IGNORED_NODE:
-    return build_nfa_ignored(tree);
+    results.push_back(build_nfa_ignored(node));
+    break;
 
   case BACKREFERENCE_NODE:
-    return build_nfa_backreference(tree);
+    results.push_back(build_nfa_backreference(tree, node));
+    break;
 
   default:
     throw EgretException("ERROR (internal): Invalid node type in parse tree");
@@ -128,11 +202,8 @@ NFA::build_nfa_from_tree(ParseNode *tree)
 }
 
 NFA
-NFA::build_nfa_alternation(ParseNode *tree)
+NFA::build_nfa_alternation(NFA &nfa1, NFA &nfa2)
 {
-  NFA nfa1 = build_nfa_from_tree(tree->left);
-  NFA nfa2 = build_nfa_from_tree(tree->right);
-
   // How this is done: the new nfa must contain all the states in
   // nfa1 and nfa2, plus new initial and final states.
   // First will come the new initial state, then nfa1's states, then
@@ -166,26 +237,11 @@ NFA::build_nfa_alternation(ParseNode *tree)
   return new_nfa;
 }
 
-NFA
-NFA::build_nfa_concat(ParseNode *tree)
-{
-  NFA nfa1 = build_nfa_from_tree(tree->left);
-  NFA nfa2 = build_nfa_from_tree(tree->right);
-  return concat_nfa(nfa1, nfa2);
-}
-
-NFA
-NFA::build_nfa_repeat(ParseNode *tree)
+void
+NFA::build_nfa_repeat(ParseTree &tree, const ParseNode &node, NFA &nfa)
 {
-  int repeat_lower = tree->repeat_lower;
-  int repeat_upper = tree->repeat_upper;
-
-  // if repeat represents a string, build a regex string instead
-  if (is_regex_string(tree->left, repeat_lower, repeat_upper))
-    return build_nfa_string(tree);
-
-  // create NFA for repeated segment
-  NFA nfa = build_nfa_from_tree(tree->left);
+  int repeat_lower = tree.get_repeat_lower(node);
+  int repeat_upper = tree.get_repeat_upper(node);
 
   // make room for the new initial state
   nfa.shift_states(1);
@@ -194,90 +250,95 @@ NFA::build_nfa_repeat(ParseNode *tree)
   nfa.append_empty_state();
 
   // create new loop
-  RegexLoop *regex_loop = new RegexLoop(repeat_lower, repeat_upper);
+  RegexLoop *regex_loop = new RegexLoop(repeat_lower, repeat_upper, node.lazy);
 
   // Util new edges
-  Edge *edge = new Edge(BEGIN_LOOP_EDGE, tree->loc, regex_loop);
+  Edge *edge = new Edge(BEGIN_LOOP_EDGE, node.get_loc(), regex_loop);
   nfa.add_edge(0, nfa.initial, edge);	   // new initial to old initial
-  edge = new Edge(END_LOOP_EDGE, tree->loc, regex_loop);
+  edge = new Edge(END_LOOP_EDGE, node.get_loc(), regex_loop);
   nfa.add_edge(nfa.final, nfa.size - 1, edge); // old final to new final
 
   // update states
   nfa.initial = 0;
   nfa.final = nfa.size - 1;
-
-  return nfa;
 }
 
 NFA
-NFA::build_nfa_string(ParseNode *tree)
+NFA::build_nfa_string(ParseTree &tree, const ParseNode &node)
 {
   NFA nfa(2, 0, 1);
-  RegexString *regex_str =
-    new RegexString(tree->left->char_set, tree->repeat_lower, tree->repeat_upper);
-  Location loc = make_pair(tree->left->loc.first, tree->loc.second);
+  const ParseNode &left = tree.get_node(node.left);
+  RegexString *regex_str = new RegexString(tree.get_char_set(left),
+      tree.get_repeat_lower(node), tree.get_repeat_upper(node), node.lazy);
+  Location loc = make_pair((int) left.start, (int) node.end);
   Edge *edge = new Edge(STRING_EDGE, loc, regex_str);
   nfa.add_edge(0, 1, edge);
 
   return nfa;
 }
 
-NFA
-NFA::build_nfa_group(ParseNode *tree)
+void
+NFA::build_nfa_group(ParseTree &tree, const ParseNode &node, NFA &nfa)
 {
-  return build_nfa_from_tree(tree->left);
+  // record the states of capturing groups
+  if (tree.get_group_num(node) != -1) {
+    NFAGroup group = { tree.get_group_num(node), tree.get_group_name(node), node.get_loc(),
+      nfa.initial, nfa.final };
+    nfa.groups.push_back(group);
+  }
 }
 
 
 NFA
-NFA::build_nfa_character(ParseNode *tree)
+NFA::build_nfa_character(const ParseNode &node)
 {
   NFA nfa(2, 0, 1);	// size = 2, initial = 0 , final = 1
-  Edge *edge = new Edge(CHARACTER_EDGE, tree->loc, tree->character);
+  Edge *edge = new Edge(CHARACTER_EDGE, node.get_loc(), node.character);
   nfa.add_edge(0, 1, edge);
   return nfa;
 }
 
 NFA
-NFA::build_nfa_caret(ParseNode *tree)
+NFA::build_nfa_caret(const ParseNode &node)
 {
   NFA nfa(2, 0, 1);	// size = 2, initial = 0 , final = 1
-  Edge *edge = new Edge(CARET_EDGE, tree->loc);
+  Edge *edge = new Edge(CARET_EDGE, node.get_loc());
   nfa.add_edge(0, 1, edge);
   return nfa;
 }
 
 NFA
-NFA::build_nfa_dollar(ParseNode *tree)
+NFA::build_nfa_dollar(const ParseNode &node)
 {
   NFA nfa(2, 0, 1);	// size = 2, initial = 0 , final = 1
-  Edge *edge = new Edge(DOLLAR_EDGE, tree->loc);
+  Edge *edge = new Edge(DOLLAR_EDGE, node.get_loc(), node.character);
   nfa.add_edge(0, 1, edge);
   return nfa;
 }
 
 NFA
-NFA::build_nfa_char_set(ParseNode *tree)
+NFA::build_nfa_char_set(ParseTree &tree, const ParseNode &node)
 {
   NFA nfa(2, 0, 1);     // size = 2, initial = 0, final = 1
-  Edge *edge = new Edge(CHAR_SET_EDGE, tree->loc, tree->char_set);
+  Edge *edge = new Edge(CHAR_SET_EDGE, node.get_loc(), tree.get_char_set(node));
   nfa.add_edge(0, 1, edge);
   return nfa;
 }
 
 NFA
-NFA::build_nfa_ignored(ParseNode *tree)
+NFA::build_nfa_ignored(const ParseNode &node)
 {
   NFA nfa(2, 0, 1);	// size = 2, initial = 0 , final = 1
   nfa.add_edge(0, 1, &EPSILON);
+  ignored = true;
   return nfa;
 }
 
 NFA
-NFA::build_nfa_backreference(ParseNode *tree)
+NFA::build_nfa_backreference(ParseTree &tree, const ParseNode &node)
 {
   NFA nfa(2, 0, 1);     // size = 2, initial = 0, final = 1
-  Edge *edge = new Edge(BACKREFERENCE_EDGE, tree->loc, tree->backref);
+  Edge *edge = new Edge(BACKREFERENCE_EDGE, node.get_loc(), tree.get_backref(node));
   nfa.add_edge(0, 1, edge);
   return nfa;
 }
@@ -339,6 +400,13 @@ NFA::shift_states(unsigned int shift)
   initial += shift;
   final += shift;
   edge_table = new_edge_table;
+
+  // update the group states
+  vector <NFAGroup>::iterator it;
+  for (it = groups.begin(); it != groups.end(); it++) {
+    it->initial += shift;
+    it->final += shift;
+  }
 }
 
 // fills states from other's states
@@ -351,6 +419,7 @@ NFA::fill_states(const NFA &other)
       edge_table[i][j] = other.edge_table[i][j];
     }
   }
+  groups.insert(groups.end(), other.groups.begin(), other.groups.end());
 }
 
 void
@@ -368,17 +437,21 @@ NFA::append_empty_state()
 }
 
 bool
-NFA::is_regex_string(ParseNode *node, int repeat_lower, int repeat_upper)
+NFA::is_regex_string(ParseTree &tree, const ParseNode &node)
 {
+  const ParseNode &left = tree.get_node(node.left);
+  int repeat_lower = tree.get_repeat_lower(node);
+  int repeat_upper = tree.get_repeat_upper(node);
+
   // Conditions for a string:
   // - Must be a repeated character set node
   // - Must be a * or + meaning that lower is 0 or 1, upper is -1 (no limit)
   // - Character set node must contain sufficient selections for a string
   //
-  if (node->type != CHAR_SET_NODE) return false;
+  if (left.get_type() != CHAR_SET_NODE) return false;
   if (repeat_upper != -1) return false;
   if (repeat_lower != 0 && repeat_lower != 1) return false;
-  if (!(node->char_set->is_string_candidate())) return false;
+  if (!(tree.get_char_set(left)->is_string_candidate())) return false;
 
   return true;
 }
@@ -399,6 +472,16 @@ NFA::find_basis_paths()
   return paths;
 }
 
+void
+NFA::clear_processed()
+{
+  for (unsigned int from = 0; from < size; from++) {
+    for (unsigned int to = 0; to < size; to++) {
+      if (edge_table[from][to] != NULL) edge_table[from][to]->clear_processed();
+    }
+  }
+}
+
 void
 NFA::traverse(unsigned int curr_state, Path path, vector <Path> &paths,
     bool *visited)
@@ -33,14 +33,25 @@
 #include "Stats.h"
 using namespace std;
 
+// A capturing group within the NFA (used by the matcher)
+struct NFAGroup {
+  int number;			// group number
+  string name;			// group name (blank if unnamed)
+  Location loc;			// location of group within regex
+  unsigned int initial;		// state that begins the group
+  unsigned int final;		// state that ends the group
+};
+
 class NFA {
 
 public:
 
-  NFA() {}
+  NFA() { ignored = false; }
   NFA(unsigned int _size, unsigned int _initial, unsigned int _final);
   NFA(const NFA &other);
+  NFA(NFA &&other) = default;
   NFA &operator= (const NFA &other);
+  NFA &operator= (NFA &&other) = default;
 
   // build an NFA from the parse tree
   void build(ParseTree &tree);
@@ -48,6 +59,17 @@ public:
   // create a set of basis paths
   vector <Path> find_basis_paths();
 
+  // marks every edge as unprocessed so the paths can be processed again
+  void clear_processed();
+
+  // accessors - used by the matcher
+  unsigned int get_size() { return size; }
+  unsigned int get_initial() { return initial; }
+  unsigned int get_final() { return final; }
+  Edge *get_edge(unsigned int from, unsigned int to) { return edge_table[from][to]; }
+  vector <NFAGroup> get_groups() { return groups; }
+  bool has_ignored_elements() { return ignored; }
+
   // print out the NFA
   void print();
 
@@ -60,42 +82,44 @@ private:
   unsigned int initial;			// initial state
   unsigned int final;			// final state
   vector <vector <Edge *> > edge_table;	// edge table
+  vector <NFAGroup> groups;		// capturing groups
+  bool ignored;				// true if regex has ignored elements
   
   // builds an NFA from tree
-  NFA build_nfa_from_tree(ParseNode *tree);
+  NFA build_nfa_from_tree(ParseTree &tree);
 
-  // builds an alternation of nfa1 and nfa2 (nfa1|nfa2)
-  NFA build_nfa_alternation(ParseNode *tree);
+  // builds an NFA for a node from the NFAs of its children (on top of results)
+  void build_nfa_node(ParseTree &tree, const ParseNode &node, vector <NFA> &results);
 
-  // builds a concatenation of nfa1 and nfa2 (nfa1nfa2)
-  NFA build_nfa_concat(ParseNode *tree);
+  // builds an alternation of nfa1 and nfa2 (nfa1|nfa2)
+  NFA build_nfa_alternation(NFA &nfa1, NFA &nfa2);
 
-  // builds nfa{m,n}
-  NFA build_nfa_repeat(ParseNode *tree);
+  // builds nfa{m,n} (in place)
+  void build_nfa_repeat(ParseTree &tree, const ParseNode &node, NFA &nfa);
 
   // builds special node for regex strings such as .+ or \w*
-  NFA build_nfa_string(ParseNode *tree);
+  NFA build_nfa_string(ParseTree &tree, const ParseNode &node);
 
-  // builds (nfa)
-  NFA build_nfa_group(ParseNode *tree);
+  // builds (nfa) (in place)
+  void build_nfa_group(ParseTree &tree, const ParseNode &node, NFA &nfa);
 
   // builds nfa with character
-  NFA build_nfa_character(ParseNode *tree);
+  NFA build_nfa_character(const ParseNode &node);
 
   // builds nfa with caret
-  NFA build_nfa_caret(ParseNode *tree);
+  NFA build_nfa_caret(const ParseNode &node);
 
   // builds nfa with dollar
-  NFA build_nfa_dollar(ParseNode *tree);
+  NFA build_nfa_dollar(const ParseNode &node);
 
   // builds nfa with char set as input
-  NFA build_nfa_char_set(ParseNode *tree);
+  NFA build_nfa_char_set(ParseTree &tree, const ParseNode &node);
 
   // builds nfa with ignored element
-  NFA build_nfa_ignored(ParseNode *tree);
+  NFA build_nfa_ignored(const ParseNode &node);
 
   // builds nfa with backreference
-  NFA build_nfa_backreference(ParseNode *tree);
+  NFA build_nfa_backreference(ParseTree &tree, const ParseNode &node);
 
   // adds an edge to edge table
   void add_edge(unsigned int from, unsigned int to, Edge *edge);
@@ -112,8 +136,8 @@ private:
   // appends a new empty state to the NFA
   void append_empty_state();
 
-  // returns true if repeat quantifier represents a string
-  bool is_regex_string(ParseNode *node, int repeat_lower, int repeat_upper);
+  // returns true if a repeat node represents a string
+  bool is_regex_string(ParseTree &tree, const ParseNode &node);
 
   // utility function to find all paths through the NFA
   void traverse(unsigned int curr_state, Path path, vector <Path> &paths,
@@ -27,6 +27,7 @@
 #include <sstream>
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include "Backref.h"
 #include "CharSet.h"
 #include "ParseTree.h"
@@ -40,95 +41,165 @@ using namespace std;
 //=============================================================
 
 void
-ParseTree::build(Scanner &_scanner)
+ParseTree::build(Scanner &_scanner, unsigned int max_depth)
 {
   group_count = 1;
-
-  scanner = _scanner;
-  root = expr();
+  nodes.clear();
+  char_sets.clear();
+  backrefs.clear();
+  repeats.clear();
+  groups.clear();
+
+  scanner = &_scanner;
+  root = parse(max_depth);
   
-  if (scanner.get_type() != ERR) {
+  if (scanner->get_type() != ERR) {
     stringstream s;
-    s << "ERROR (parse error): expected end of regex but received " << scanner.get_type_str();
+    s << "ERROR (parse error): expected end of regex but received " << scanner->get_type_str();
     throw EgretException(s.str());
   }
   // count_groups();
 }
 
+// Parses the regex, the bottom frame of the stack is the whole regex and each
+// group being parsed has a frame above it.  An expr ends when its last clause
+// is not followed by '|', and when a group's expr ends the group becomes the
+// atom of a rep in the enclosing frame.
+unsigned int
+ParseTree::parse(unsigned int max_depth)
+{
+  vector <ParseFrame> frames(1);
+  bool expr_start = true;	// set at the start of an expr
+
+  while (true) {
+
+    // an expr that starts with '|' has an empty first clause
+    if (!expr_start || scanner->get_type() != ALTERNATION) {
+
+      // parse the atom of a rep, the expr of a group is parsed first
+      unsigned int atom_node;
+      if (scanner->get_type() == LEFT_PAREN) {
+        if (frames.size() > max_depth) {
+          stringstream s;
+          s << "ERROR (parse error): groups are nested more than " << max_depth << " deep";
+          throw EgretException(s.str());
+        }
+        frames.push_back(open_group());
+        if (!frames.back().ignored_group || scanner->get_type() != RIGHT_PAREN) {
+          expr_start = true;
+          continue;
+        }
+        atom_node = close_group(frames.back(), NO_NODE);
+        frames.pop_back();
+      }
+      else {
+        atom_node = atom();
+      }
+      frames.back().reps.push_back(rep(atom_node));
+      expr_start = false;
+
+      // check for concatenation
+      if (scanner->is_concat()) continue;
+    }
+
+    // end the clause (and the exprs and groups that end with it)
+    while (true) {
+      ParseFrame &frame = frames.back();
+      unsigned int clause = concat(frame.reps);
+
+      // check for alternation
+      if (scanner->get_type() == ALTERNATION) {
+        frame.clauses.push_back(clause);
+        frame.bars.push_back(scanner->get_loc());
+        scanner->advance();
+
+        // check for lacking right
+        if (scanner->get_type() != RIGHT_PAREN && scanner->get_type() != ERR) {
+          expr_start = true;
+          break;
+        }
+        clause = NO_NODE;
+      }
+
+      unsigned int expr_node = expr(frame, clause);
+      if (frames.size() == 1) return expr_node;
+
+      unsigned int group_node = close_group(frame, expr_node);
+      frames.pop_back();
+      frames.back().reps.push_back(rep(group_node));
+
+      // check for concatenation
+      if (scanner->is_concat()) {
+        expr_start = false;
+        break;
+      }
+    }
+  }
+}
+
 // expr ::= concat '|' expr
 //	|   concat '|'
 //	|   '|' expr
 //	|   '|'
 //      |   concat
 //
-ParseNode *
-ParseTree::expr()
+// Folds the previous clauses of the frame and its last clause (NO_NODE if
+// lacking) into an expr, starting from the right.
+//
+unsigned int
+ParseTree::expr(ParseFrame &frame, unsigned int last)
 {
-  ParseNode *left, *right;
-
-  // check for alternation without a "left"
-  if (scanner.get_type() == ALTERNATION) {
-    left = NULL;
-  } else {
-    left = concat();
-  }
-
-  // check for lack of alternation
-  if (scanner.get_type() != ALTERNATION) {
-    return left;
-  }
+  unsigned int right = last;
 
-  // advance past alternation token
-  Location loc = scanner.get_loc();
-  scanner.advance();
+  for (int i = frame.clauses.size() - 1; i >= 0; i--) {
+    unsigned int left = frame.clauses[i];
+    Location loc = frame.bars[i];
 
-  // check for lacking right
-  if (scanner.get_type() == RIGHT_PAREN || scanner.get_type() == ERR) {
-    right = NULL;
-  } else {
-    right = expr();
+    // check for empty alternation clauses
+    // both empty: abort with an error
+    if (left == NO_NODE && right == NO_NODE) {
+      throw EgretException("ERROR (pointless alternation): both clauses are empty");
+    }
+    // left empty: return right? (lazy since the empty clause is tried first)
+    else if (left == NO_NODE) {
+      right = add_repeat_node(loc, right, 0, 1, true);
+    }
+    // right empty: return left?
+    else if (right == NO_NODE) {
+      right = add_repeat_node(loc, left, 0, 1, false);
+    }
+    // otherwise return left | right
+    else {
+      right = add_node(ALTERNATION_NODE, loc, left, right);
+    }
   }
 
-  // check for empty alternation clauses
-  // both empty: abort with an error
-  if (left == NULL && right == NULL) {
-    throw EgretException("ERROR (pointless alternation): both clauses are empty");
-  }
-  // left empty: return right?
-  else if (left == NULL) {
-    ParseNode *expr_node = new ParseNode(REPEAT_NODE, loc, right, 0, 1);
-    return expr_node;
-  }
-  // right empty: return left?
-  else if (right == NULL) {
-    ParseNode *expr_node = new ParseNode(REPEAT_NODE, loc, left, 0, 1);
-    return expr_node;
-  }
-  
-  // otherwise return left | right
-  ParseNode *expr_node = new ParseNode(ALTERNATION_NODE, loc, left, right);
-  return expr_node;
+  frame.clauses.clear();
+  frame.bars.clear();
+  return right;
 }
 
 // concat ::= rep concat
 //        |   rep
 //
-ParseNode *
-ParseTree::concat()
+// Folds the reps (and clears them) into a concat, starting from the right
+// (NO_NODE if there are none).
+//
+unsigned int
+ParseTree::concat(vector <unsigned int> &reps)
 {
-  // always a repetition node to the left
-  ParseNode *left = rep();
+  if (reps.empty()) return NO_NODE;
 
-  // check for concatenation
-  if (scanner.is_concat()) {
-    ParseNode *right = concat();
-    int left_loc = left->loc.second;
+  unsigned int right = reps.back();
+  for (int i = reps.size() - 2; i >= 0; i--) {
+    unsigned int left = reps[i];
+    int left_loc = nodes[left].end;
     Location loc = make_pair(left_loc, left_loc + 1);
-    ParseNode *concat_node = new ParseNode(CONCAT_NODE, loc, left, right);
-    return concat_node;
-  } else {
-    return left;
+    right = add_node(CONCAT_NODE, loc, left, right);
   }
+
+  reps.clear();
+  return right;
 }
 
 // rep  ::= atom '*'
@@ -138,63 +209,57 @@ ParseTree::concat()
 //      |   atom '{n,}'
 //      |   atom
 //
-ParseNode *
-ParseTree::rep()
+unsigned int
+ParseTree::rep(unsigned int atom_node)
 {
-  // first is always atom node
-  ParseNode *atom_node = atom();
-  Location loc = scanner.get_loc();
-
-  // then check for repetition character
-  if (scanner.get_type() == STAR) {
-    scanner.advance();
-    ParseNode *rep_node = new ParseNode(REPEAT_NODE, loc, atom_node, 0, -1);
-    return rep_node;
-  }
-  else if (scanner.get_type() == PLUS) {
-    scanner.advance();
-    ParseNode *rep_node = new ParseNode(REPEAT_NODE, loc, atom_node, 1, -1);
-    return rep_node;
-  }
-  else if (scanner.get_type() == QUESTION) {
-    scanner.advance();
-    ParseNode *rep_node = new ParseNode(REPEAT_NODE, loc, atom_node, 0, 1);
-    return rep_node;
-  }
-  else if (scanner.get_type() == REPEAT) {
-    int lower = scanner.get_repeat_lower();
-    int upper = scanner.get_repeat_upper();
-    scanner.advance();
-    ParseNode *rep_node = new ParseNode(REPEAT_NODE, loc, atom_node, lower, upper);
-    return rep_node;
+  Location loc = scanner->get_loc();
+
+  // check for repetition character
+  if (scanner->get_type() == STAR) {
+    bool lazy = scanner->is_lazy();
+    scanner->advance();
+    return add_repeat_node(loc, atom_node, 0, -1, lazy);
+  }
+  else if (scanner->get_type() == PLUS) {
+    bool lazy = scanner->is_lazy();
+    scanner->advance();
+    return add_repeat_node(loc, atom_node, 1, -1, lazy);
+  }
+  else if (scanner->get_type() == QUESTION) {
+    bool lazy = scanner->is_lazy();
+    scanner->advance();
+    return add_repeat_node(loc, atom_node, 0, 1, lazy);
+  }
+  else if (scanner->get_type() == REPEAT) {
+    int lower = scanner->get_repeat_lower();
+    int upper = scanner->get_repeat_upper();
+    bool lazy = scanner->is_lazy();
+    scanner->advance();
+    return add_repeat_node(loc, atom_node, lower, upper, lazy);
   }
   else {
     return atom_node;
   }
 }
 
-// atom	::= group
-// 	|   character
+// atom	::= character
 //	|   char_class
 // 	|   char_set
 //
-ParseNode *
+// (groups are parsed by parse)
+//
+unsigned int
 ParseTree::atom()
 {
-  ParseNode *atom_node;
-
-  // check for group
-  if (scanner.get_type() == LEFT_PAREN) {
-    atom_node = group();
-  }
+  unsigned int atom_node;
 
   // check for character set
-  else if (scanner.get_type() == LEFT_BRACKET) {
+  if (scanner->get_type() == LEFT_BRACKET) {
     atom_node = char_set();
   }
 
   // check for character class
-  else if (scanner.get_type() == CHAR_CLASS) {
+  else if (scanner->get_type() == CHAR_CLASS) {
     atom_node = char_class();
   }
 
@@ -212,80 +277,87 @@ ParseTree::atom()
 //       | '(' IGNORED_EXT expr ')'
 //       | '(' IGNORED_EXT ')'
 //
-ParseNode *
-ParseTree::group()
+// Starts a group: returns its frame with the scanner at the start of its expr.
+//
+ParseTree::ParseFrame
+ParseTree::open_group()
 {
-  bool ignored_group = false;
-  bool normal_group = true;
-  string name = "";
-  int start_loc = scanner.get_loc().second;
-
-  if (scanner.get_type() != LEFT_PAREN) {
+  ParseFrame frame;
+  frame.ignored_group = false;
+  frame.normal_group = true;
+  frame.name = "";
+  frame.start_loc = scanner->get_loc().second;
+  frame.first_node = nodes.size();
+
+  if (scanner->get_type() != LEFT_PAREN) {
     stringstream s;
-    s << "ERROR (parse error): expected '(' but received " << scanner.get_type_str();
+    s << "ERROR (parse error): expected '(' but received " << scanner->get_type_str();
     throw EgretException(s.str());
   }
-  scanner.advance();
+  scanner->advance();
 
   // Determine if it a special use of parentheses
-  if (scanner.get_type() == NO_GROUP_EXT) {
-    normal_group = false;
-    scanner.advance();
+  if (scanner->get_type() == NO_GROUP_EXT) {
+    frame.normal_group = false;
+    scanner->advance();
+  }
+  if (scanner->get_type() == NAMED_GROUP_EXT) {
+    frame.name = scanner->get_group_name();
+    scanner->advance();
   }
-  if (scanner.get_type() == NAMED_GROUP_EXT) {
-    name = scanner.get_group_name();
-    scanner.advance();
+  if (scanner->get_type() == IGNORED_EXT) {
+    frame.normal_group = false;
+    frame.ignored_group = true;
+    scanner->advance();
   }
-  if (scanner.get_type() == IGNORED_EXT) {
-    normal_group = false;
-    ignored_group = true;
-    scanner.advance();
+
+  // (?P=name) is a named backreference, not a capturing group
+  if (scanner->get_type() == BACKREFERENCE && scanner->get_group_num() == 0) {
+    frame.normal_group = false;
   }
 
   // Assign the group number now before advancing scanner
-  int group_num;
-  if (normal_group) {
-    group_num = group_count;
+  if (frame.normal_group) {
+    frame.group_num = group_count;
     group_count++;
   }
   else {
-    group_num = -1;
+    frame.group_num = -1;
   }
 
-  // Get the group expression
-  ParseNode *left;
-  if (!ignored_group || scanner.get_type() != RIGHT_PAREN) {
-    left = expr();
-  }
-  else {
-    left = NULL;
-  }
+  return frame;
+}
 
-  // Create the group node
-  ParseNode *group_node;
-  int end_loc = scanner.get_loc().first;
-  Location loc = make_pair(start_loc, end_loc);
-  if (ignored_group) {
-    group_node = new ParseNode(IGNORED_NODE, loc, NULL, NULL);
+// Ends a group given its expr (NO_NODE for an ignored group without one).
+unsigned int
+ParseTree::close_group(ParseFrame &frame, unsigned int left)
+{
+  // Create the group node (the expr of an ignored group is dropped)
+  unsigned int group_node;
+  int end_loc = scanner->get_loc().first;
+  Location loc = make_pair(frame.start_loc, end_loc);
+  if (frame.ignored_group) {
+    nodes.resize(frame.first_node);
+    group_node = add_node(IGNORED_NODE, loc, NO_NODE, NO_NODE);
   }
   else {
-    group_node = new ParseNode(GROUP_NODE, loc, name, left, NULL);
+    group_node = add_group_node(loc, frame.name, frame.group_num, left);
   }
 
   // Store group information
-  if (normal_group) {
-    group_locs[group_num] = loc;
-    if (name != "") {
-      named_group_locs[name] = loc;
+  if (frame.normal_group) {
+    group_locs[frame.group_num] = loc;
+    if (frame.name != "") {
+      named_group_locs[frame.name] = loc;
     }
   }
 
-  if (scanner.get_type() != RIGHT_PAREN) {
+  if (scanner->get_type() != RIGHT_PAREN) {
     stringstream s;
-    s << "ERROR (parse error): expected ')' but received " << scanner.get_type_str();
+    s << "ERROR (parse error): expected ')' but received " << scanner->get_type_str();
     throw EgretException(s.str());
   }
-  scanner.advance();
+  scanner->advance();
 
   return group_node;
 }
@@ -296,17 +368,17 @@ ParseTree::group()
 //	     |	 '-'
 //	     |   WORD_BOUNDARY
 //
-ParseNode *
+unsigned int
 ParseTree::character()
 {
-  ParseNode *character_node;
-  Location loc = scanner.get_loc();
-  TokenType type = scanner.get_type();
+  unsigned int character_node;
+  Location loc = scanner->get_loc();
+  TokenType type = scanner->get_type();
 
   if (type == CHARACTER) {
-    char c = scanner.get_character();
-    scanner.advance();
-    character_node =  new ParseNode(CHARACTER_NODE, loc, c);
+    char c = scanner->get_character();
+    scanner->advance();
+    character_node = add_character_node(loc, c);
     if (ispunct(c)) {
       if (punct_marks.find(c) == punct_marks.end()) {
         punct_marks.insert(c);
@@ -314,27 +386,30 @@ ParseTree::character()
     }
   }
   else if (type == CARET) {
-    scanner.advance();
-    return new ParseNode(CARET_NODE, loc, NULL, NULL);
+    scanner->advance();
+    return add_node(CARET_NODE, loc, NO_NODE, NO_NODE);
   }
   else if (type == DOLLAR) {
-    scanner.advance();
-    return new ParseNode(DOLLAR_NODE, loc, NULL, NULL);
+    char c = scanner->get_character();
+    scanner->advance();
+    unsigned int index = add_node(DOLLAR_NODE, loc, NO_NODE, NO_NODE);
+    nodes[index].character = c;
+    return index;
   }
   else if (type == HYPHEN) {
-    scanner.advance();
-    character_node =  new ParseNode(CHARACTER_NODE, loc, '-');
+    scanner->advance();
+    character_node = add_character_node(loc, '-');
     if (punct_marks.find('-') == punct_marks.end()) {
       punct_marks.insert('-');
     }
   }
   else if (type == WORD_BOUNDARY) {
-    scanner.advance();
-    return new ParseNode(IGNORED_NODE, loc, NULL, NULL);
+    scanner->advance();
+    return add_node(IGNORED_NODE, loc, NO_NODE, NO_NODE);
   }
   else if (type == BACKREFERENCE) {
-    int group_num = scanner.get_group_num();
-    string group_name = scanner.get_group_name();
+    int group_num = scanner->get_group_num();
+    string group_name = scanner->get_group_name();
     Location group_loc;
     if (group_name != "") {
       group_loc = named_group_locs[group_name];
@@ -344,12 +419,12 @@ ParseTree::character()
     }
 
     Backref *backref = new Backref(group_name, group_num, group_loc);
-    character_node = new ParseNode(BACKREFERENCE_NODE, loc, backref);
-    scanner.advance();
+    character_node = add_backref_node(loc, backref);
+    scanner->advance();
   }
   else {
     stringstream s;
-    s << "ERROR (parse error): expected character type but received " << scanner.get_type_str();
+    s << "ERROR (parse error): expected character type but received " << scanner->get_type_str();
     throw EgretException(s.str());
   }
 
@@ -358,12 +433,12 @@ ParseTree::character()
 
 // char_class ::= CHAR_CLASS
 //
-ParseNode *
+unsigned int
 ParseTree::char_class()
 {
-  Location loc = scanner.get_loc();
-  char c = scanner.get_character();
-  scanner.advance();
+  Location loc = scanner->get_loc();
+  char c = scanner->get_character();
+  scanner->advance();
 
   CharSet *char_set = new CharSet();
 
@@ -371,49 +446,53 @@ ParseTree::char_class()
   char_set_item.type = CHAR_CLASS_ITEM;
   char_set_item.character = c;
   char_set->add_item(char_set_item);
+  char_set->intern();
 
-  ParseNode *char_set_node = new ParseNode(CHAR_SET_NODE, loc, char_set);
-  return char_set_node;
+  return add_char_set_node(loc, char_set);
 }
 
 // char_set ::= '[' char_list ']'
 // 	    |   '[' '^' char_list ']'
 //
-ParseNode *
+unsigned int
 ParseTree::char_set()
 {
-  ParseNode *char_set_node;
+  unsigned int char_set_node;
   bool is_complement = false;
-  int start_loc = scanner.get_loc().second;
+  int start_loc = scanner->get_loc().second;
 
-  if (scanner.get_type() != LEFT_BRACKET) {
+  if (scanner->get_type() != LEFT_BRACKET) {
     stringstream s;
-    s << "ERROR (parse error): expected '[' but received " << scanner.get_type_str();
+    s << "ERROR (parse error): expected '[' but received " << scanner->get_type_str();
     throw EgretException(s.str());
   }
-  scanner.advance();
+  scanner->advance();
 
-  if (scanner.get_type() == CARET) {
+  if (scanner->get_type() == CARET) {
     is_complement = true;
-    scanner.advance();
+    scanner->advance();
   }
 
-  char_set_node = char_list(start_loc);
-  if (is_complement) char_set_node->char_set->set_complement(true);
-  if (char_set_node->char_set->is_single_char() && !is_complement) {
-    char c = char_set_node->char_set->get_valid_character();
-    delete char_set_node;
-    int end_loc = scanner.get_loc().first;
-    Location loc = make_pair(start_loc, end_loc);
-    char_set_node = new ParseNode(CHARACTER_NODE, loc, c);
+  CharSet *char_set = char_list();
+  int end_loc = scanner->get_loc().first;
+  Location loc = make_pair(start_loc, end_loc);
+  if (is_complement) char_set->set_complement(true);
+  if (char_set->is_single_char() && !is_complement) {
+    char c = char_set->get_valid_character();
+    delete char_set;
+    char_set_node = add_character_node(loc, c);
+  }
+  else {
+    char_set->intern();
+    char_set_node = add_char_set_node(loc, char_set);
   }
 
-  if (scanner.get_type() != RIGHT_BRACKET) {
+  if (scanner->get_type() != RIGHT_BRACKET) {
     stringstream s;
-    s << "ERROR (parse error): expected ']' but received " << scanner.get_type_str();
+    s << "ERROR (parse error): expected ']' but received " << scanner->get_type_str();
     throw EgretException(s.str());
   }
-  scanner.advance();
+  scanner->advance();
 
   return char_set_node;
 }
@@ -421,27 +500,24 @@ ParseTree::char_set()
 // char_list ::= list_item charlist
 // 	     |   list_item
 //
-ParseNode *
-ParseTree::char_list(int start_loc)
+CharSet *
+ParseTree::char_list()
 {
-  CharSetItem char_set_item = list_item();
-  ParseNode *char_set_node;
-  
-  // Check for end of list
-  if (scanner.get_type() == RIGHT_BRACKET) {
-    int end_loc = scanner.get_loc().first;
-    Location loc = make_pair(start_loc, end_loc);
-    char_set_node = new ParseNode(CHAR_SET_NODE, loc, new CharSet());
-  }
-  else {
-    char_set_node = char_list(start_loc);
-  }
+  // Collect the items up to the end of the list
+  vector <CharSetItem> items;
+  do {
+    items.push_back(list_item());
+  } while (scanner->get_type() != RIGHT_BRACKET);
 
-  char_set_node->char_set->add_item(char_set_item);
-  return char_set_node;
+  // Add the items starting from the end of the list
+  CharSet *char_set = new CharSet();
+  vector <CharSetItem>::reverse_iterator it;
+  for (it = items.rbegin(); it != items.rend(); it++) {
+    char_set->add_item(*it);
+  }
+  return char_set;
 }
 
-
 // list_item ::= character_item
 //           |   char_class_item
 //           |   char_range_item
@@ -449,10 +525,10 @@ ParseTree::char_list(int start_loc)
 CharSetItem
 ParseTree::list_item()
 {
-  if (scanner.is_char_range()) {
+  if (scanner->is_char_range()) {
     return char_range_item();
   }
-  else if (scanner.get_type() == CHAR_CLASS) {
+  else if (scanner->get_type() == CHAR_CLASS) {
     return char_class_item();
   }
   else {
@@ -471,26 +547,26 @@ ParseTree::character_item()
   CharSetItem char_set_item;
   char_set_item.type = CHARACTER_ITEM;
 
-  if (scanner.get_type() == CHARACTER) {
-    char c = scanner.get_character();
-    scanner.advance();
+  if (scanner->get_type() == CHARACTER) {
+    char c = scanner->get_character();
+    scanner->advance();
     char_set_item.character = c;
   }
-  else if (scanner.get_type() == CARET) {
-    scanner.advance();
+  else if (scanner->get_type() == CARET) {
+    scanner->advance();
     char_set_item.character = '^';
   }
-  else if (scanner.get_type() == DOLLAR) {
-    scanner.advance();
+  else if (scanner->get_type() == DOLLAR) {
+    scanner->advance();
     char_set_item.character = '$';
   }
-  else if (scanner.get_type() == HYPHEN) {
-    scanner.advance();
+  else if (scanner->get_type() == HYPHEN) {
+    scanner->advance();
     char_set_item.character = '-';
   }
   else {
     stringstream s;
-    s << "ERROR (parse error): expected character type but received " << scanner.get_type_str();
+    s << "ERROR (parse error): expected character type but received " << scanner->get_type_str();
     throw EgretException(s.str());
   }
   char c = char_set_item.character;
@@ -509,8 +585,8 @@ ParseTree::char_class_item()
 {
   CharSetItem char_set_item;
   char_set_item.type = CHAR_CLASS_ITEM;
-  char_set_item.character = scanner.get_character();
-  scanner.advance();
+  char_set_item.character = scanner->get_character();
+  scanner->advance();
   return char_set_item;
 }
 
@@ -523,34 +599,105 @@ ParseTree::char_range_item()
   char_set_item.type = CHAR_RANGE_ITEM;
 
   //TODO:  These seem like sanity checks - maybe assertions instead?
-  if (scanner.get_type() != CHARACTER) {
+  if (scanner->get_type() != CHARACTER) {
     stringstream s;
-    s << "ERROR (parse error): expected character type but received " << scanner.get_type_str();
+    s << "ERROR (parse error): expected character type but received " << scanner->get_type_str();
     throw EgretException(s.str());
   }
-  char start = scanner.get_character();
-  scanner.advance();
+  char start = scanner->get_character();
+  scanner->advance();
 
-  if (scanner.get_type() != HYPHEN) {
+  if (scanner->get_type() != HYPHEN) {
     stringstream s;
-    s << "ERROR (parse error): expected hyphen but received " << scanner.get_type_str();
+    s << "ERROR (parse error): expected hyphen but received " << scanner->get_type_str();
     throw EgretException(s.str());
   }
-  scanner.advance();
+  scanner->advance();
 
-  if (scanner.get_type() != CHARACTER) {
+  if (scanner->get_type() != CHARACTER) {
     stringstream s;
-    s << "ERROR (parse error): expected character type but received " << scanner.get_type_str();
+    s << "ERROR (parse error): expected character type but received " << scanner->get_type_str();
     throw EgretException(s.str());
   }
-  char end = scanner.get_character();
-  scanner.advance();
+  char end = scanner->get_character();
+  scanner->advance();
 
   char_set_item.range_start = start;
   char_set_item.range_end = end;
   return char_set_item;
 }
 
+//=============================================================
+// Node creation
+//=============================================================
+
+unsigned int
+ParseTree::add_node(NodeType t, Location loc, unsigned int left, unsigned int right)
+{
+  ParseNode node;
+  node.start = loc.first;
+  node.end = loc.second;
+  node.left = left;
+  node.right = right;
+  node.value = 0;
+  node.type = t;
+  node.character = '\0';
+  node.lazy = false;
+  nodes.push_back(node);
+  return nodes.size() - 1;
+}
+
+unsigned int
+ParseTree::add_character_node(Location loc, char c)
+{
+  unsigned int index = add_node(CHARACTER_NODE, loc, NO_NODE, NO_NODE);
+  nodes[index].character = c;
+  return index;
+}
+
+unsigned int
+ParseTree::add_char_set_node(Location loc, CharSet *char_set)
+{
+  unsigned int index = add_node(CHAR_SET_NODE, loc, NO_NODE, NO_NODE);
+  nodes[index].value = char_sets.size();
+  char_sets.push_back(char_set);
+  return index;
+}
+
+unsigned int
+ParseTree::add_backref_node(Location loc, Backref *backref)
+{
+  unsigned int index = add_node(BACKREFERENCE_NODE, loc, NO_NODE, NO_NODE);
+  nodes[index].value = backrefs.size();
+  backrefs.push_back(backref);
+  return index;
+}
+
+unsigned int
+ParseTree::add_repeat_node(Location loc, unsigned int left, int lower, int upper, bool lazy)
+{
+  unsigned int index = add_node(REPEAT_NODE, loc, left, NO_NODE);
+  nodes[index].value = repeats.size();
+  nodes[index].lazy = lazy;
+  ParseRepeat repeat = { lower, upper };
+  repeats.push_back(repeat);
+  return index;
+}
+
+unsigned int
+ParseTree::add_group_node(Location loc, string name, int num, unsigned int left)
+{
+  unsigned int index = add_node(GROUP_NODE, loc, left, NO_NODE);
+  nodes[index].value = groups.size();
+  ParseGroup group = { num, name };
+  groups.push_back(group);
+  return index;
+}
+
+//=============================================================
+// Printing and stats
+//=============================================================
+
 void
 ParseTree::print()
 {
@@ -560,15 +707,33 @@ ParseTree::print()
 }
 
 void
-ParseTree::print_tree(ParseNode *node, unsigned offset)
+ParseTree::print_tree(unsigned int root, unsigned offset)
 {
-  if (!node) return;
+  // nodes are printed in preorder, each with its offset
+  vector <pair <unsigned int, unsigned> > stack;
+  stack.push_back(make_pair(root, offset));
+
+  while (!stack.empty()) {
+    unsigned int index = stack.back().first;
+    offset = stack.back().second;
+    stack.pop_back();
+    if (index == NO_NODE) continue;
 
+    const ParseNode &node = nodes[index];
+    print_node(node, offset);
+    stack.push_back(make_pair(node.right, offset + 2));
+    stack.push_back(make_pair(node.left, offset + 2));
+  }
+}
+
+void
+ParseTree::print_node(const ParseNode &node, unsigned offset)
+{
   for (unsigned int i = 0; i < offset; i++)
     cout << " ";
 
   cout << "<";
-  switch (node->type) {
+  switch (node.get_type()) {
   case ALTERNATION_NODE:
     cout << "alternation |";
     break;
@@ -576,23 +741,23 @@ ParseTree::print_tree(ParseNode *node, unsigned offset)
     cout << "concat";
     break;
   case REPEAT_NODE:
-    if (node->repeat_upper == -1)
-      cout << "repeat {" << node->repeat_lower << ",}";
+    if (get_repeat_upper(node) == -1)
+      cout << "repeat {" << get_repeat_lower(node) << ",}";
     else 
-      cout << "repeat {" << node->repeat_lower << "," << node->repeat_upper << "}";
+      cout << "repeat {" << get_repeat_lower(node) << "," << get_repeat_upper(node) << "}";
     break;
   case GROUP_NODE:
     cout << "group"; 
     break;
   case BACKREFERENCE_NODE:
     cout << "backreference ";
-    node->backref->print();
+    get_backref(node)->print();
     break;
   case IGNORED_NODE:
     cout << "ignored";
     break;
   case CHARACTER_NODE:
-    cout << "character: " << node->character;
+    cout << "character: " << node.character;
     break;
   case CARET_NODE:
     cout << "caret ^";
@@ -602,24 +767,21 @@ ParseTree::print_tree(ParseNode *node, unsigned offset)
     break;
   case CHAR_SET_NODE:
     cout << "charset [";
-    node->char_set->print();
+    get_char_set(node)->print();
     cout << "]";
     break;
   default:
     assert(false);
   }
 
-  cout << " @ (" << node->loc.first << "," << node->loc.second <<  ")>" << endl;
-
-  print_tree(node->left, offset + 2);
-  print_tree(node->right, offset + 2);
+  cout << " @ (" << node.start << "," << node.end <<  ")>" << endl;
 }
 
 void
 ParseTree::add_stats(Stats &stats)
 {
   ParseTreeStats tree_stats = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-  gather_stats(root, tree_stats);
+  gather_stats(tree_stats);
   stats.add("PARSE_TREE", "Alternation nodes", tree_stats.alternation_nodes);
   stats.add("PARSE_TREE", "Concat nodes", tree_stats.concat_nodes);
   stats.add("PARSE_TREE", "Repeat nodes", tree_stats.repeat_nodes);
@@ -635,11 +797,20 @@ ParseTree::add_stats(Stats &stats)
 }
 
 void
-ParseTree::gather_stats(ParseNode *node, ParseTreeStats &tree_stats)
+ParseTree::gather_stats(ParseTreeStats &tree_stats)
 {
-  if (!node) return;
+  // every node in the array is in the tree (the nodes of ignored groups are
+  // dropped), so the nodes are counted in order
+  vector <ParseNode>::iterator it;
+  for (it = nodes.begin(); it != nodes.end(); it++) {
+    count_node(*it, tree_stats);
+  }
+}
 
-  switch (node->type) {
+void
+ParseTree::count_node(const ParseNode &node, ParseTreeStats &tree_stats)
+{
+  switch (node.get_type()) {
   case ALTERNATION_NODE:
     tree_stats.alternation_nodes++;
     break;
@@ -650,7 +821,7 @@ ParseTree::gather_stats(ParseNode *node, ParseTreeStats &tree_stats)
     tree_stats.repeat_nodes++;
     break;
   case GROUP_NODE:
-    if (node->group_name == "")
+    if (get_group_name(node) == "")
       tree_stats.unnamed_group_nodes++;
     else
       tree_stats.named_group_nodes++;
@@ -668,7 +839,7 @@ ParseTree::gather_stats(ParseNode *node, ParseTreeStats &tree_stats)
     tree_stats.dollar_nodes++;
     break;
   case CHAR_SET_NODE:
-    if (node->char_set->is_complement())
+    if (get_char_set(node)->is_complement())
       tree_stats.complement_char_set_nodes++;
     else
       tree_stats.normal_char_set_nodes++;
@@ -679,7 +850,4 @@ ParseTree::gather_stats(ParseNode *node, ParseTreeStats &tree_stats)
   default:
     assert(false);
   }
-
-  gather_stats(node->left, tree_stats);
-  gather_stats(node->right, tree_stats);
 }
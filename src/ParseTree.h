@@ -78,6 +78,12 @@
 //
 // char_range_item ::= CHARACTER '-' CHARACTER	(character range item)
 //
+// The parser follows the grammar but keeps the groups being parsed on an
+// explicit stack instead of recursing, and collects the reps of a concat and
+// the clauses of an expr in lists that are folded into the right recursive
+// nodes given by the grammar.  The tree walks also use explicit stacks, so a
+// long or deeply nested regex does not overflow the call stack.
+//
 
 #ifndef PARSE_TREE_H
 #define PARSE_TREE_H
@@ -85,12 +91,16 @@
 #include <set>
 #include <cassert>
 #include <unordered_map>
+#include <vector>
 #include "Scanner.h"
 #include "Backref.h"
 #include "CharSet.h"
 #include "Stats.h"
 using namespace std;
 
+// Default limit on how deeply groups can be nested
+static const unsigned int MAX_GROUP_DEPTH = 1000;
+
 typedef enum
 {
   ALTERNATION_NODE,
@@ -105,86 +115,61 @@ typedef enum
   IGNORED_NODE
 } NodeType;
 
+// A node of the parse tree: the nodes of a tree are stored in one array and
+// refer to their children by index, and the values only needed by a few node
+// types are kept in side tables of the tree (indexed by value)
 struct ParseNode
 {
-  ParseNode(NodeType t, Location _loc, ParseNode *l, ParseNode *r) {
-    type = t;
-    loc = _loc;
-    left = l;
-    right = r;
-    char_set = NULL;
-  }
-
-  ParseNode(NodeType t, Location _loc, string _name, ParseNode *l, ParseNode *r) {
-    assert(t == GROUP_NODE);
-    type = t;
-    loc = _loc;
-    group_name = _name;
-    left = l;
-    right = r;
-    char_set = NULL;
-  }
-
-  ParseNode(NodeType t, Location _loc, CharSet *c) {
-    assert(t == CHAR_SET_NODE);
-    type = t;
-    loc = _loc;
-    left = NULL;
-    right = NULL;
-    char_set = c;
-  }
-
-  ParseNode(NodeType t, Location _loc, char c) {
-    assert(t == CHARACTER_NODE);
-    type = t;
-    loc = _loc;
-    left = NULL;
-    right = NULL;
-    char_set = NULL;
-    character = c;
-  }
-
-  ParseNode(NodeType t, Location _loc, Backref *b) {
-    assert(t == BACKREFERENCE_NODE);
-    type = t;
-    loc = _loc;
-    left = NULL;
-    right = NULL;
-    backref = b;
-  }
-
-  ParseNode(NodeType t, Location _loc, ParseNode *l, int lower, int upper) {
-    assert(t == REPEAT_NODE);
-    type = t;
-    loc = _loc;
-    left = l;
-    right = NULL;
-    char_set = NULL;
-    repeat_lower = lower;
-    repeat_upper = upper;
-  }
-
-  NodeType type;
-  Location loc;
-  ParseNode *left;
-  ParseNode *right;
-  char character;	// For CHARACTER_NODE
-  CharSet *char_set;	// For CHAR_SET_NODE
-  int repeat_lower;	// For REPEAT_NODE
-  int repeat_upper;	// For REPEAT_NODE (-1 for no limit)
-  Backref *backref;     // For BACKREFERENCE_NODE
-  string group_name;    // For GROUP_NODE
+  unsigned int start;	// location in regular expression <start, end>
+  unsigned int end;
+  unsigned int left;	// index of left child (NO_NODE if none)
+  unsigned int right;	// index of right child (NO_NODE if none)
+  unsigned int value;	// For CHAR_SET_NODE, BACKREFERENCE_NODE, REPEAT_NODE, GROUP_NODE
+  unsigned char type;	// NodeType
+  char character;	// For CHARACTER_NODE (and DOLLAR_NODE: 'Z' for \Z)
+  bool lazy;		// For REPEAT_NODE (set if lazy)
+
+  NodeType get_type() const { return (NodeType) type; }
+  Location get_loc() const { return make_pair((int) start, (int) end); }
+};
+
+// index of a missing node
+static const unsigned int NO_NODE = 0xffffffff;
+
+// side table entries
+struct ParseRepeat
+{
+  int lower;
+  int upper;		// -1 for no limit
+};
+
+struct ParseGroup
+{
+  int num;		// -1 for non-capturing group
+  string name;
 };
 
 class ParseTree {
 
 public:
 
-  // build parse tree using regex stored in scanner
-  void build(Scanner &_scanner);
+  // build parse tree using regex stored in scanner (groups can be nested at most
+  // max_depth deep)
+  void build(Scanner &_scanner, unsigned int max_depth = MAX_GROUP_DEPTH);
 
   // get root of the tree
-  ParseNode *get_root() { return root; }
+  unsigned int get_root() { return root; }
+
+  // get a node of the tree
+  const ParseNode &get_node(unsigned int index) { return nodes[index]; }
+
+  // get the values of a node
+  CharSet *get_char_set(const ParseNode &node) { return char_sets[node.value]; }
+  Backref *get_backref(const ParseNode &node) { return backrefs[node.value]; }
+  int get_repeat_lower(const ParseNode &node) { return repeats[node.value].lower; }
+  int get_repeat_upper(const ParseNode &node) { return repeats[node.value].upper; }
+  int get_group_num(const ParseNode &node) { return groups[node.value].num; }
+  const string &get_group_name(const ParseNode &node) { return groups[node.value].name; }
 
   // get set of punctuation marks
   set<char> get_punct_marks() { return punct_marks; }
@@ -197,30 +182,59 @@ public:
 
 private:
 
-  ParseNode *root;		// root of parse tree
-  Scanner scanner;		// scanner
+  vector <ParseNode> nodes;	// nodes of parse tree
+  unsigned int root;		// index of root node
+  vector <CharSet *> char_sets;	// char sets of CHAR_SET_NODEs
+  vector <Backref *> backrefs;	// backreferences of BACKREFERENCE_NODEs
+  vector <ParseRepeat> repeats;	// bounds of REPEAT_NODEs
+  vector <ParseGroup> groups;	// groups of GROUP_NODEs
+  Scanner *scanner;		// scanner holding the tokens (borrowed, not copied)
   set<char> punct_marks;	// set of punctuation marks
   unordered_map<int, Location> group_locs;
   unordered_map<string, Location> named_group_locs;
   int group_count;
 
-  // creation functions
-  ParseNode *expr();
-  ParseNode *concat();
-  ParseNode *rep();
-  ParseNode *atom();
-  ParseNode *group();
-  ParseNode *character();
-  ParseNode *char_class();
-  ParseNode *char_set();
-  ParseNode *char_list(int start_loc);
+  // a group (or the whole regex) being parsed
+  struct ParseFrame {
+    int start_loc;			// location of '('
+    unsigned int first_node;		// index of the first node of the group
+    string name;			// group name (blank if unnamed)
+    int group_num;			// group number (-1 for non-capturing group)
+    bool normal_group;			// set for capturing groups
+    bool ignored_group;			// set for ignored extensions
+    vector <unsigned int> reps;		// reps of the current concat
+    vector <unsigned int> clauses;	// previous clauses of the expr (NO_NODE if empty)
+    vector <Location> bars;		// location of the '|' after each previous clause
+  };
+
+  // node creation functions (return the index of the new node)
+  unsigned int add_node(NodeType t, Location loc, unsigned int left, unsigned int right);
+  unsigned int add_character_node(Location loc, char c);
+  unsigned int add_char_set_node(Location loc, CharSet *char_set);
+  unsigned int add_backref_node(Location loc, Backref *backref);
+  unsigned int add_repeat_node(Location loc, unsigned int left, int lower, int upper, bool lazy);
+  unsigned int add_group_node(Location loc, string name, int num, unsigned int left);
+
+  // parsing functions
+  unsigned int parse(unsigned int max_depth);
+  unsigned int expr(ParseFrame &frame, unsigned int last);
+  unsigned int concat(vector <unsigned int> &reps);
+  unsigned int rep(unsigned int atom_node);
+  unsigned int atom();
+  ParseFrame open_group();
+  unsigned int close_group(ParseFrame &frame, unsigned int left);
+  unsigned int character();
+  unsigned int char_class();
+  unsigned int char_set();
+  CharSet *char_list();
   CharSetItem list_item();
   CharSetItem character_item();
   CharSetItem char_class_item();
   CharSetItem char_range_item();
 
   // print the tree
-  void print_tree(ParseNode *node, unsigned offset);
+  void print_tree(unsigned int root, unsigned offset);
+  void print_node(const ParseNode &node, unsigned offset);
 
   // gather stats
   struct ParseTreeStats {
@@ -237,7 +251,8 @@ private:
     int complement_char_set_nodes;
     int ignored_nodes;
   };
-  void gather_stats(ParseNode *node, ParseTreeStats &tree_stats);
+  void gather_stats(ParseTreeStats &tree_stats);
+  void count_node(const ParseNode &node, ParseTreeStats &tree_stats);
 
 };
 
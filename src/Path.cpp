@@ -28,6 +28,7 @@
 #include "Edge.h"
 #include "Path.h"
 #include "Util.h"
+#include "egret.h"
 using namespace std;
 
 // PATH CONSTRUCTION FUNCTIONS
@@ -63,6 +64,13 @@ Path::process_path()
   // Clear the string to start
   test_string.clear();
 
+  // The test string matches the regex if every edge matches its substring.
+  // Anchors must be outside of loops (the extra iterations are copies of the
+  // first one), the caret must be at the start and the dollar at the end.
+  valid = true;
+  vector <bool> outer_valid;		// validity outside each enclosing loop
+  int dollar_pos = -1;			// position of first dollar
+
   for (unsigned int i = 0; i < edges.size(); i++) {
     // An edge must be processed first before being added, the function returns
     // whether the edge is evil and more tests should be added later.
@@ -71,460 +79,399 @@ Path::process_path()
       evil_edges.push_back(i);
     }
 
-    // Add the substring to the initial string.
-    test_string.append(edges[i]->get_substring());
-  }
-}
-
-// CHECKER FUNCTIONS
-
-bool
-Path::has_leading_caret()
-{
-  for (unsigned int i = 0; i < edges.size(); i++) {
     switch (edges[i]->get_type()) {
-      case CARET_EDGE:
-	return true;
       case BEGIN_LOOP_EDGE:
+        outer_valid.push_back(valid);
+        valid = true;
+        break;
       case END_LOOP_EDGE:
-      case BACKREFERENCE_EDGE:
-      case EPSILON_EDGE:
-	break; // Skip over
+        edges[i]->get_regex_loop()->set_curr_valid(valid);
+        valid = valid && outer_valid.back();
+        outer_valid.pop_back();
+        break;
+      case CARET_EDGE:
+        if (!outer_valid.empty() || !test_string.empty()) valid = false;
+        break;
+      case DOLLAR_EDGE:
+        if (!outer_valid.empty()) valid = false;
+        else if (dollar_pos == -1) dollar_pos = test_string.size();
+        break;
       default:
-	return false;
+        if (!edges[i]->is_valid_substring()) valid = false;
+        break;
     }
+
+    // Add the substring to the initial string.
+    test_string.append(edges[i]->get_substring());
   }
-  return false;
+
+  if (dollar_pos != -1 && dollar_pos != (int) test_string.size()) valid = false;
 }
 
-bool
-Path::has_trailing_dollar()
+void
+Path::process_check_path(bool need_test_string)
 {
-  for (unsigned int i = edges.size() - 1; i > 0; i--) {
-    switch (edges[i]->get_type()) {
-      case DOLLAR_EDGE:
-	return true;
-      case BEGIN_LOOP_EDGE:
-      case END_LOOP_EDGE:
-      case BACKREFERENCE_EDGE:
-      case EPSILON_EDGE:
-	break; // Skip over
-      default:
-	return false;
+  // The loop and backreference substrings are found from the test string
+  if (!need_test_string) {
+    for (unsigned int i = 0; i < edges.size(); i++) {
+      if (edges[i]->get_type() == BACKREFERENCE_EDGE) need_test_string = true;
     }
   }
-  return false;
+
+  test_string.clear();
+  for (unsigned int i = 0; i < edges.size(); i++) {
+    edges[i]->process_check_edge(test_string, this);
+    if (need_test_string) test_string.append(edges[i]->get_substring());
+  }
 }
 
-bool
-Path::check_anchor_in_middle()
+// CHECKER FUNCTIONS
+
+void
+Path::check(PathCheck &result, unsigned int rules)
 {
+  // anchor usage
+  bool seen_edge = false;
+  result.leading_caret = false;
+  result.trailing_dollar = false;
+
+  // anchor in middle
+  bool anchor_middle_done = !(rules & CHECK_ANCHOR_MIDDLE);
   bool seen_non_caret = false;
-  bool seen_dollar = false; 
+  bool seen_dollar = false;
   Location seen_non_caret_loc;
   Location seen_dollar_loc;
 
+  // charsets: keeps track of charsets only containing punctuation, looking for duplicates
+  vector <string> charsets;
+  vector <Location> charset_locs;
+
+  // optional braces: ( ) { } [ ] (index 0 is the open brace, 1 is the closing brace)
+  const string braces[3] = { "()", "{}", "[]" };
+  bool prev_opt_repeat = false;
+  bool prev_opt_char = false;
+  Location prev_opt_loc;
+  char prev_opt_char_value = '\0';
+  bool opt_brace[3][2] = { { false, false }, { false, false }, { false, false } };
+  Location opt_brace_loc[3][2];
+
+  // repeat punctuation
+  bool prev_repeat = false;
+  bool prev_repeat_candidate = false;
+  char prev_repeat_char = '\0';
+  Location prev_repeat_loc;
+
+  // digit too optional (minimum iteration string is generated when first needed)
+  bool prev_zero_repeat = false;
+  bool prev_digit_candidate = false;
+  Location prev_digit_loc;
+  bool have_min_iter = false;
+  string min_iter;
+
   for (unsigned int i = 0; i < edges.size(); i++) {
-    switch (edges[i]->get_type()) {
-      case CARET_EDGE:
-	if (seen_non_caret) {
+    Edge *edge = edges[i];
+    EdgeType type = edge->get_type();
+    Location loc = edge->get_loc();
+    bool skipped = (type == BEGIN_LOOP_EDGE || type == END_LOOP_EDGE ||
+        type == BACKREFERENCE_EDGE || type == EPSILON_EDGE);
+
+    // Anchor usage: the first and last edges other than loops, backreferences,
+    // and epsilons (the first edge is never the last one)
+    if (!skipped) {
+      if (!seen_edge) result.leading_caret = (type == CARET_EDGE);
+      if (i > 0) result.trailing_dollar = (type == DOLLAR_EDGE);
+      seen_edge = true;
+    }
+
+    // Anchor in middle
+    if (!anchor_middle_done && !skipped) {
+      if (type == CARET_EDGE) {
+        if (seen_non_caret) {
           string msg = "Generated string has ^ anchor in the middle: " + test_string;
-          Alert a("anchor middle", msg, seen_non_caret_loc, edges[i]->get_loc());
-          Util::get()->add_alert(a);
-	  return true;
-	}
-	break;
-      case DOLLAR_EDGE:
-	seen_dollar = true;
-        seen_dollar_loc = edges[i]->get_loc();
-	break;
-      case BEGIN_LOOP_EDGE:
-      case END_LOOP_EDGE:
-      case BACKREFERENCE_EDGE:
-      case EPSILON_EDGE:
-	break;
-      default:
-	seen_non_caret = true;
-        seen_non_caret_loc = edges[i]->get_loc();
-	if (seen_dollar) {
+          Alert a("anchor middle", msg, seen_non_caret_loc, loc);
+          result.anchor_middle.push_back(a);
+          anchor_middle_done = true;
+        }
+      }
+      else if (type == DOLLAR_EDGE) {
+        seen_dollar = true;
+        seen_dollar_loc = loc;
+      }
+      else {
+        seen_non_caret = true;
+        seen_non_caret_loc = loc;
+        if (seen_dollar) {
           string msg = "Generated string has $ anchor in the middle: " + test_string;
           Alert a("anchor middle", msg, seen_dollar_loc, seen_non_caret_loc);
-          Util::get()->add_alert(a);
-	  return true;
-	}
+          result.anchor_middle.push_back(a);
+          anchor_middle_done = true;
+        }
+      }
     }
-  }
-
-  return false;
-}
 
-void
-Path::check_charsets()
-{
-  vector <string> charsets; // keeps track of charsets, looking for duplicates
-  vector <Location> locs;  
-  
-  for (unsigned int i = 0; i < edges.size(); i++) {
+    // Charsets: each character set is checked by the checker, look for duplicate
+    // charsets that only have punctuation
+    if ((type == CHAR_SET_EDGE || type == STRING_EDGE) &&
+        (rules & (CHECK_CHARSET | CHECK_DUPLICATE_PUNC))) {
+      CharSet *charset_ptr = edge->get_charset();
+      CharSetCheck charset_check;
+      charset_check.charset = charset_ptr;
+      charset_check.loc = loc;
 
-    if (edges[i]->get_type() == CHAR_SET_EDGE || edges[i]->get_type() == STRING_EDGE) {
-      CharSet *charset_ptr = edges[i]->get_charset();
-      Location loc = edges[i]->get_loc();
-
-      // check the character set
-      charset_ptr->check(this, loc);
-
-      // look for duplicate charsets that only have punctuation
-      if (charset_ptr->only_has_punc_and_spaces()) {
-	string charset_str = charset_ptr->get_charset_as_string();
-        bool ignored = false;
-        if (charset_str == "+-" || charset_str == "-+") {
-          ignored = true;
-        }
+      if ((rules & CHECK_DUPLICATE_PUNC) && charset_ptr->only_has_punc_and_spaces()) {
+        string charset_str = charset_ptr->get_charset_as_string();
+        bool ignored = (charset_str == "+-" || charset_str == "-+");
         if (charset_str.length() > 1 && !ignored) {
           bool found_dup = false;
-          for (unsigned int i = 0; i < charsets.size() && !found_dup; i++) {
-            if (charset_str == charsets[i]) {
+          for (unsigned int j = 0; j < charsets.size() && !found_dup; j++) {
+            if (charset_str == charsets[j]) {
               string msg = "Duplicate character set of punctuation marks can lead to mismatched punctuation usage";
               char c1 = charset_ptr->get_valid_character();
               char c2 = charset_ptr->get_valid_character(c1);
-              Alert a("duplicate punc charset", msg, locs[i], loc);
+              Alert a("duplicate punc charset", msg, charset_locs[j], loc);
               a.has_example = true;
-              a.example = gen_example_string(locs[i], c1, loc, c2);
-              Util::get()->add_alert(a);
+              a.example = gen_example_string(charset_locs[j], c1, loc, c2);
+              charset_check.duplicates.push_back(a);
               found_dup = true;
             }
           }
           if (!found_dup) {
-	    // not a duplicate - add to list
-	    charsets.push_back(charset_str);
-            locs.push_back(loc); 
+            // not a duplicate - add to list
+            charsets.push_back(charset_str);
+            charset_locs.push_back(loc);
           }
-	}
+        }
       }
+      result.charsets.push_back(charset_check);
     }
-  }
-}
 
-void
-Path::check_optional_braces()
-{
-  bool prev_opt_repeat = false;
-  bool prev_opt_char = false;
-  Location prev_opt_loc;
-  char prev_char;
-
-  bool opt_lparen = false;
-  bool opt_rparen = false;
-  bool opt_lcurly = false;
-  bool opt_rcurly = false;
-  bool opt_lbrace = false;
-  bool opt_rbrace = false;
-
-  Location opt_lparen_loc;
-  Location opt_rparen_loc;
-  Location opt_lcurly_loc;
-  Location opt_rcurly_loc;
-  Location opt_lbrace_loc;
-  Location opt_rbrace_loc;
-
-  // Traverse path
-  for (unsigned int i = 0; i < edges.size(); i++) {
-    Location loc = edges[i]->get_loc();
-    if (edges[i]->is_opt_repeat_begin()) {
-      prev_opt_repeat = true;
-      prev_opt_char = false;
-    }
+    // Optional braces
     // TODO: This does not capture situations where a group has a single character
-    else if (prev_opt_repeat && edges[i]->get_type() == CHARACTER_EDGE) {
-      prev_opt_char = true;
-      prev_char = edges[i]->get_character();
-      prev_opt_repeat = false;
-      prev_opt_loc = loc;
-    }
-    else if (prev_opt_char && edges[i]->is_opt_repeat_end()) {
-      Location l = make_pair(prev_opt_loc.first, loc.second);
-      prev_opt_char = false;
-      prev_opt_repeat = false;
-      switch (prev_char) {
-        case '(': opt_lparen = true; opt_lparen_loc = l; break;
-        case ')': opt_rparen = true; opt_rparen_loc = l; break;
-        case '{': opt_lcurly = true; opt_lcurly_loc = l; break;
-        case '}': opt_rcurly = true; opt_rcurly_loc = l; break;
-        case '[': opt_lbrace = true; opt_lbrace_loc = l; break;
-        case ']': opt_rbrace = true; opt_rbrace_loc = l; break;
+    if (rules & CHECK_OPTIONAL_BRACE) {
+      if (edge->is_opt_repeat_begin()) {
+        prev_opt_repeat = true;
+        prev_opt_char = false;
+      }
+      else if (prev_opt_repeat && type == CHARACTER_EDGE) {
+        prev_opt_char = true;
+        prev_opt_char_value = edge->get_character();
+        prev_opt_repeat = false;
+        prev_opt_loc = loc;
+      }
+      else if (prev_opt_char && edge->is_opt_repeat_end()) {
+        prev_opt_char = false;
+        prev_opt_repeat = false;
+        for (int b = 0; b < 3; b++) {
+          for (int side = 0; side < 2; side++) {
+            if (prev_opt_char_value == braces[b][side]) {
+              opt_brace[b][side] = true;
+              opt_brace_loc[b][side] = make_pair(prev_opt_loc.first, loc.second);
+            }
+          }
+        }
+      }
+      else {
+        prev_opt_char = false;
+        prev_opt_repeat = false;
       }
     }
-    else {
-      prev_opt_char = false;
-      prev_opt_repeat = false;
-    }
-  }
 
-  // Signal violations
-  if (opt_lparen && opt_rparen) {
-    string msg = "Optional ( and ) found - accepts strings that have one but not the other";
-    Alert a("optional brace", msg, opt_lparen_loc, opt_rparen_loc);
-    a.has_example = true;
-    a.example = gen_example_string(opt_lparen_loc, '(', opt_rparen_loc);
-    Util::get()->add_alert(a);
-  }
-  if (opt_lparen && !opt_rparen) {
-    string msg = "Optional ( found - accepts strings that have one but not the other";
-    Alert a("optional brace", msg, opt_lparen_loc);
-    a.has_example = true;
-    a.example = gen_example_string(opt_lparen_loc, '(');
-    Util::get()->add_alert(a);
-  }
-  if (!opt_lparen && opt_rparen) {
-    string msg = "Optional ) found - accepts strings that have one but not the other";
-    Alert a("optional brace", msg, opt_rparen_loc);
-    a.has_example = true;
-    a.example = gen_example_string(opt_rparen_loc, ')');
-    Util::get()->add_alert(a);
-  }
-  if (opt_lcurly && opt_rcurly) {
-    string msg = "Optional { and } found - accepts strings that have one but not the other";
-    Alert a("optional brace", msg, opt_lcurly_loc, opt_rcurly_loc);
-    a.has_example = true;
-    a.example = gen_example_string(opt_lcurly_loc, '{', opt_rcurly_loc);
-    Util::get()->add_alert(a);
-  }
-  if (opt_lcurly && !opt_rcurly) {
-    string msg = "Optional { found - accepts strings that have one but not the other";
-    Alert a("optional brace", msg, opt_lcurly_loc);
-    a.has_example = true;
-    a.example = gen_example_string(opt_lcurly_loc, '{');
-    Util::get()->add_alert(a);
-  }
-  if (!opt_lcurly && opt_rcurly) {
-    string msg = "Optional } found - accepts strings that have one but not the other";
-    Alert a("optional brace", msg, opt_rcurly_loc);
-    a.has_example = true;
-    a.example = gen_example_string(opt_rcurly_loc, '}');
-    Util::get()->add_alert(a);
-  }
-  if (opt_lbrace && opt_rbrace) {
-    string msg = "Optional [ and ] found - accepts strings that have one but not the other";
-    Alert a("optional brace", msg, opt_lbrace_loc, opt_rbrace_loc);
-    a.has_example = true;
-    a.example = gen_example_string(opt_lbrace_loc, '[', opt_rbrace_loc);
-    Util::get()->add_alert(a);
-  }
-  if (opt_lbrace && !opt_rbrace) {
-    string msg = "Optional [ found - accepts strings that have one but not the other";
-    Alert a("optional brace", msg, opt_lbrace_loc);
-    a.has_example = true;
-    a.example = gen_example_string(opt_lbrace_loc, '[');
-    Util::get()->add_alert(a);
-  }
-  if (!opt_lbrace && opt_rbrace) {
-    string msg = "Optional ] found - accepts strings that have one but not the other";
-    Alert a("optional brace", msg, opt_rbrace_loc);
-    a.has_example = true;
-    a.example = gen_example_string(opt_rbrace_loc, ']');
-    Util::get()->add_alert(a);
-  }
-}
-
-void
-Path::check_wild_punctuation()
-{
-  for (unsigned int i = 0; i < edges.size(); i++) {
-    if (edges[i]->is_wild_candidate()) {
-
-      // Get previous edge
-      // TODO: Do paths have epsilon edges?  If so, should they be removed?
+    // Wild punctuation: signal violation if the previous or next edge (other than
+    // loops and epsilons) is a single character that is a punctuation mark
+    if ((rules & CHECK_WILD_PUNCTUATION) && edge->is_wild_candidate()) {
       int prev_edge = i - 1;
       while (prev_edge >= 0) {
-        EdgeType type = edges[prev_edge]->get_type();
-        if (type != EPSILON_EDGE && type != BEGIN_LOOP_EDGE && type != END_LOOP_EDGE) break;
+        EdgeType prev_type = edges[prev_edge]->get_type();
+        if (prev_type != EPSILON_EDGE && prev_type != BEGIN_LOOP_EDGE && prev_type != END_LOOP_EDGE) break;
         prev_edge--;
       }
-      
-      // TODO: Could make this code a function since it is repeated
-      // Signal violation if previous edge is single character that is a punctuation mark
-      if (prev_edge != -1 && edges[prev_edge]->get_type() == CHARACTER_EDGE) {
-        char c = edges[prev_edge]->get_character();
-        Location prev_loc = edges[prev_edge]->get_loc();
-        if (ispunct(c) && edges[i]->is_valid_character(c)) {
-          Location loc = edges[i]->get_loc();
-          string fix = edges[i]->fix_wild_punctuation(c);
-          string msg = "Wildcard may wish to exclude adjacent punctuation mark " + string(1, c);
-          Alert a("wild punctuation", msg, fix, loc, prev_loc);
-          a.has_example = true;
-          a.example = gen_example_string(loc, c);
-          Util::get()->add_alert(a);
-        }
-      }
-
-      // Get next edge 
       unsigned int next_edge = i + 1;
       while (next_edge < edges.size()) {
-        EdgeType type = edges[next_edge]->get_type();
-        if (type != EPSILON_EDGE && type != BEGIN_LOOP_EDGE && type != END_LOOP_EDGE) break;
+        EdgeType next_type = edges[next_edge]->get_type();
+        if (next_type != EPSILON_EDGE && next_type != BEGIN_LOOP_EDGE && next_type != END_LOOP_EDGE) break;
         next_edge++;
       }
 
-      // Signal violation if next edge is single character that is a punctuation mark
-      if (next_edge != edges.size() && edges[next_edge]->get_type() == CHARACTER_EDGE) {
-        char c = edges[next_edge]->get_character();
-        Location next_loc = edges[next_edge]->get_loc();
-        if (ispunct(c) && edges[i]->is_valid_character(c)) {
-          Location loc = edges[i]->get_loc();
-          string fix = edges[i]->fix_wild_punctuation(c);
+      int adjacent[2] = { prev_edge, next_edge == edges.size() ? -1 : (int) next_edge };
+      for (int side = 0; side < 2; side++) {
+        if (adjacent[side] == -1 || edges[adjacent[side]]->get_type() != CHARACTER_EDGE) continue;
+        char c = edges[adjacent[side]]->get_character();
+        Location adjacent_loc = edges[adjacent[side]]->get_loc();
+        if (ispunct(c) && edge->is_valid_character(c)) {
+          string fix = edge->fix_wild_punctuation(c);
           string msg = "Wildcard may wish to exclude adjacent punctuation mark " + string(1, c);
-          Alert a("wild punctuation", msg, fix, loc, next_loc);
+          Alert a("wild punctuation", msg, fix, loc, adjacent_loc);
           a.has_example = true;
           a.example = gen_example_string(loc, c);
-          Util::get()->add_alert(a);
+          result.wild_punctuation.push_back(a);
         }
       }
     }
-  }
-}
-
-void
-Path::check_repeat_punctuation()
-{
-  bool prev_repeat = false;
-  bool prev_candidate = false;
-  char prev_char;
-  Location prev_loc;
-
-  for (unsigned int i = 0; i < edges.size(); i++) {
-    Location curr_loc = edges[i]->get_loc();
-    if (edges[i]->is_str_repeat_punc_candidate()) {
-      char c = edges[i]->get_repeat_punc_char();
 
-      string repeat_str = string(1, c);
-      int limit = 3;
-      int lower_limit = edges[i]->get_repeat_lower_limit();
-      int upper_limit = edges[i]->get_repeat_upper_limit();
-
-      if (lower_limit > 3) {
-        limit = lower_limit;
+    // Repeat punctuation
+    // TODO: This does not capture situations where a group has a single character
+    if (rules & CHECK_REPEAT_PUNCTUATION) {
+      if (edge->is_str_repeat_punc_candidate()) {
+        char c = edge->get_repeat_punc_char();
+        if (edge->get_repeat_lower_limit() != edge->get_repeat_upper_limit()) {
+          string msg = "Punctuation mark may be repeated two or more times: " + string(1, c);
+          Alert a("repeat punctuation", msg, loc);
+          a.has_example = true;
+          a.example = gen_example_string(loc, gen_repeat_string(c, edge));
+          result.repeat_punctuation.push_back(a);
+        }
       }
-      else if (upper_limit == 2) {
-        limit = upper_limit;
+      else if (edge->is_repeat_begin()) {
+        prev_repeat = true;
+        prev_repeat_candidate = false;
       }
-      for (int i = 1; i < limit; i++) {
-        repeat_str += c;
+      else if (prev_repeat && edge->is_repeat_punc_candidate()) {
+        prev_repeat_char = edge->get_repeat_punc_char();
+        prev_repeat = false;
+        prev_repeat_candidate = true;
+        prev_repeat_loc = loc;
       }
-
-      if (lower_limit != upper_limit) {
-        string msg = "Punctuation mark may be repeated two or more times: " + string(1, c);
-        Alert a("repeat punctuation", msg, curr_loc);
-        a.has_example = true;
-        a.example = gen_example_string(curr_loc, repeat_str);
-        Util::get()->add_alert(a);
+      else if (prev_repeat_candidate && edge->is_repeat_end()) {
+        prev_repeat = false;
+        prev_repeat_candidate = false;
+        if (edge->get_repeat_lower_limit() != edge->get_repeat_upper_limit()) {
+          Location repeat_loc = make_pair(prev_repeat_loc.first, loc.second);
+          string msg = "Punctuation mark may be repeated two or more times: " + string(1, prev_repeat_char);
+          Alert a("repeat punctuation", msg, prev_repeat_loc, loc);
+          a.has_example = true;
+          a.example = gen_example_string(repeat_loc, gen_repeat_string(prev_repeat_char, edge));
+          result.repeat_punctuation.push_back(a);
+        }
+      }
+      else {
+        prev_repeat = false;
+        prev_repeat_candidate = false;
       }
     }
-    else if (edges[i]->is_repeat_begin()) {
-      prev_repeat = true;
-      prev_candidate = false;
-    }
-    // TODO: This does not capture situations where a group has a single character
-    else if (prev_repeat && edges[i]->is_repeat_punc_candidate()) {
-      prev_char = edges[i]->get_repeat_punc_char();
-      prev_repeat = false;
-      prev_candidate = true;
-      prev_loc = curr_loc;
-    }
-    else if (prev_candidate && edges[i]->is_repeat_end()) {
-      Location loc = make_pair(prev_loc.first, curr_loc.second);
-      prev_repeat = false;
-      prev_candidate = false;
-
-      string repeat_str = string(1, prev_char);
-      int limit = 3;
-      int lower_limit = edges[i]->get_repeat_lower_limit();
-      int upper_limit = edges[i]->get_repeat_upper_limit();
-
-      if (lower_limit > 3) {
-        limit = lower_limit;
+
+    // Digit too optional
+    if (rules & CHECK_DIGIT_TOO_OPTIONAL) {
+      if (edge->is_zero_repeat_begin()) {
+        prev_zero_repeat = true;
+        prev_digit_candidate = false;
       }
-      else if (upper_limit == 2) {
-        limit = upper_limit;
+      else if (prev_zero_repeat && edge->is_digit_too_optional_candidate()) {
+        prev_zero_repeat = false;
+        prev_digit_candidate = true;
+        prev_digit_loc = loc;
       }
-      for (int i = 1; i < limit; i++) {
-        repeat_str += prev_char;
+      else if (prev_digit_candidate && edge->is_zero_repeat_end()) {
+        prev_zero_repeat = false;
+        prev_digit_candidate = false;
+        if (!have_min_iter) {
+          min_iter = gen_min_iter_string();
+          have_min_iter = true;
+        }
+
+        bool found_digit = false;
+        for (unsigned int j = 0; j < min_iter.size(); j++) {
+          char c = min_iter[j];
+          if (c >= '0' && c <= '9') found_digit = true;
+        }
+
+        if (!found_digit) {
+          Location digit_loc = make_pair(prev_digit_loc.first, loc.second);
+          string msg = "Digit range allows for zero digits casuing a string with no digits to be accepted";
+          Alert a("digit too optional", msg, digit_loc);
+          a.has_example = true;
+          a.example = min_iter;
+          result.digit_too_optional.push_back(a);
+        }
       }
+      else {
+        prev_zero_repeat = false;
+        prev_digit_candidate = false;
+      }
+    }
+  }
 
-      if (lower_limit != upper_limit) {
-        string msg = "Punctuation mark may be repeated two or more times: " + string(1, prev_char);
-        Alert a("repeat punctuation", msg, prev_loc, curr_loc);
+  // Signal optional brace violations
+  for (int b = 0; b < 3; b++) {
+    char open = braces[b][0];
+    char close = braces[b][1];
+    if (opt_brace[b][0] && opt_brace[b][1]) {
+      string msg = string("Optional ") + open + " and " + close +
+        " found - accepts strings that have one but not the other";
+      Alert a("optional brace", msg, opt_brace_loc[b][0], opt_brace_loc[b][1]);
+      a.has_example = true;
+      a.example = gen_example_string(opt_brace_loc[b][0], open, opt_brace_loc[b][1]);
+      result.optional_braces.push_back(a);
+    }
+    for (int side = 0; side < 2; side++) {
+      if (opt_brace[b][side] && !opt_brace[b][1 - side]) {
+        string msg = string("Optional ") + braces[b][side] +
+          " found - accepts strings that have one but not the other";
+        Alert a("optional brace", msg, opt_brace_loc[b][side]);
         a.has_example = true;
-        a.example = gen_example_string(loc, repeat_str);
-        Util::get()->add_alert(a);
+        a.example = gen_example_string(opt_brace_loc[b][side], braces[b][side]);
+        result.optional_braces.push_back(a);
       }
     }
-    else {
-      prev_repeat = false;
-      prev_candidate = false;
-    }
   }
 }
 
-void
-Path::check_digit_too_optional()
+string
+Path::gen_repeat_string(char c, Edge *edge)
 {
-  bool prev_repeat = false;
-  bool prev_candidate = false;
-  Location prev_loc;
+  // three copies of the mark unless the bounds call for a different number
+  int limit = 3;
+  int lower_limit = edge->get_repeat_lower_limit();
+  int upper_limit = edge->get_repeat_upper_limit();
+  if (lower_limit > 3) {
+    limit = lower_limit;
+  }
+  else if (upper_limit == 2) {
+    limit = upper_limit;
+  }
+  return string(limit, c);
+}
 
-  for (unsigned int i = 0; i < edges.size(); i++) {
-    Location curr_loc = edges[i]->get_loc();
-    if (edges[i]->is_zero_repeat_begin()) {
-      prev_repeat = true;
-      prev_candidate = false;
-    }
-    else if (prev_repeat && edges[i]->is_digit_too_optional_candidate()) {
-      prev_repeat = false;
-      prev_candidate = true;
-      prev_loc = curr_loc;
-    }
-    else if (prev_candidate && edges[i]->is_zero_repeat_end()) {
-      prev_repeat = false;
-      prev_candidate = false;
-      string example = gen_min_iter_string();
-
-      bool found_digit = false;
-      for (unsigned int i = 0; i < example.size(); i++) {
-        char c = example[i];
-        if (c >= '0' && c <= '9') found_digit = true;
-      }
+// TEST STRING GENERATION FUNCTIONS
 
-      if (!found_digit) {
-        Location loc = make_pair(prev_loc.first, curr_loc.second);
-        string msg = "Digit range allows for zero digits casuing a string with no digits to be accepted";
-        Alert a("digit too optional", msg, loc);
-        a.has_example = true;
-        a.example = example;
-        Util::get()->add_alert(a);
+string
+Path::gen_example_substring(unsigned int i, const string &example, vector <unsigned int> &loop_starts)
+{
+  // The extra iterations of a loop repeat the body of the example.  These are
+  // found here rather than with process_edge since the loops are shared by all
+  // of the paths (which may be checked at the same time).
+  switch (edges[i]->get_type()) {
+    case BEGIN_LOOP_EDGE:
+      loop_starts.push_back(example.size());
+      return "";
+    case END_LOOP_EDGE:
+    {
+      string body = example.substr(loop_starts.back());
+      loop_starts.pop_back();
+      string extra;
+      for (int j = 1; j < edges[i]->get_regex_loop()->get_repeat_lower(); j++) {
+        extra += body;
       }
+      return extra;
     }
-    else {
-      prev_repeat = false;
-      prev_candidate = false;
-    }
+    default:
+      return edges[i]->get_substring();
   }
 }
 
-// TEST STRING GENERATION FUNCTIONS
-
 string
 Path::gen_example_string(Location loc, char c)
 {
   string example;
+  vector <unsigned int> loop_starts;
   for (unsigned int i = 0; i < edges.size(); i++) {
-    edges[i]->process_edge(example, this);
+    string sub = gen_example_substring(i, example, loop_starts);
 
     Location edge_loc = edges[i]->get_loc();
     if (edge_loc.first == loc.first) {
       example += c;
     }
     else {
-      example += edges[i]->get_substring();
+      example += sub;
     }
   }
 
@@ -535,27 +482,21 @@ string
 Path::gen_example_string(Location loc, char c, char except)
 {
   string example;
+  vector <unsigned int> loop_starts;
   for (unsigned int i = 0; i < edges.size(); i++) {
-    edges[i]->process_edge(example, this);
+    string sub = gen_example_substring(i, example, loop_starts);
 
     Location edge_loc = edges[i]->get_loc();
     if (edge_loc.first == loc.first) {
       example += c;
     }
     else {
-      string sub = edges[i]->get_substring();
       string except_str = string(1, except);
-      if (sub == except_str) {
-        if (edges[i]->get_type() == CHAR_SET_EDGE) {
-          char c =  edges[i]->get_charset()->get_valid_character(except);
-          example += c;
-        }
-        else {
-          example += edges[i]->get_substring();
-        }
+      if (sub == except_str && edges[i]->get_type() == CHAR_SET_EDGE) {
+        example += edges[i]->get_charset()->get_valid_character(except);
       }
       else {
-        example += edges[i]->get_substring();
+        example += sub;
       }
     }
   }
@@ -567,8 +508,9 @@ string
 Path::gen_example_string(Location loc, char c, Location omit)
 {
   string example;
+  vector <unsigned int> loop_starts;
   for (unsigned int i = 0; i < edges.size(); i++) {
-    edges[i]->process_edge(example, this);
+    string sub = gen_example_substring(i, example, loop_starts);
 
     Location edge_loc = edges[i]->get_loc();
     if (edge_loc.first == loc.first) {
@@ -578,7 +520,7 @@ Path::gen_example_string(Location loc, char c, Location omit)
       continue;
     }
     else {
-      example += edges[i]->get_substring();
+      example += sub;
     }
   }
 
@@ -589,8 +531,9 @@ string
 Path::gen_example_string(Location loc1, char c1, Location loc2, char c2)
 {
   string example;
+  vector <unsigned int> loop_starts;
   for (unsigned int i = 0; i < edges.size(); i++) {
-    edges[i]->process_edge(example, this);
+    string sub = gen_example_substring(i, example, loop_starts);
 
     Location edge_loc = edges[i]->get_loc();
     if (edge_loc.first == loc1.first) {
@@ -600,7 +543,7 @@ Path::gen_example_string(Location loc1, char c1, Location loc2, char c2)
       example += c2;
     }
     else {
-      example += edges[i]->get_substring();
+      example += sub;
     }
   }
 
@@ -611,9 +554,10 @@ string
 Path::gen_example_string(Location loc, string replace)
 {
   string example;
+  vector <unsigned int> loop_starts;
   bool in_replace = false;
   for (unsigned int i = 0; i < edges.size(); i++) {
-    edges[i]->process_edge(example, this);
+    string sub = gen_example_substring(i, example, loop_starts);
 
     Location edge_loc = edges[i]->get_loc();
     if (edge_loc.first == loc.first) {
@@ -624,7 +568,7 @@ Path::gen_example_string(Location loc, string replace)
       in_replace = false;
     }
     else if (!in_replace) {
-      example += edges[i]->get_substring();
+      example += sub;
     }
   }
 
@@ -648,30 +592,112 @@ Path::gen_backref_string(Location loc)
 string
 Path::gen_min_iter_string()
 {
+  bool valid_string;
+  return gen_min_iter_string(valid_string, true);
+}
+
+string
+Path::gen_min_iter_string(bool &valid_string)
+{
+  return gen_min_iter_string(valid_string, false);
+}
+
+string
+Path::gen_min_iter_string(bool &valid_string, bool own_loops)
+{
+  // Same checks as process_path.  Loops with a lower bound of zero are skipped
+  // along with their edges.  Other loops add copies of the loop body, either from
+  // this string (own_loops) or from the last path through the loop, which are
+  // valid if the loop body matched them.
   string min_iter_string;
+  valid_string = true;
+  vector <bool> outer_valid;		// validity outside each enclosing loop
+  vector <string> loop_prefixes;	// string before each enclosing loop
+  int dollar_pos = -1;			// position of first dollar
+
   for (unsigned int i = 0; i < edges.size(); i++) {
+    switch (edges[i]->get_type()) {
+      case BEGIN_LOOP_EDGE:
+        outer_valid.push_back(valid_string);
+        loop_prefixes.push_back(min_iter_string);
+        valid_string = true;
+        break;
+      case END_LOOP_EDGE:
+      {
+        RegexLoop *loop = edges[i]->get_regex_loop();
+        if (loop->get_repeat_lower() == 0) {
+          valid_string = outer_valid.back();
+          min_iter_string = loop_prefixes.back();
+        }
+        else if (own_loops) {
+          string body = min_iter_string.substr(loop_prefixes.back().size());
+          for (int j = 1; j < loop->get_repeat_lower(); j++) {
+            min_iter_string += body;
+          }
+          valid_string = valid_string && outer_valid.back();
+        }
+        else {
+          if (loop->get_repeat_lower() > 1 && !loop->is_curr_valid()) valid_string = false;
+          valid_string = valid_string && outer_valid.back();
+          edges[i]->gen_min_iter_string(min_iter_string);
+        }
+        outer_valid.pop_back();
+        loop_prefixes.pop_back();
+        continue;
+      }
+      case CARET_EDGE:
+        if (!outer_valid.empty() || !min_iter_string.empty()) valid_string = false;
+        break;
+      case DOLLAR_EDGE:
+        if (!outer_valid.empty()) valid_string = false;
+        else if (dollar_pos == -1) dollar_pos = min_iter_string.size();
+        break;
+      case STRING_EDGE:
+        if (edges[i]->get_repeat_lower_limit() != 0 && !edges[i]->is_valid_substring()) {
+          valid_string = false;
+        }
+        break;
+      default:
+        if (!edges[i]->is_valid_substring()) valid_string = false;
+        break;
+    }
+
     edges[i]->gen_min_iter_string(min_iter_string);
   }
+
+  if (dollar_pos != -1 && dollar_pos != (int) min_iter_string.size()) valid_string = false;
   return min_iter_string;
 }
 
 vector <string>
-Path::gen_evil_strings(const set <char> &punct_marks)
+Path::gen_evil_strings(const set <char> &punct_marks, vector <bool> &valid_strings)
 {
   vector <string> evil_strings;
 
-  // add strings for interesting edges (char sets, strings, and loops)
+  // add strings for interesting edges (char sets, strings, and loops), the strings
+  // are valid if the path is valid and the edge still matches its new substring
   for (unsigned int i = 0; i < evil_edges.size(); i++) {
     int index = evil_edges[i];
-    vector <string> new_strings = edges[index]->gen_evil_strings(test_string, punct_marks);
-    vector <string>::iterator tsi;
-    for (tsi = new_strings.begin(); tsi != new_strings.end(); tsi++) {
-      evil_strings.push_back(*tsi);
+    vector <bool> valid_edge;
+    vector <string> new_strings = edges[index]->gen_evil_strings(test_string, punct_marks, valid_edge);
+    for (unsigned int j = 0; j < new_strings.size(); j++) {
+      evil_strings.push_back(new_strings[j]);
+      valid_strings.push_back(valid && valid_edge[j]);
     }
   }
   return evil_strings;
 }
 
+void
+Path::add_characters(bitset <256> &chars)
+{
+  for (unsigned int i = 0; i < edges.size(); i++) {
+    for (int c = 0; c < 256; c++) {
+      if (!chars[c] && edges[i]->accepts_character((char) c)) chars.set(c);
+    }
+  }
+}
+
 // PRINT FUNCTION
 
 void
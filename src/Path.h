@@ -22,20 +22,46 @@
 #ifndef PATH_H
 #define PATH_H
 
+#include <bitset>
 #include <set>
 #include <string>
 #include <vector>
+#include "CharSet.h"
 #include "Edge.h"
+#include "Util.h"
 using namespace std;
 
+// A character set of a path to be checked by the checker
+struct CharSetCheck {
+  CharSet *charset;		// character set (checked once for the regex)
+  Location loc;			// location of character set
+  vector <Alert> duplicates;	// duplicate punctuation set alert found at the set
+};
+
+// Results of checking a path, kept by checker rule so the checker can report
+// the alerts of all paths in the same order as checking one rule at a time
+struct PathCheck {
+  bool leading_caret;			// true if path has a leading caret
+  bool trailing_dollar;			// true if path has a trailing dollar
+  vector <Alert> anchor_middle;		// anchor in middle (at most one)
+  vector <CharSetCheck> charsets;	// character sets in path order
+  vector <Alert> optional_braces;	// optional braces
+  vector <Alert> wild_punctuation;	// wildcard just before/after punctuation mark
+  vector <Alert> repeat_punctuation;	// punctuation can be repeated
+  vector <Alert> digit_too_optional;	// digits are too optional
+};
+
 class Path {
 
 public:
 
-  Path() {}
-  Path(unsigned int initial) { states.push_back(initial); }
+  Path() { valid = false; }
+  Path(unsigned int initial) { states.push_back(initial); valid = false; }
   string get_test_string() { return test_string; }
 
+  // returns true if the test string is known to match the regex by following the path
+  bool is_valid() { return valid; }
+
   // PATH CONSTRUCTION FUNCTIONS
 
   // adds an edge and the destination state to the path 
@@ -50,32 +76,16 @@ public:
   // processes path: sets test string and evil edges
   void process_path();
 
-  // CHECKER FUNCTIONS
-
-  // returns true if path has a leading caret
-  bool has_leading_caret();
-
-  // returns true if path has a trailing dollar
-  bool has_trailing_dollar();
-
-  // returns true and emits violation if there is an anchor (^ or $) in the
-  // middle of the path 
-  bool check_anchor_in_middle();
+  // processes path for the checker: sets the edge substrings used by the examples
+  // and the test string (if needed by the rules or for backreferences)
+  void process_check_path(bool need_test_string);
 
-  // emits violation if a path contains a charset error
-  void check_charsets();
+  // CHECKER FUNCTION
 
-  // emits violation if a path contains optional braces
-  void check_optional_braces();
-
-  // emits violation if wildcard is just before/after punctuation mark
-  void check_wild_punctuation();
-
-  // emits violation if punctuation can be repeated in certain situations
-  void check_repeat_punctuation();
-
-  // emits violation if digits are too optional
-  void check_digit_too_optional();
+  // checks the path for the checker rules in the rule mask in a single traversal,
+  // the alerts are added to result (does not change the edges so paths can be
+  // checked in parallel)
+  void check(PathCheck &result, unsigned int rules);
 
   // STRING GENERATION FUNCTIONS
 
@@ -89,11 +99,20 @@ public:
   // generates string based on location
   string gen_backref_string(Location loc);
 
-  // generates a string with minimum iterations for repeating constructs
+  // generates a string with minimum iterations for repeating constructs, the extra
+  // iterations of loops repeat the loop body of the string (used by the checker)
   string gen_min_iter_string();
 
-  // generates evil strings for the path
-  vector <string> gen_evil_strings(const set <char> &punct_marks);
+  // generates a string with minimum iterations for repeating constructs, the extra
+  // iterations of loops repeat the last path through the loop, valid is set if the
+  // string is known to match the regex
+  string gen_min_iter_string(bool &valid_string);
+
+  // generates evil strings for the path, valid is set for strings known to match the regex
+  vector <string> gen_evil_strings(const set <char> &punct_marks, vector <bool> &valid_strings);
+
+  // adds the characters that can be consumed by the edges of the path
+  void add_characters(bitset <256> &chars);
 
   // PRINT FUNCTION
   
@@ -105,8 +124,18 @@ private:
   vector <unsigned int> states;		// list of states
   vector <Edge *> edges;		// list of edges
   string test_string;		// test string associated with path
+  bool valid;			// set if test string is known to match the regex
   vector <unsigned int> evil_edges;	// list of evil edges that need processing
 
+  // returns the substring of edge i for an example string being built, loop_starts
+  // holds the start of each enclosing loop within the example
+  string gen_example_substring(unsigned int i, const string &example, vector <unsigned int> &loop_starts);
+
+  // generates a string with minimum iterations (see public versions)
+  string gen_min_iter_string(bool &valid_string, bool own_loops);
+
+  // returns the repeated punctuation mark used in repeat punctuation examples
+  string gen_repeat_string(char c, Edge *edge);
 };
 
 #endif // PATH_H
@@ -44,6 +44,13 @@ RegexLoop::get_substring()
   return extra;
 }
 
+bool
+RegexLoop::is_valid_count(int iterations)
+{
+  if (iterations < repeat_lower) return false;
+  return repeat_upper == -1 || iterations <= repeat_upper;
+}
+
 bool
 RegexLoop::is_opt_repeat()
 {
@@ -53,16 +60,14 @@ RegexLoop::is_opt_repeat()
 void
 RegexLoop::gen_min_iter_string(string &min_iter_string)
 {
+  // the elements of loops without required iterations are removed by the path
   if (repeat_lower != 0) {
     min_iter_string += get_substring();
   }
-  else {
-    min_iter_string = curr_prefix;
-  }
 }
 
 vector <string>
-RegexLoop::gen_evil_strings(string test_string)
+RegexLoop::gen_evil_strings(string test_string, vector <bool> &valid)
 {
   vector <string> evil_strings;
 
@@ -80,17 +85,25 @@ RegexLoop::gen_evil_strings(string test_string)
   one_more_string += substring;
   one_more_string += suffix;
 
+  // The path has one iteration if the lower bound is zero (used to determine
+  // if the number of iterations in each string is allowed).
+  int path_iterations = repeat_lower;
+  if (path_iterations == 0) path_iterations = 1;
+
   if (repeat_upper != -1) {
 
     // For cases like {n}, add strings for one less (n-1) and one more (n+1).
     if (repeat_lower == repeat_upper) {
       evil_strings.push_back(one_less_string);
+      valid.push_back(is_valid_count(path_iterations - 1));
       evil_strings.push_back(one_more_string);
+      valid.push_back(is_valid_count(path_iterations + 1));
     }
     else {
       // Handle one less on lower bound (note if lower bound is zero, the path
       // has one iteration so one less iteration will get us to zero iterations)
       evil_strings.push_back(one_less_string);
+      valid.push_back(is_valid_count(path_iterations - 1));
 
       // Add enough path elements to get to the upper bound (note if lower bound
       // is zero, the path has one iteration so the starting point is bumped to one).
@@ -108,6 +121,7 @@ RegexLoop::gen_evil_strings(string test_string)
       upper_bound_string += path_elements;
       upper_bound_string += suffix;
       evil_strings.push_back(upper_bound_string);
+      valid.push_back(is_valid_count(repeat_upper));
 
       // Add the string with one more iteration past the upper bound.
       string past_bound_string = prefix;
@@ -115,6 +129,7 @@ RegexLoop::gen_evil_strings(string test_string)
       past_bound_string += substring;
       past_bound_string += suffix;
       evil_strings.push_back(past_bound_string);
+      valid.push_back(is_valid_count(repeat_upper + 1));
     } 
   }
 
@@ -123,11 +138,14 @@ RegexLoop::gen_evil_strings(string test_string)
     // to have one case that has repeated (two) elements.
     if (repeat_lower == 0 || repeat_lower == 1) {
       evil_strings.push_back(one_less_string);
+      valid.push_back(is_valid_count(path_iterations - 1));
       evil_strings.push_back(one_more_string);
+      valid.push_back(is_valid_count(path_iterations + 1));
     }
     // Otherwise, only add the string with one less iteration than the lower bound.
     else {
       evil_strings.push_back(one_less_string);
+      valid.push_back(is_valid_count(path_iterations - 1));
     }
   }
 
@@ -30,9 +30,11 @@ class RegexLoop {
 
 public:
 
-  RegexLoop(int lower, int upper) {
+  RegexLoop(int lower, int upper, bool lz) {
     repeat_lower = lower;
     repeat_upper = upper;
+    lazy = lz;
+    curr_valid = false;
   }
 
   // setters
@@ -40,20 +42,26 @@ public:
   void set_substring_from_curr() { substring = curr_substring; }
   void set_curr_prefix(string p) { curr_prefix = p; }
   void set_curr_substring(string test_string);
+  void set_curr_valid(bool v) { curr_valid = v; }
 
   // getters
   int get_repeat_lower() { return repeat_lower; }
   int get_repeat_upper() { return repeat_upper; }
+  bool is_lazy() { return lazy; }
   string get_substring();
+  bool is_curr_valid() { return curr_valid; }
 
   // property functions - used by checker
   bool is_opt_repeat();
 
+  // returns true if the number of iterations is within the repeat bounds
+  bool is_valid_count(int iterations);
+
   // generate minimum iteration string
   void gen_min_iter_string(string &min_iter_string);
 
-  // generate evil strings
-  vector <string> gen_evil_strings(string test_string);
+  // generate evil strings, valid is set for strings with an allowed number of iterations
+  vector <string> gen_evil_strings(string test_string, vector <bool> &valid);
 
   // print the regex loop
   void print();
@@ -62,6 +70,7 @@ private:
 
   int repeat_lower;     	// lower bound for repeat quantifiers 
   int repeat_upper;     	// upper bound for repeat quantifiers (-1 if no bound)
+  bool lazy;			// set for lazy quantifiers (fewest iterations first)
 
   // TODO: Rename these to something like evil prefix
   string prefix;       	        // prefix of test string before the loop
@@ -69,6 +78,7 @@ private:
 
   string curr_prefix;           // current path string up to visiting this node
   string curr_substring;        // current substring corresponding to this string
+  bool curr_valid;              // set if current substring is matched by the loop body
 };
 
 #endif // REGEX_LOOP_H
@@ -34,8 +34,16 @@ RegexString::gen_min_iter_string(string &min_iter_string)
   }
 }
 
+bool
+RegexString::is_valid_substring(string s)
+{
+  if (s.empty()) return repeat_lower == 0;
+  return char_set->is_valid_string(s);
+}
+
 vector <string>
-RegexString::gen_evil_strings(string test_string, const set <char> &punct_marks)
+RegexString::gen_evil_strings(string test_string, const set <char> &punct_marks,
+    vector <bool> &valid)
 {
   vector <string> evil_substrings; // set of evil substrings
 
@@ -96,6 +104,7 @@ RegexString::gen_evil_strings(string test_string, const set <char> &punct_marks)
   for (tsi = evil_substrings.begin(); tsi != evil_substrings.end(); tsi++) {
     string new_string = prefix + *tsi + suffix;
     evil_strings.push_back(new_string);
+    valid.push_back(is_valid_substring(*tsi));
   }
 
   return evil_strings;
@@ -33,10 +33,11 @@ class RegexString {
 
 public:
 
-  RegexString(CharSet *c, int lower, int upper) {
+  RegexString(CharSet *c, int lower, int upper, bool lz) {
     char_set = c;
     repeat_lower = lower;
     repeat_upper = upper;
+    lazy = lz;
   }
 
   // setters
@@ -47,6 +48,7 @@ public:
   string get_substring() { return substring; }
   int get_repeat_lower() { return repeat_lower; }
   int get_repeat_upper() { return repeat_upper; }
+  bool is_lazy() { return lazy; }
   CharSet *get_charset() { return char_set; }
 
   // property function - used by checker
@@ -54,6 +56,9 @@ public:
   bool is_wild_candidate() { return char_set->is_wildcard() || char_set->is_complement(); }
   bool is_valid_character(char c) { return char_set->is_wildcard() || char_set->is_valid_character(c); }
 
+  // returns true if the string is matched by the repeated character set
+  bool is_valid_substring(string s);
+
   // repeat punctuation check functions
   bool is_repeat_punc_candidate() { return char_set->is_repeat_punc_candidate(); }
   char get_repeat_punc_char() { return char_set->get_repeat_punc_char(); }
@@ -61,8 +66,9 @@ public:
   // generate minimum iterations string
   void gen_min_iter_string(string &min_iter_string);
 
-  // generate evil strings
-  vector <string> gen_evil_strings(string test_string, const set <char> &punct_marks);
+  // generate evil strings, valid is set for strings matched by the repeated character set
+  vector <string> gen_evil_strings(string test_string, const set <char> &punct_marks,
+      vector <bool> &valid);
 
   // print the regex string
   void print();
@@ -71,6 +77,7 @@ private:
   CharSet *char_set;		// corresponding character set
   int repeat_lower;     	// lower bound for string
   int repeat_upper;     	// upper bound for string
+  bool lazy;			// set for lazy quantifiers (fewest characters first)
 
   string prefix;            // prefix of test string before the loop
   string substring;         // substring corresponding to this string
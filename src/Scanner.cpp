@@ -23,7 +23,9 @@
 */
 
 #include <cassert>
+#include <climits>
 #include <iostream>
+#include <map>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -33,345 +35,249 @@
 
 using namespace std;
 
+// The scanner is table driven: each character is mapped to a class by a table
+// computed at compile time, and the class and the context (inside or outside of
+// a set) select the rule used to scan it.  Characters after a backslash have
+// their own class table.
+
+// Expands to the entries of a 128 entry table, where entry c is f(c)
+#define TABLE_ROW(f, c) f(c), f(c + 1), f(c + 2), f(c + 3), f(c + 4), f(c + 5), \
+  f(c + 6), f(c + 7), f(c + 8), f(c + 9), f(c + 10), f(c + 11), f(c + 12), \
+  f(c + 13), f(c + 14), f(c + 15)
+#define TABLE_128(f) TABLE_ROW(f, 0), TABLE_ROW(f, 16), TABLE_ROW(f, 32), \
+  TABLE_ROW(f, 48), TABLE_ROW(f, 64), TABLE_ROW(f, 80), TABLE_ROW(f, 96), \
+  TABLE_ROW(f, 112)
+
+// Contexts of the scanner
+typedef enum {
+  IN_REGEX,		// outside of a set
+  IN_SET,		// in the middle of a set []
+  NUM_CONTEXTS
+} ScanContext;
+
+// Classes of characters
+typedef enum {
+  PLAIN_CLASS,		// matches itself in any context
+  BACKSLASH_CLASS,
+  LEFT_BRACKET_CLASS,
+  RIGHT_BRACKET_CLASS,
+  HYPHEN_CLASS,
+  BAR_CLASS,
+  STAR_CLASS,
+  PLUS_CLASS,
+  QUESTION_CLASS,
+  LEFT_PAREN_CLASS,
+  RIGHT_PAREN_CLASS,
+  PERIOD_CLASS,
+  LEFT_BRACE_CLASS,
+  CARET_CLASS,
+  DOLLAR_CLASS,
+  NUM_CHAR_CLASSES
+} ScanClass;
+
+// Rules for scanning a character
+typedef enum {
+  TOKEN_RULE,		// token of the given type
+  LAZY_RULE,		// token of the given type (lazy if followed by '?')
+  ESCAPE_RULE,		// escape sequence
+  OPEN_SET_RULE,	// start of a set
+  CLOSE_SET_RULE,	// end of a set (unless first in the set)
+  SET_HYPHEN_RULE,	// range hyphen (unless first or last in the set)
+  QUESTION_RULE,	// extension after '(', lazy optional operator otherwise
+  REPEAT_RULE		// possible repeat quantifier
+} ScanRule;
+
+struct ScanTransition {
+  ScanRule rule;
+  TokenType type;
+};
+
+// Classes of characters after a backslash
+typedef enum {
+  ESCAPED_CHAR,		// matches the character itself: \\, \(, \$, etc.
+  ESCAPED_CLASS,	// character class: \d, \D, \w, \W, \s, and \S
+  ESCAPED_CARET,	// \A is the same as ^ (only differ in multi-line which is not supported)
+  ESCAPED_DOLLAR,	// \Z is the same as $ (only differ in multi-line which is not supported)
+  ESCAPED_BACKSPACE,	// \b is backspace in a set (unsupported) and word boundary otherwise
+  ESCAPED_BOUNDARY,	// \B is also treated as word boundary
+  ESCAPED_CONTROL,	// \a, \f, \n, \r, \t, and \v (only supported in check mode)
+  ESCAPED_UNSUPPORTED,	// \p and \N (named characters)
+  ESCAPED_DIGIT,	// octal character or backreference
+  ESCAPED_HEX		// \x, \u, and \U
+} EscapeClass;
+
+static constexpr unsigned char
+scan_class(int c)
+{
+  return c == '\\' ? BACKSLASH_CLASS :
+    c == '[' ? LEFT_BRACKET_CLASS :
+    c == ']' ? RIGHT_BRACKET_CLASS :
+    c == '-' ? HYPHEN_CLASS :
+    c == '|' ? BAR_CLASS :
+    c == '*' ? STAR_CLASS :
+    c == '+' ? PLUS_CLASS :
+    c == '?' ? QUESTION_CLASS :
+    c == '(' ? LEFT_PAREN_CLASS :
+    c == ')' ? RIGHT_PAREN_CLASS :
+    c == '.' ? PERIOD_CLASS :
+    c == '{' ? LEFT_BRACE_CLASS :
+    c == '^' ? CARET_CLASS :
+    c == '$' ? DOLLAR_CLASS : PLAIN_CLASS;
+}
+
+static constexpr unsigned char
+escape_class(int c)
+{
+  return (c == 'd' || c == 'D' || c == 'w' || c == 'W' || c == 's' || c == 'S') ? ESCAPED_CLASS :
+    c == 'A' ? ESCAPED_CARET :
+    c == 'Z' ? ESCAPED_DOLLAR :
+    c == 'b' ? ESCAPED_BACKSPACE :
+    c == 'B' ? ESCAPED_BOUNDARY :
+    (c == 'a' || c == 'f' || c == 'n' || c == 'r' || c == 't' || c == 'v') ? ESCAPED_CONTROL :
+    (c == 'p' || c == 'N') ? ESCAPED_UNSUPPORTED :
+    (c >= '0' && c <= '9') ? ESCAPED_DIGIT :
+    (c == 'x' || c == 'u' || c == 'U') ? ESCAPED_HEX : ESCAPED_CHAR;
+}
+
+// class of each character (characters above 127 are plain)
+static constexpr unsigned char SCAN_CLASSES[128] = { TABLE_128(scan_class) };
+
+// class of each character after a backslash (characters above 127 match themselves)
+static constexpr unsigned char ESCAPE_CLASSES[128] = { TABLE_128(escape_class) };
+
+// rule for each context and class of character
+static constexpr ScanTransition SCAN_TABLE[NUM_CONTEXTS][NUM_CHAR_CLASSES] = {
+  // IN_REGEX
+  {
+    { TOKEN_RULE, CHARACTER },		// PLAIN_CLASS
+    { ESCAPE_RULE, CHARACTER },		// BACKSLASH_CLASS
+    { OPEN_SET_RULE, LEFT_BRACKET },	// LEFT_BRACKET_CLASS
+    { TOKEN_RULE, CHARACTER },		// RIGHT_BRACKET_CLASS
+    { TOKEN_RULE, CHARACTER },		// HYPHEN_CLASS
+    { TOKEN_RULE, ALTERNATION },	// BAR_CLASS
+    { LAZY_RULE, STAR },		// STAR_CLASS
+    { LAZY_RULE, PLUS },		// PLUS_CLASS
+    { QUESTION_RULE, QUESTION },	// QUESTION_CLASS
+    { TOKEN_RULE, LEFT_PAREN },		// LEFT_PAREN_CLASS
+    { TOKEN_RULE, RIGHT_PAREN },	// RIGHT_PAREN_CLASS
+    { TOKEN_RULE, CHAR_CLASS },		// PERIOD_CLASS (character class that includes everything)
+    { REPEAT_RULE, CHARACTER },		// LEFT_BRACE_CLASS
+    { TOKEN_RULE, CARET },		// CARET_CLASS
+    { TOKEN_RULE, DOLLAR }		// DOLLAR_CLASS
+  },
+  // IN_SET (operators match themselves)
+  {
+    { TOKEN_RULE, CHARACTER },		// PLAIN_CLASS
+    { ESCAPE_RULE, CHARACTER },		// BACKSLASH_CLASS
+    { TOKEN_RULE, CHARACTER },		// LEFT_BRACKET_CLASS
+    { CLOSE_SET_RULE, RIGHT_BRACKET },	// RIGHT_BRACKET_CLASS
+    { SET_HYPHEN_RULE, HYPHEN },	// HYPHEN_CLASS
+    { TOKEN_RULE, CHARACTER },		// BAR_CLASS
+    { TOKEN_RULE, CHARACTER },		// STAR_CLASS
+    { TOKEN_RULE, CHARACTER },		// PLUS_CLASS
+    { TOKEN_RULE, CHARACTER },		// QUESTION_CLASS
+    { TOKEN_RULE, CHARACTER },		// LEFT_PAREN_CLASS
+    { TOKEN_RULE, CHARACTER },		// RIGHT_PAREN_CLASS
+    { TOKEN_RULE, CHARACTER },		// PERIOD_CLASS
+    { TOKEN_RULE, CHARACTER },		// LEFT_BRACE_CLASS
+    { TOKEN_RULE, CARET },		// CARET_CLASS
+    { TOKEN_RULE, DOLLAR }		// DOLLAR_CLASS
+  }
+};
+
 void
-Scanner::init(string in)
+Scanner::init(const string &in)
 {
+  check_only_error = "";
+  tokens.clear();
+  tokens.reserve(in.length());
+  values.clear();
+  group_names.clear();
+  group_name_ids.clear();
   unsigned int idx = 0;
-  bool in_set = false;	// set to true when in the middle of set [] 
+  ScanContext context = IN_REGEX;
   while (idx < in.length()) {
 
-    Token token;
-    token.loc.first = idx;
-    switch (in[idx]) {
-
-    case '\\':
-    {
-      // Look at character after backslash
-      char c = get_next_char(in, idx);
-      switch (c) {
-	// Look for character classes
-	case 'd':
-	case 'D':
-	case 'w':
-	case 'W':
-	case 's':
-	case 'S':
-	  token.type = CHAR_CLASS;
-	  token.character = c;
-	  break;
-	// Treat \A the same as ^ (only differ in multi-line which is not supported)
-	case 'A':
-	  token.type = CARET;
-	  break;
-	// Treat \Z the same as $ (only differ in multi-line which is not supported)
-	case 'Z':
-	  token.type = DOLLAR;
-	  break;
-	// \b is backspace in a character set (unsupported) and word boundary otherwise
-        case 'b':
-	  if (in_set) {
-            token.type = CHARACTER;
-            token.character = '\b';
-	  }
-	  else {
-	    token.type = WORD_BOUNDARY;
-            token.loc.second = idx;
-            Alert a("ignored", "Regex contains ignored element \\b", token.loc);
-            a.warning = true;
-            Util::get()->add_alert(a);
-	  }
-	  break;
-	// \B is also treated as word boundary
-	case 'B':
-        {
-	  token.type = WORD_BOUNDARY;
-          token.loc.second = idx;
-          Alert a("ignored", "Regex contains ignored element \\B", token.loc);
-          a.warning = true;
-          Util::get()->add_alert(a);
-	  break;
-        }
-	// Escaped characters are unsupported for test generation but supported for check mode
-        // TODO: Fix test generation with these characters
-        case 'a':
-          if (Util::get()->is_check_mode()) {
-	    token.type = CHARACTER;
-	    token.character = '\a';
-          }
-          else {
-            throw EgretException("ERROR (unsupported): contains unsupported character \\a");
-          }
-	  break;
-        case 'f':
-          if (Util::get()->is_check_mode()) {
-	    token.type = CHARACTER;
-	    token.character = '\f';
-          }
-          else {
-            throw EgretException("ERROR (unsupported): contains unsupported character \\f");
-          }
-	  break;
-	case 'n':
-          if (Util::get()->is_check_mode()) {
-	    token.type = CHARACTER;
-	    token.character = '\n';
-          }
-          else {
-            throw EgretException("ERROR (unsupported): contains unsupported character \\n");
-          }
-	  break;
-	case 'r':
-          if (Util::get()->is_check_mode()) {
-	    token.type = CHARACTER;
-	    token.character = '\r';
-          }
-          else {
-            throw EgretException("ERROR (unsupported): contains unsupported character \\r");
-          }
-	  break;
-	case 't':
-          if (Util::get()->is_check_mode()) {
-	    token.type = CHARACTER;
-	    token.character = '\t';
-          }
-          else {
-            throw EgretException("ERROR (unsupported): contains unsupported character \\t");
-          }
-	  break;
-	case 'v':
-          if (Util::get()->is_check_mode()) {
-	    token.type = CHARACTER;
-	    token.character = '\v';
-          }
-          else {
-            throw EgretException("ERROR (unsupported): contains unsupported character \\v");
-          }
-	  break;
-	case 'p':
-          throw EgretException("ERROR (unsupported): contains unsupported character \\p");
-	case '\\':
-	  token.type = CHARACTER;
-	  token.character = '\\';
-	  break;
-        case '\'':
-	  token.type = CHARACTER;
-	  token.character = '\'';
-	  break;
-        case '\"':
-	  token.type = CHARACTER;
-	  token.character = '\"';
-	  break;
-	case '0': case '1': case '2': case '3': case '4':
-	case '5': case '6': case '7': case '8': case '9':
-	  token = process_octal(in, idx, c);
-	  break;
-	case 'x':
-	  token = process_hex(in, idx, 2);
-	  break;
-	case 'u':
-	  token = process_hex(in, idx, 4);
-	  break;
-	case 'U':
-	  token = process_hex(in, idx, 8);
-	  break;
-	// Everything else is a character - used for \(, \$, etc. 
-	default:
-	  token.type = CHARACTER;
-	  token.character = c;
-      }
-      break;
+    char c = in[idx];
+    unsigned char uc = c;
+    unsigned char char_class = uc < 128 ? SCAN_CLASSES[uc] : PLAIN_CLASS;
+
+    // plain characters are the common case (constructed in place)
+    if (char_class == PLAIN_CLASS) {
+      tokens.emplace_back(idx, CHARACTER, c);
+      idx++;
+      continue;
     }
 
-    case '[':
-      // check if already in set --> matches left bracket character
-      if (in_set) {
-        token.type = CHARACTER;
-        token.character = in[idx];
-      }
-      // otherwise --> start of a set
-      else {
-        token.type = LEFT_BRACKET;
-	in_set = true;
-      }
+    const ScanTransition &trans = SCAN_TABLE[context][char_class];
+    Token token;
+    token.start = idx;
+    token.type = trans.type;
+    token.character = c;
+    bool lazy = false;		// set for lazy quantifiers
+    switch (trans.rule) {
+
+    case TOKEN_RULE:
       break;
 
-    case ']': 
-      // check if first in set --> matches right bracket character
-      if (in_set && tokens.size() > 0 && tokens.back().type == LEFT_BRACKET) {
-        token.type = CHARACTER;
-        token.character = in[idx];
-      }
-      // check if in set but not first --> ends the set
-      else if (in_set) {
-	token.type = RIGHT_BRACKET;
-	in_set = false;
-      }
-      // otherwise --> matches right bracket character
-      else {
-        token.type = CHARACTER;
-        token.character = in[idx];
+    // only the matcher makes a distinction for the lazy version
+    case LAZY_RULE:
+      if ((idx + 1) < in.length() && in[idx + 1] == '?') {
+	idx++; // skip over the '?'
+	lazy = true;
       }
       break;
 
-    case '-':
-      // check if first in set --> matches hyphen character
-      if (in_set && tokens.size() > 0 && tokens.back().type == LEFT_BRACKET) {
-        token.type = CHARACTER;
-        token.character = in[idx];
-      }
-      // check if last in set --> matches hyphen chatacter
-      else if (in_set && (idx + 1) < in.length() && in[idx + 1] == ']') {
-        token.type = CHARACTER;
-        token.character = in[idx];
-      }
-      // check if in set but not first or last --> indicates a range hyphen
-      else if (in_set) {
-	token.type = HYPHEN;
-      }
-      // otherwise --> matches hyphen character
-      else {
-        token.type = CHARACTER;
-        token.character = in[idx];
-      }
+    case ESCAPE_RULE:
+      token = process_escape(in, idx, context == IN_SET);
       break;
 
-    case '|':
-      // check if in set --> matches vertical bar character
-      if (in_set) {
-        token.type = CHARACTER;
-        token.character = in[idx];
-      }
-      // otherwise --> alternation
-      else {
-        token.type = ALTERNATION;
-      }
+    case OPEN_SET_RULE:
+      context = IN_SET;
       break;
 
-    case '*':
-      // check if in set --> matches asterisk character
-      if (in_set) {
+    case CLOSE_SET_RULE:
+      // check if first in set --> matches right bracket character
+      if (tokens.back().type == LEFT_BRACKET) {
         token.type = CHARACTER;
-        token.character = in[idx];
-      }
-      // check for lazy '*?' --> Kleene star
-      // (no distinction is made for lazy version)
-      else if (!in_set && (idx + 1) < in.length() && in[idx + 1] == '?') {
-	idx++; // skip over the '?'
-	token.type = STAR;
       }
-      // otherwise --> Kleene star
       else {
-        token.type = STAR;
+        context = IN_REGEX;
       }
       break;
 
-    case '+':
-      // check if in set --> matches plus character
-      if (in_set) {
+    case SET_HYPHEN_RULE:
+      // check if first or last in set --> matches hyphen character
+      if (tokens.back().type == LEFT_BRACKET ||
+	  ((idx + 1) < in.length() && in[idx + 1] == ']')) {
         token.type = CHARACTER;
-        token.character = in[idx];
-      }
-      // check for lazy '+?' --> plus
-      // (no distinction is made for lazy version)
-      else if (!in_set && (idx + 1) < in.length() && in[idx + 1] == '?') {
-	idx++; // skip over the '?'
-	token.type = PLUS;
-      }
-      // otherwise --> plus (1 or more repetition)
-      else {
-        token.type = PLUS;
       }
       break;
 
-    case '?':
-      // check if in indicates extension
+    case QUESTION_RULE:
+      // check if it indicates an extension
       if (tokens.size() > 0 && tokens.back().type == LEFT_PAREN) {
 	token = process_extension(in, idx);
       }
-      // check if in set --> matches question mark character
-      else if (in_set) {
-        token.type = CHARACTER;
-        token.character = in[idx];
-      }
       // check for lazy '??' --> optional operator
-      // (no distinction is made for lazy version)
-      else if (!in_set && (idx + 1) < in.length() && in[idx + 1] == '?') {
+      else if ((idx + 1) < in.length() && in[idx + 1] == '?') {
 	idx++; // skip over the second '?'
-	token.type = QUESTION;
-      }
-      // otherwise --> optional operator (matches 0 or 1)
-      else {
-        token.type = QUESTION;
+	lazy = true;
       }
       break;
 
-    case '(':
-      // check if in set --> matches left parentheses character
-      if (in_set) {
-        token.type = CHARACTER;
-        token.character = in[idx];
-      }
-      // otherwise --> start of a group
-      else {
-        token.type = LEFT_PAREN;
+    case REPEAT_RULE:
+      token = process_repeat(in, idx);
+      // check for lazy repeat - skip over the '?' if present
+      if (token.type != CHARACTER && (idx + 1) < in.length() && in[idx + 1] == '?') {
+	idx++;
+	lazy = true;
       }
       break;
-
-    case ')':
-      // check if in set --> matches right parentheses character
-      if (in_set) {
-        token.type = CHARACTER;
-        token.character = in[idx];
-      }
-      // otherwise --> end of a group
-      else {
-        token.type = RIGHT_PAREN;
-      }
-      break;
-
-    case '.':
-      // check if in set --> matches period character
-      if (in_set) {
-        token.type = CHARACTER;
-        token.character = in[idx];
-      }
-      // otherwise --> character class that includes everything
-      else {
-        token.type = CHAR_CLASS;
-	token.character = in[idx];
-      }
-      break;
-
-    case '{':
-      // check if in set --> matches left brace
-      if (in_set) {
-	token.type = CHARACTER;
-        token.character = in[idx];
-      }
-      // otherwise --> process a possible repeat clause
-      else {
-        token = process_repeat(in, idx);
-        // check for lazy repeat - skip over the '?' if present
-        if (token.type != CHARACTER && (idx + 1) < in.length() && in[idx + 1] == '?') {
-	  idx++;
-        }
-      }
-      break;
-
-    case '^':
-      token.type = CARET;
-      break;
-
-    case '$':
-      token.type = DOLLAR;
-      break;
-
-    default:
-      token.type = CHARACTER;
-      token.character = in[idx];
     }
 
-    token.loc.second = idx;
+    token.end = idx;
+    token.lazy = lazy;
     tokens.push_back(token);
     idx++;
   }
@@ -383,8 +289,8 @@ Scanner::init(string in)
   int curr_index = 0;
   vector <Token>::iterator vi;
   for (vi = tokens.begin(); vi != tokens.end(); vi++) {
-    int start = vi->loc.first;
-    int end = vi->loc.second;
+    int start = vi->start;
+    int end = vi->end;
     if (start != curr_index) {
       print();
       throw EgretException("ERROR (internal): Token location not set properly");
@@ -397,8 +303,91 @@ Scanner::init(string in)
   }
 }
 
+Token
+Scanner::process_escape(const string &in, unsigned int &idx, bool in_set)
+{
+  Token token;
+  token.start = idx;
+
+  // Look at character after backslash
+  char c = get_next_char(in, idx);
+  unsigned char uc = c;
+  token.type = CHARACTER;
+  token.character = c;
+
+  switch (uc < 128 ? ESCAPE_CLASSES[uc] : ESCAPED_CHAR) {
+
+  case ESCAPED_CHAR:
+    break;
+
+  case ESCAPED_CLASS:
+    token.type = CHAR_CLASS;
+    break;
+
+  case ESCAPED_CARET:
+    token.type = CARET;
+    break;
+
+  case ESCAPED_DOLLAR:
+    token.type = DOLLAR;
+    break;
+
+  case ESCAPED_BACKSPACE:
+    if (in_set) {
+      token.character = '\b';
+      break;
+    }
+    // fall through
+
+  case ESCAPED_BOUNDARY:
+  {
+    token.type = WORD_BOUNDARY;
+    token.end = idx;
+    Alert a("ignored", string("Regex contains ignored element \\") + c, token.get_loc());
+    a.warning = true;
+    Util::get()->add_alert(a);
+    break;
+  }
+
+  // Escaped characters are unsupported for test generation but supported for check mode
+  // TODO: Fix test generation with these characters
+  case ESCAPED_CONTROL:
+    check_mode_only(string("ERROR (unsupported): contains unsupported character \\") + c);
+    switch (c) {
+      case 'a': token.character = '\a'; break;
+      case 'f': token.character = '\f'; break;
+      case 'n': token.character = '\n'; break;
+      case 'r': token.character = '\r'; break;
+      case 't': token.character = '\t'; break;
+      case 'v': token.character = '\v'; break;
+    }
+    break;
+
+  case ESCAPED_UNSUPPORTED:
+    throw EgretException(string("ERROR (unsupported): contains unsupported character \\") + c);
+
+  case ESCAPED_DIGIT:
+    token = process_octal(in, idx, c);
+    break;
+
+  case ESCAPED_HEX:
+    token = process_hex(in, idx, c == 'x' ? 2 : (c == 'u' ? 4 : 8));
+    break;
+  }
+
+  return token;
+}
+
+void
+Scanner::check_mode_only(string error)
+{
+  // test generation does not support the character
+  if (!Util::get()->is_check_mode()) throw EgretException(error);
+  if (check_only_error == "") check_only_error = error;
+}
+
 char
-Scanner::get_next_char(string in, unsigned int &idx)
+Scanner::get_next_char(const string &in, unsigned int &idx)
 {
   idx++;
   if (idx >= in.length()) {
@@ -408,7 +397,7 @@ Scanner::get_next_char(string in, unsigned int &idx)
 }
 
 Token
-Scanner::process_octal(string in, unsigned int &idx, char first_digit)
+Scanner::process_octal(const string &in, unsigned int &idx, char first_digit)
 {
   bool octal_found = false;
   bool only_one_digit = false;
@@ -416,7 +405,7 @@ Scanner::process_octal(string in, unsigned int &idx, char first_digit)
   char second_digit;
   char third_digit;
   Token token;
-  token.loc.first = idx - 1;
+  token.start = idx - 1;
  
   // grab the second digit if one exists
   if (idx + 1 >= in.length()) {
@@ -430,19 +419,14 @@ Scanner::process_octal(string in, unsigned int &idx, char first_digit)
   // only one digit - either null or backreference (both are unsupported)
   if (only_one_digit) {
     if (first_digit == '0') {
-      if (Util::get()->is_check_mode()) {
-        token.type = CHARACTER;
-        token.character = '\0';
-        return token;
-      }
-      else {
-        throw EgretException("ERROR (unsupported): contains unsupported character \\0");
-      }
+      check_mode_only("ERROR (unsupported): contains unsupported character \\0");
+      token.type = CHARACTER;
+      token.character = '\0';
+      return token;
     }
     else {
       token.type = BACKREFERENCE;
-      token.group_num = first_digit - '0';
-      token.group_name = "";
+      set_group_value(first_digit - '0', "");
       return token;
     }
   }
@@ -469,19 +453,17 @@ Scanner::process_octal(string in, unsigned int &idx, char first_digit)
     }
 
     // check the validity of the octal value
-    if (octal_value > 126 || (octal_value < 32 && !Util::get()->is_check_mode())) {
-      stringstream s;
-      s << "ERROR (unsupported): contains unsupported octal value " << octal_value;
-      throw EgretException(s.str());
-    }
+    stringstream s;
+    s << "ERROR (unsupported): contains unsupported octal value " << octal_value;
+    if (octal_value > 126) throw EgretException(s.str());
+    if (octal_value < 32) check_mode_only(s.str());
 
     token.type = CHARACTER;
     token.character = octal_value;
   }
   else {
     token.type = BACKREFERENCE;
-    token.group_num = ((first_digit - '0') * 10) + (second_digit - '0');
-    token.group_name = "";
+    set_group_value(((first_digit - '0') * 10) + (second_digit - '0'), "");
     idx++;
   }
 
@@ -489,10 +471,10 @@ Scanner::process_octal(string in, unsigned int &idx, char first_digit)
 }
     
 Token
-Scanner::process_hex(string in, unsigned int &idx, int num_digits)
+Scanner::process_hex(const string &in, unsigned int &idx, int num_digits)
 {
   Token token;
-  token.loc.first = idx - 1;
+  token.start = idx - 1;
 
   int hex_value = 0;
   for (int i = 0; i < num_digits; i++) {
@@ -519,11 +501,10 @@ Scanner::process_hex(string in, unsigned int &idx, int num_digits)
   }
 
   // check the validity of the hex value
-  if (hex_value > 126 || (hex_value < 32 && !Util::get()->is_check_mode())) {
-    stringstream s;
-    s << "ERROR (unsupported): contains unsupported hex value " << hex_value;
-    throw EgretException(s.str());
-  }
+  stringstream s;
+  s << "ERROR (unsupported): contains unsupported hex value " << hex_value;
+  if (hex_value > 126) throw EgretException(s.str());
+  if (hex_value < 32) check_mode_only(s.str());
 
   // return the hex value
   token.type = CHARACTER;
@@ -533,10 +514,10 @@ Scanner::process_hex(string in, unsigned int &idx, int num_digits)
 }
 
 Token
-Scanner::process_extension(string in, unsigned int &idx)
+Scanner::process_extension(const string &in, unsigned int &idx)
 {
   Token token;
-  token.loc.first = idx;
+  token.start = idx;
   int start_loc = idx;
 
   // get type of extension
@@ -559,8 +540,7 @@ Scanner::process_extension(string in, unsigned int &idx)
       }
       idx--;
       token.type = BACKREFERENCE;
-      token.group_num = 0;
-      token.group_name = s.str();
+      set_group_value(0, s.str());
     }
     else if (c != '<') {
       throw EgretException("ERROR (parse error): Improperly specified named group - expected < after (?P");
@@ -573,7 +553,7 @@ Scanner::process_extension(string in, unsigned int &idx)
 	  s << c;
       }
       token.type = NAMED_GROUP_EXT;
-      token.group_name = s.str();
+      set_group_value(0, s.str());
     }
     break;
   }
@@ -623,8 +603,21 @@ Scanner::process_extension(string in, unsigned int &idx)
   return token;
 }
 
+// returns the value of a string of digits (the largest int if it does not fit,
+// as when it is read from a stream)
+static int
+get_count(const string &digits)
+{
+  long long count = 0;
+  for (unsigned int i = 0; i < digits.size(); i++) {
+    count = (count * 10) + (digits[i] - '0');
+    if (count > INT_MAX) return INT_MAX;
+  }
+  return count;
+}
+
 Token
-Scanner::process_repeat(string in, unsigned int &idx)
+Scanner::process_repeat(const string &in, unsigned int &idx)
 {
   // Based on execution of Python, the repeat quantifier must have one of these forms:
   // {n}  	: matches exactly n times
@@ -647,9 +640,11 @@ Scanner::process_repeat(string in, unsigned int &idx)
   // 
   int current_idx = idx;
   Token token;
-  token.loc.first = idx;
+  token.start = idx;
   token.type = CHARACTER;
   token.character = '{';
+  int repeat_lower = -1;
+  int repeat_upper = -1;
 
   // Keep looping while reading in digits.
   string count_str = "";
@@ -663,12 +658,11 @@ Scanner::process_repeat(string in, unsigned int &idx)
   if (c == ',') {
     // No lower bound number --> use -1 to represent no lower bound
     if (count_str == "") {
-      token.repeat_lower = -1;
+      repeat_lower = -1;
     }
     // Otherwise store lower bound
     else {
-      stringstream ss(count_str);
-      ss >> token.repeat_lower; 
+      repeat_lower = get_count(count_str);
     }
   }
 
@@ -680,13 +674,13 @@ Scanner::process_repeat(string in, unsigned int &idx)
       return token;
     }
     // Otherwise return REPEAT token with identical lower and upper bounds
-    stringstream ss(count_str);
-    ss >> token.repeat_lower; 
-    token.repeat_upper = token.repeat_lower;
+    repeat_lower = get_count(count_str);
+    repeat_upper = repeat_lower;
     token.type = REPEAT;
-    if (token.repeat_upper == 0) {
+    if (repeat_upper == 0) {
       throw EgretException("ERROR (pointless repeat): pointless repeat quantifier {0}");
     }
+    set_repeat_value(repeat_lower, repeat_upper);
     return token;
   }
 
@@ -708,43 +702,44 @@ Scanner::process_repeat(string in, unsigned int &idx)
   if (c == '}') {
     // No upper bound number --> use -1 to represent no upper bound
     if (count_str == "") {
-      token.repeat_upper = -1;
+      repeat_upper = -1;
     }
     // Otherwise store upper bound
     else {
-      stringstream ss(count_str);
-      ss >> token.repeat_upper; 
+      repeat_upper = get_count(count_str);
     }
 
     // Check for no bounds, at least one must be present.  If not --> literal match
-    if (token.repeat_lower == -1 && token.repeat_upper == -1) {
+    if (repeat_lower == -1 && repeat_upper == -1) {
       idx = current_idx;
       return token;
     }
 
     // If no lower bound, adjust lower bound to 0
-    if (token.repeat_lower == -1) token.repeat_lower = 0;
+    if (repeat_lower == -1) repeat_lower = 0;
     
     // If no upper bound, return now.
-    if (token.repeat_upper == -1) {
+    if (repeat_upper == -1) {
       token.type = REPEAT;
+      set_repeat_value(repeat_lower, repeat_upper);
       return token;
     }
 
     // Check that lower bound is less than or equal to the upper bound
-    if (token.repeat_lower > token.repeat_upper) {
+    if (repeat_lower > repeat_upper) {
       stringstream s;
-      s << "ERROR (parse error): Invalid repeat quantifier: lower bound " << token.repeat_lower
-	<< " is greater than upper bound " << token.repeat_upper << endl;
+      s << "ERROR (parse error): Invalid repeat quantifier: lower bound " << repeat_lower
+	<< " is greater than upper bound " << repeat_upper << endl;
       throw EgretException(s.str());
     }
 
     // Check for the nonsensical upper bound of zero {0,0}
-    if (token.repeat_upper == 0) {
+    if (repeat_upper == 0) {
       throw EgretException("ERROR (pointless repeat): pointless repeat quantifier {0,0}");
     }
 
     token.type = REPEAT;
+    set_repeat_value(repeat_lower, repeat_upper);
     return token;
   }
 
@@ -759,7 +754,7 @@ TokenType
 Scanner::get_type()
 {
   if (index < tokens.size())
-    return tokens[index].type;
+    return tokens[index].get_type();
   else
     return ERR;
 }
@@ -774,11 +769,14 @@ Location
 Scanner::get_loc()
 {
   if (index < tokens.size()) {
-    return tokens[index].loc;
+    return tokens[index].get_loc();
+  }
+  else if (tokens.empty()) {
+    return make_pair(0, 0);
   }
   else {
-    Location loc = tokens[tokens.size() - 1].loc;
-    return make_pair(loc.second + 1, loc.second + 1);
+    int end = tokens[tokens.size() - 1].end;
+    return make_pair(end + 1, end + 1);
   }
 }
 
@@ -788,7 +786,7 @@ Scanner::get_repeat_lower()
   TokenType type = get_type();
   assert(type == REPEAT);
 
-  return tokens[index].repeat_lower;
+  return values[index].repeat_lower;
 }
 
 int
@@ -797,14 +795,23 @@ Scanner::get_repeat_upper()
   TokenType type = get_type();
   assert(type == REPEAT);
 
-  return tokens[index].repeat_upper;
+  return values[index].repeat_upper;
+}
+
+bool
+Scanner::is_lazy()
+{
+  TokenType type = get_type();
+  assert(type == STAR || type == PLUS || type == QUESTION || type == REPEAT);
+
+  return tokens[index].lazy;
 }
 
 char
 Scanner::get_character()
 {
   TokenType type = get_type();
-  assert(type == CHARACTER || type == CHAR_CLASS);
+  assert(type == CHARACTER || type == CHAR_CLASS || type == DOLLAR);
 
   return tokens[index].character;
 }
@@ -815,16 +822,16 @@ Scanner::get_group_num()
   TokenType type = get_type();
   assert(type == BACKREFERENCE);
 
-  return tokens[index].group_num;
+  return values[index].group_num;
 }
 
-string
+const string &
 Scanner::get_group_name()
 {
   TokenType type = get_type();
   assert(type == BACKREFERENCE || type == NAMED_GROUP_EXT);
 
-  return tokens[index].group_name;
+  return group_names[values[index].group_name];
 }
 
 void
@@ -836,7 +843,7 @@ Scanner::advance()
 bool
 Scanner::is_concat()
 {
-  TokenType prev_type = tokens[index - 1].type; // previous character type
+  TokenType prev_type = tokens[index - 1].get_type(); // previous character type
   TokenType next_type = get_type(); // current character type
 
   if (index >= tokens.size()) return false;
@@ -885,10 +892,10 @@ Scanner::print()
 {
   cout << "Scanner: " << endl;
   for (unsigned i = 0; i < tokens.size(); i++) {
-    cout << tokens[i].loc.first << "-" << tokens[i].loc.second << ": ";
-    cout << token_type_to_str(tokens[i].type);
+    cout << tokens[i].start << "-" << tokens[i].end << ": ";
+    cout << token_type_to_str(tokens[i].get_type());
     if (tokens[i].type == REPEAT) {
-      cout << ":" << tokens[i].repeat_lower << "," << tokens[i].repeat_upper;
+      cout << ":" << values[i].repeat_lower << "," << values[i].repeat_upper;
     }
     if (tokens[i].type == CHARACTER || tokens[i].type == CHAR_CLASS) {
       cout << ":" << tokens[i].character;
@@ -898,6 +905,28 @@ Scanner::print()
   cout << endl;
 }
 
+void
+Scanner::set_repeat_value(int lower, int upper)
+{
+  TokenValue &value = values[tokens.size()];
+  value.repeat_lower = lower;
+  value.repeat_upper = upper;
+}
+
+void
+Scanner::set_group_value(int num, const string &name)
+{
+  map <string, unsigned int>::iterator it = group_name_ids.find(name);
+  if (it == group_name_ids.end()) {
+    it = group_name_ids.insert(make_pair(name, group_names.size())).first;
+    group_names.push_back(name);
+  }
+
+  TokenValue &value = values[tokens.size()];
+  value.group_num = num;
+  value.group_name = it->second;
+}
+
 string
 Scanner::token_type_to_str(TokenType type)
 {
@@ -931,4 +960,5 @@ void
 Scanner::add_stats(Stats &stats)
 {
   stats.add("SCANNER", "Tokens", tokens.size());
+  stats.add("SCANNER", "Token values", values.size());
 }
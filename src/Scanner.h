@@ -25,6 +25,7 @@
 #ifndef SCANNER_H
 #define SCANNER_H
 
+#include <map>
 #include <string>
 #include <vector>
 #include "Stats.h"
@@ -59,15 +60,33 @@ typedef enum
   ERR			// error 
 } TokenType;
 
+// Tokens are kept small since there is one for nearly every character of the
+// regex: the values only needed by a few token types (repeat bounds and group
+// numbers and names) are stored in a side table of the scanner.
 struct Token
 {
-  TokenType type;
-  Location loc;         // location in regular expression <start, end>
+  unsigned int start;	// location in regular expression <start, end>
+  unsigned int end;
+  unsigned char type;	// TokenType
+  char character;	// for CHARACTER and CHAR_CLASS
+  bool lazy;		// for STAR, PLUS, QUESTION, and REPEAT (set if lazy)
+
+  Token() {}
+  Token(unsigned int s, TokenType t, char c) {
+    start = s; end = s; type = t; character = c; lazy = false;
+  }
+
+  TokenType get_type() const { return (TokenType) type; }
+  Location get_loc() const { return make_pair((int) start, (int) end); }
+};
+
+// Values for REPEAT, BACKREFERENCE, and NAMED_GROUP_EXT tokens
+struct TokenValue
+{
   int repeat_lower;	// for REPEAT
   int repeat_upper;	// for REPEAT (-1 for no limit)
-  char character;	// for CHARACTER and CHAR_CLASS
   int group_num;        // for BACKREFERENCE
-  string group_name;    // for BACKREFERENCE and NAMED_GROUP_EXT
+  unsigned int group_name;  // for BACKREFERENCE and NAMED_GROUP_EXT (index into group names)
 };
 
 // A scanner class, encapsulates the input stream as a set of tokens
@@ -76,10 +95,14 @@ class Scanner {
 
 public:
 
-  vector <Token> get_tokens() { return tokens; }
+  vector <Token> &get_tokens() { return tokens; }
+
+  // returns the error test generation gives for the first character that is only
+  // supported in check mode (blank if there are none)
+  string get_check_only_error() { return check_only_error; }
 
   // scans through input string and creates a vector of tokens
-  void init(string in);
+  void init(const string &in);
 
   // TODO: Consider returning a token instead of all these specialized functions
   // returns type for current token
@@ -97,14 +120,17 @@ public:
   // returns repeat upper bound of current token
   int get_repeat_upper();
 
-  // returns character associated with current token
+  // returns true if current repeat token is lazy
+  bool is_lazy();
+
+  // returns character associated with current token (for a dollar, '$' or 'Z')
   char get_character();
 
   // returns the group number for a backreference
   int get_group_num();
 
   // returns the group name for a backreference or named group
-  string get_group_name();
+  const string &get_group_name();
 
   // advance to the next token
   void advance();
@@ -124,22 +150,38 @@ public:
 private:
 
   vector <Token> tokens;	// stores the regular expression
+  map <unsigned int, TokenValue> values;	// token values (by token index)
+  vector <string> group_names;	// group names (interned)
+  map <string, unsigned int> group_name_ids;	// index of each group name
   unsigned index;		// iterator
+  string check_only_error;	// error for first character only supported in check mode
+
+  // allows a character only supported in check mode, throws the error otherwise
+  void check_mode_only(string error);
 
   // get next character from input string
-  char get_next_char(string in, unsigned int &idx);
+  char get_next_char(const string &in, unsigned int &idx);
+
+  // process an escape sequence (idx is the location of the backslash)
+  Token process_escape(const string &in, unsigned int &idx, bool in_set);
 
   // process octal character 
-  Token process_octal(string in, unsigned int &idx, char first_digit);
+  Token process_octal(const string &in, unsigned int &idx, char first_digit);
 
   // process hexadecimal character 
-  Token process_hex(string in, unsigned int &idx, int num_digits);
+  Token process_hex(const string &in, unsigned int &idx, int num_digits);
 
   // processes Python extensions for regular expressions
-  Token process_extension(string in, unsigned int &idx);
+  Token process_extension(const string &in, unsigned int &idx);
 
   // process a repeat quantifier {}
-  Token process_repeat(string in, unsigned int &idx);
+  Token process_repeat(const string &in, unsigned int &idx);
+
+  // sets the value of the token being scanned to a repeat quantifier
+  void set_repeat_value(int lower, int upper);
+
+  // sets the value of the token being scanned to a group
+  void set_group_value(int num, const string &name);
 
   // returns string name of a token
   string token_type_to_str(TokenType type);
@@ -0,0 +1,464 @@
+/*  SourceScanner.cpp: Finds regex literals in source files
+
+    Copyright (C) 2016-2018  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cctype>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "SourceScanner.h"
+#include "Stats.h"
+#include "Util.h"
+using namespace std;
+
+// Python re functions whose first argument is the pattern and the position of
+// their flags argument
+static const unsigned int NUM_RE_FUNCTIONS = 9;
+static const char *RE_FUNCTIONS[NUM_RE_FUNCTIONS] = { "compile", "match", "search",
+  "fullmatch", "findall", "finditer", "sub", "subn", "split" };
+static const unsigned int FLAGS_POSITIONS[NUM_RE_FUNCTIONS] = { 1, 2, 2, 2, 2, 2, 4, 4, 3 };
+
+static bool
+is_ident_char(char c)
+{
+  return isalnum((unsigned char) c) || c == '_';
+}
+
+static bool
+literal_before(const RegexLiteral &a, const RegexLiteral &b)
+{
+  return a.line < b.line;
+}
+
+void
+SourceScanner::build(string path)
+{
+  files.clear();
+  literals.clear();
+  num_skipped = 0;
+  num_unreadable = 0;
+
+  struct stat info;
+  if (stat(path.c_str(), &info) != 0) {
+    throw EgretException("ERROR (bad arguments): Unable to open " + path);
+  }
+  if (S_ISDIR(info.st_mode)) {
+    scan_dir(path);
+  }
+  else {
+    scan_file(path);
+  }
+}
+
+void
+SourceScanner::scan_dir(string path)
+{
+  DIR *dir = opendir(path.c_str());
+  if (dir == NULL) {
+    num_unreadable++;
+    return;
+  }
+
+  // entries are sorted so the files are always scanned in the same order
+  vector <string> names;
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != NULL) {
+    if (entry->d_name[0] != '.') names.push_back(entry->d_name);
+  }
+  closedir(dir);
+  sort(names.begin(), names.end());
+
+  vector <string>::iterator it;
+  for (it = names.begin(); it != names.end(); it++) {
+    string child = path + "/" + *it;
+    struct stat info;
+    if (lstat(child.c_str(), &info) != 0) continue;
+    if (S_ISDIR(info.st_mode)) {
+      scan_dir(child);
+    }
+    else if (S_ISREG(info.st_mode) && it->size() > 3 &&
+        it->compare(it->size() - 3, 3, ".py") == 0) {
+      scan_file(child);
+    }
+  }
+}
+
+void
+SourceScanner::scan_file(string path)
+{
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd == -1) {
+    num_unreadable++;
+    return;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0) {
+    close(fd);
+    num_unreadable++;
+    return;
+  }
+
+  files.push_back(path);
+  size_t size = info.st_size;
+  if (size == 0) {
+    close(fd);
+    return;
+  }
+
+  void *text = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (text == MAP_FAILED) {
+    files.pop_back();
+    num_unreadable++;
+    return;
+  }
+  scan_python((const char *) text, size, files.size() - 1);
+  munmap(text, size);
+}
+
+void
+SourceScanner::scan_python(const char *text, size_t size, unsigned int file)
+{
+  // Comments and strings are skipped while looking for re.<function>( followed
+  // by string literals (adjacent literals are concatenated) and then , or ).
+  size_t first_literal = literals.size();
+  size_t pos = 0;
+  size_t counted = 0;		// position up to which lines are counted
+  unsigned int line = 1;
+  while (pos < size) {
+    char c = text[pos];
+    if (c == '#') {
+      while (pos < size && text[pos] != '\n') pos++;
+      continue;
+    }
+    if (is_string_start(text, size, pos)) {
+      string value;
+      read_string(text, size, pos, value);
+      continue;
+    }
+    if (!is_ident_char(c)) {
+      pos++;
+      continue;
+    }
+
+    // identifier - check for the re module (but not an attribute named re)
+    size_t start = pos;
+    while (pos < size && is_ident_char(text[pos])) pos++;
+    if (pos - start != 2 || text[start] != 'r' || text[start + 1] != 'e') continue;
+    if (start > 0 && text[start - 1] == '.') continue;
+    if (pos >= size || text[pos] != '.') continue;
+
+    size_t name_end = pos + 1;
+    while (name_end < size && is_ident_char(text[name_end])) name_end++;
+    string name(text + pos + 1, name_end - pos - 1);
+    unsigned int i = 0;
+    while (i < NUM_RE_FUNCTIONS && name != RE_FUNCTIONS[i]) i++;
+    if (i == NUM_RE_FUNCTIONS) continue;
+    pos = name_end;
+    skip_space(text, size, pos);
+    if (pos >= size || text[pos] != '(') continue;
+    pos++;
+
+    // scanning continues inside the call so nested calls are found
+    vector <CallArg> args;
+    if (!read_args(text, size, pos, args)) continue;
+    const CallArg *pattern = NULL;
+    const CallArg *flags = NULL;
+    unsigned int num_positional = 0;
+    vector <CallArg>::iterator it;
+    for (it = args.begin(); it != args.end(); it++) {
+      if (it->keyword == "") {
+        if (num_positional == 0) pattern = &(*it);
+        if (num_positional == FLAGS_POSITIONS[i]) flags = &(*it);
+        num_positional++;
+      }
+      else if (it->keyword == "pattern") pattern = &(*it);
+      else if (it->keyword == "flags") flags = &(*it);
+    }
+    if (pattern == NULL) continue;
+
+    // the pattern must be string literals
+    size_t literal_pos = pattern->start;
+    size_t arg_pos = pattern->start;
+    size_t value_end = arg_pos;
+    string regex;
+    bool known = is_string_start(text, size, arg_pos);
+    while (known && is_string_start(text, size, arg_pos)) {
+      string value;
+      if (!read_string(text, size, arg_pos, value)) known = false;
+      regex += value;
+      value_end = arg_pos;
+      skip_space(text, size, arg_pos);
+    }
+    if (!known || value_end != pattern->end) {
+      num_skipped++;
+      continue;
+    }
+
+    // a pattern keyword can follow a nested call with an earlier literal
+    if (literal_pos < counted) {
+      counted = 0;
+      line = 1;
+    }
+    for (; counted < literal_pos; counted++) {
+      if (text[counted] == '\n') line++;
+    }
+    RegexLiteral literal;
+    literal.regex = regex;
+    literal.file = file;
+    literal.line = line;
+
+    // the flags are kept as written (with runs of space collapsed), 0 is no flags
+    if (flags != NULL) {
+      for (size_t p = flags->start; p < flags->end; p++) {
+        if (isspace((unsigned char) text[p]) || (text[p] == '\\' && text[p + 1] == '\n')) {
+          if (literal.flags != "" && literal.flags[literal.flags.size() - 1] != ' ') literal.flags += ' ';
+        }
+        else {
+          literal.flags += text[p];
+        }
+      }
+      if (literal.flags == "0") literal.flags = "";
+    }
+    literals.push_back(literal);
+  }
+  stable_sort(literals.begin() + first_literal, literals.end(), literal_before);
+}
+
+bool
+SourceScanner::read_args(const char *text, size_t size, size_t pos, vector <CallArg> &args)
+{
+  // Strings, comments, and nested brackets are skipped while looking for the
+  // commas and the closing parenthesis of the call.
+  unsigned int depth = 0;
+  skip_space(text, size, pos);
+  CallArg arg;
+  arg.start = pos;
+  arg.end = pos;
+  while (pos < size) {
+    char c = text[pos];
+    if (depth == 0 && (c == ',' || c == ')')) {
+      // a trailing comma leaves an empty argument
+      if (arg.end > arg.start) {
+        // keyword arguments start with an identifier followed by a single =
+        size_t p = arg.start;
+        while (p < arg.end && is_ident_char(text[p])) p++;
+        size_t name_end = p;
+        skip_space(text, size, p);
+        if (name_end > arg.start && p + 1 < arg.end && text[p] == '=' && text[p + 1] != '=') {
+          arg.keyword = string(text + arg.start, name_end - arg.start);
+          p++;
+          skip_space(text, size, p);
+          arg.start = p;
+        }
+        args.push_back(arg);
+      }
+      if (c == ')') return true;
+      pos++;
+      skip_space(text, size, pos);
+      arg.keyword = "";
+      arg.start = pos;
+      arg.end = pos;
+      continue;
+    }
+
+    if (c == '#') {
+      skip_space(text, size, pos);
+      continue;
+    }
+    if (is_string_start(text, size, pos)) {
+      string value;
+      read_string(text, size, pos, value);
+    }
+    else if (is_ident_char(c)) {
+      while (pos < size && is_ident_char(text[pos])) pos++;
+    }
+    else {
+      if (c == '(' || c == '[' || c == '{') depth++;
+      if (c == ')' || c == ']' || c == '}') {
+        if (depth == 0) return false;
+        depth--;
+      }
+      pos++;
+    }
+    arg.end = pos;
+    skip_space(text, size, pos);
+  }
+  return false;
+}
+
+bool
+SourceScanner::is_string_start(const char *text, size_t size, size_t pos)
+{
+  // up to two prefix letters (r, b, u, f in either case) before the quote
+  for (unsigned int i = 0; i < 3 && pos + i < size; i++) {
+    char c = text[pos + i];
+    if (c == '\'' || c == '"') return true;
+    if (string("rRbBuUfF").find(c) == string::npos) return false;
+  }
+  return false;
+}
+
+bool
+SourceScanner::read_string(const char *text, size_t size, size_t &pos, string &value)
+{
+  bool raw = false;
+  bool bytes = false;
+  bool known = true;
+  while (text[pos] != '\'' && text[pos] != '"') {
+    char prefix = tolower(text[pos]);
+    if (prefix == 'r') raw = true;
+    if (prefix == 'b') bytes = true;
+    if (prefix == 'f') known = false;
+    pos++;
+  }
+
+  char quote = text[pos];
+  bool triple = (pos + 2 < size && text[pos + 1] == quote && text[pos + 2] == quote);
+  pos += triple ? 3 : 1;
+
+  while (pos < size) {
+    char c = text[pos];
+    if (c == quote && (!triple || (pos + 2 < size && text[pos + 1] == quote && text[pos + 2] == quote))) {
+      pos += triple ? 3 : 1;
+      return known;
+    }
+    if (c == '\n' && !triple) return false;		// unterminated string
+    if (c != '\\' || pos + 1 >= size) {
+      // non-ASCII characters (UTF-8 bytes) are not supported by the engine
+      if ((unsigned char) c >= 128) known = false;
+      value += c;
+      pos++;
+      continue;
+    }
+
+    // escape sequences (the backslash is kept in raw strings and unknown escapes)
+    char e = text[pos + 1];
+    pos += 2;
+    if (raw) {
+      value += c;
+      value += e;
+      continue;
+    }
+    switch (e) {
+      case '\n':
+        break;
+      case '\\': case '\'': case '"':
+        value += e;
+        break;
+      case 'a': value += '\a'; break;
+      case 'b': value += '\b'; break;
+      case 'f': value += '\f'; break;
+      case 'n': value += '\n'; break;
+      case 'r': value += '\r'; break;
+      case 't': value += '\t'; break;
+      case 'v': value += '\v'; break;
+      case 'x':
+      {
+        int code = 0;
+        for (int i = 0; i < 2; i++) {
+          if (pos >= size || !isxdigit((unsigned char) text[pos])) {
+            known = false;
+            break;
+          }
+          char digit = tolower(text[pos++]);
+          code = code * 16 + (isdigit((unsigned char) digit) ? digit - '0' : digit - 'a' + 10);
+        }
+        if (code > 127) known = false;
+        value += (char) code;
+        break;
+      }
+      case 'u': case 'U':
+      {
+        // unicode escapes are only kept in byte strings, ASCII characters are decoded
+        if (bytes) {
+          value += c;
+          value += e;
+          break;
+        }
+        unsigned long code = 0;
+        for (int i = 0; i < (e == 'u' ? 4 : 8); i++) {
+          if (pos >= size || !isxdigit((unsigned char) text[pos])) {
+            known = false;
+            break;
+          }
+          char digit = tolower(text[pos++]);
+          code = code * 16 + (isdigit((unsigned char) digit) ? digit - '0' : digit - 'a' + 10);
+        }
+        if (code > 127) known = false;
+        value += (char) code;
+        break;
+      }
+      case 'N':
+        // named escapes are only kept in byte strings
+        if (!bytes) known = false;
+        value += c;
+        value += e;
+        break;
+      default:
+        if (e >= '0' && e <= '7') {
+          int code = e - '0';
+          for (int i = 0; i < 2 && pos < size && text[pos] >= '0' && text[pos] <= '7'; i++) {
+            code = code * 8 + (text[pos++] - '0');
+          }
+          if (code > 127) known = false;
+          value += (char) code;
+        }
+        else {
+          value += c;
+          value += e;
+        }
+        break;
+    }
+  }
+  return false;
+}
+
+void
+SourceScanner::skip_space(const char *text, size_t size, size_t &pos)
+{
+  while (pos < size) {
+    char c = text[pos];
+    if (c == '#') {
+      while (pos < size && text[pos] != '\n') pos++;
+    }
+    else if (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' ||
+        (c == '\\' && pos + 1 < size && text[pos + 1] == '\n')) {
+      pos++;
+    }
+    else {
+      break;
+    }
+  }
+}
+
+void
+SourceScanner::add_stats(Stats &stats)
+{
+  stats.add("SOURCE", "Files", files.size());
+  stats.add("SOURCE", "Unreadable files", num_unreadable);
+  stats.add("SOURCE", "Regex literals", literals.size());
+  stats.add("SOURCE", "Skipped patterns", num_skipped);
+}
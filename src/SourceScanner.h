@@ -0,0 +1,100 @@
+/*  SourceScanner.h: Finds regex literals in source files
+
+    Copyright (C) 2016-2018  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SOURCE_SCANNER_H
+#define SOURCE_SCANNER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "Stats.h"
+using namespace std;
+
+// A regex literal found in a source file
+struct RegexLiteral {
+  string regex;			// regex (string literal after decoding escapes)
+  string flags;			// source text of the flags argument (empty if none)
+  unsigned int file;		// index of file in file list
+  unsigned int line;		// line of the string literal (starting at 1)
+};
+
+// Walks a source tree and extracts the string literals passed as the pattern to
+// the Python re functions (re.compile, re.match, and so on), either as the first
+// argument or as the pattern keyword argument, along with the flags argument
+class SourceScanner {
+
+public:
+
+  SourceScanner() { num_skipped = 0; num_unreadable = 0; }
+
+  // scans a file or every Python file in a directory tree (hidden directories and
+  // symbolic links are skipped)
+  void build(string path);
+
+  // returns the scanned files
+  vector <string> &get_files() { return files; }
+
+  // returns the regex literals in file and line order
+  vector <RegexLiteral> &get_literals() { return literals; }
+
+  // add source scanner stats
+  void add_stats(Stats &stats);
+
+private:
+
+  vector <string> files;		// scanned files
+  vector <RegexLiteral> literals;	// regex literals found
+  unsigned int num_skipped;		// patterns that are not plain string literals
+  unsigned int num_unreadable;		// files that could not be read
+
+  // an argument of a call
+  struct CallArg {
+    string keyword;		// keyword (empty for positional arguments)
+    size_t start;		// start of the value
+    size_t end;			// end of the value (trailing space excluded)
+  };
+
+  // scans a directory tree
+  void scan_dir(string path);
+
+  // maps a file into memory and scans it
+  void scan_file(string path);
+
+  // scans Python source text
+  void scan_python(const char *text, size_t size, unsigned int file);
+
+  // reads the arguments of a call starting after its open parenthesis at pos (pos is
+  // not moved), returns false if the closing parenthesis is not found
+  bool read_args(const char *text, size_t size, size_t pos, vector <CallArg> &args);
+
+  // reads a string literal (including its prefix) starting at pos, which is moved
+  // past it, returns false if the value is not known (f-strings, unsupported escapes,
+  // and non-ASCII characters)
+  bool read_string(const char *text, size_t size, size_t &pos, string &value);
+
+  // returns true if a string literal (possibly with a prefix) starts at pos
+  bool is_string_start(const char *text, size_t size, size_t pos);
+
+  // skips spaces, line breaks, and comments starting at pos
+  void skip_space(const char *text, size_t size, size_t &pos);
+};
+
+#endif // SOURCE_SCANNER_H
@@ -19,13 +19,34 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <chrono>
+#include <ctime>
 #include <iostream>
 #include <iomanip>
+#include <sstream>
 #include <string>
 #include <vector>
 #include "Stats.h"
 using namespace std;
 
+// returns the wall clock time in milliseconds
+static double
+get_wall_time()
+{
+  chrono::steady_clock::duration now = chrono::steady_clock::now().time_since_epoch();
+  return chrono::duration <double, milli> (now).count();
+}
+
+// returns the CPU time of the process in milliseconds (this includes the checker's
+// worker threads, timers are only enabled when one regex is run at a time)
+static double
+get_cpu_time()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
 void
 Stats::add(string tag, string name, int value)
 {
@@ -33,6 +54,36 @@ Stats::add(string tag, string name, int value)
   statList.push_back(stat);
 }
 
+void
+Stats::start_timer(const char *name)
+{
+  if (!timers_enabled) return;
+  stop_timer();
+
+  // find the timer of the phase
+  timer_index = 0;
+  while (timer_index < timerList.size() && timerList[timer_index].name != name) timer_index++;
+  if (timer_index == timerList.size()) {
+    Timer timer = { name, 0.0, 0.0 };
+    timerList.push_back(timer);
+  }
+
+  timer_running = true;
+  cpu_start = get_cpu_time();
+  wall_start = get_wall_time();
+}
+
+void
+Stats::stop_timer()
+{
+  if (!timer_running) return;
+  double wall_end = get_wall_time();
+  double cpu_end = get_cpu_time();
+  timerList[timer_index].wall_time += wall_end - wall_start;
+  timerList[timer_index].cpu_time += cpu_end - cpu_start;
+  timer_running = false;
+}
+
 void
 Stats::print()
 {
@@ -51,5 +102,18 @@ Stats::print()
     cout << left << setw(WIDTH) << it->name << "| " << it->value << endl;
     prev_tag = it->tag;
   }
+
+  // print phase timers
+  if (timerList.empty()) return;
+  if (prev_tag != "") {
+    for (int i = 0; i < WIDTH + 8; i++) cout << "-";
+    cout << endl;
+  }
+  vector <Timer>::iterator ti;
+  for (ti = timerList.begin(); ti != timerList.end(); ti++) {
+    stringstream s;
+    s << fixed << setprecision(3) << ti->wall_time << " ms (CPU " << ti->cpu_time << " ms)";
+    cout << left << setw(WIDTH) << ti->name + " time" << "| " << s.str() << endl;
+  }
 }
   
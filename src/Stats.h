@@ -22,6 +22,7 @@
 #ifndef STATS_H
 #define STATS_H
 
+#include <string>
 #include <vector>
 using namespace std;
 
@@ -29,9 +30,32 @@ class Stats
 {
 
 public:
+
+  Stats() { timers_enabled = false; timer_running = false; }
+
+  // time spent in a phase of the engine (in milliseconds)
+  struct Timer {
+    string name;
+    double wall_time;
+    double cpu_time;		// CPU time of the process (all threads)
+  };
+
   // adds a stat to the list of stats
   void add(string tag, string name, int value);
 
+  // turns on the phase timers (the timer functions do nothing otherwise)
+  void enable_timers() { timers_enabled = true; }
+
+  // ends the running phase (if any) and starts timing the named phase, the time of
+  // a phase that is timed more than once is added up
+  void start_timer(const char *name);
+
+  // ends the running phase
+  void stop_timer();
+
+  // get the phase timers (in the order the phases were first timed)
+  vector <Timer> get_timers() { return timerList; }
+
   // print the stats
   void print();
 
@@ -44,6 +68,13 @@ private:
   };
 
   vector <Stat> statList;
+
+  vector <Timer> timerList;
+  bool timers_enabled;		// set if the phases are timed
+  bool timer_running;		// set if a phase is being timed
+  unsigned int timer_index;	// timer of the running phase
+  double wall_start;		// wall clock time when the running phase started
+  double cpu_start;		// process CPU time when the running phase started
 };
 
 #endif // STATS_H
@@ -35,9 +35,10 @@ using namespace std;
 // TEST STRING GENERATION FUNCTIONS
 
 vector <string>
-TestGenerator::gen_test_strings()
+TestGenerator::gen_test_strings(Stats &stats)
 {
   vector <string>::iterator si;
+  stats.start_timer("Generation");
 
   // get initial strings
   get_initial_strings();
@@ -57,17 +58,36 @@ TestGenerator::gen_test_strings()
   // gen evil strings
   gen_evil_strings();
 
+  // characters that can be consumed by some edge (strings with other characters
+  // cannot match the regex)
+  bitset <256> chars;
+  vector <Path>::iterator path_iter;
+  for (path_iter = paths.begin(); path_iter != paths.end(); path_iter++) {
+    path_iter->add_characters(chars);
+  }
+
+  stats.start_timer("Dedup");
+
   // TODO: Create a function that checks for duplicates each time a string is added?
-  // create return set with no duplicates
+  // create return set with no duplicates (a verdict known from any construction is kept)
   vector <string> return_strs;
-  for (si = test_strings.begin(); si != test_strings.end(); si++) {
-    if (!(std::find(return_strs.begin(), return_strs.end(), *si) != return_strs.end())) {
-      return_strs.insert(return_strs.begin(), *si);
+  verdicts.clear();
+  for (unsigned int i = 0; i < test_strings.size(); i++) {
+    MatchVerdict verdict = get_verdict(test_strings[i], valid_strings[i], chars);
+    si = std::find(return_strs.begin(), return_strs.end(), test_strings[i]);
+    if (si == return_strs.end()) {
+      return_strs.insert(return_strs.begin(), test_strings[i]);
+      verdicts.insert(verdicts.begin(), verdict);
+    }
+    else if (verdict != MATCH_UNKNOWN) {
+      verdicts[si - return_strs.begin()] = verdict;
     }
   }
 
   // record number of generated strings for stats
   num_gen_strings = return_strs.size();
+  num_known_accept = std::count(verdicts.begin(), verdicts.end(), MATCH_ACCEPT);
+  num_known_reject = std::count(verdicts.begin(), verdicts.end(), MATCH_REJECT);
 
   return return_strs;
 }
@@ -78,6 +98,7 @@ TestGenerator::get_initial_strings()
   vector <Path>::iterator path_iter;
   for (path_iter = paths.begin(); path_iter != paths.end(); path_iter++) {
     test_strings.push_back(path_iter->get_test_string());
+    valid_strings.push_back(path_iter->is_valid());
   }
 }
 
@@ -90,8 +111,10 @@ TestGenerator::gen_min_iter_strings()
 
   vector <Path>::iterator path_iter;
   for (path_iter = paths.begin(); path_iter != paths.end(); path_iter++) {
-    string min_iter_string = path_iter->gen_min_iter_string();
+    bool valid;
+    string min_iter_string = path_iter->gen_min_iter_string(valid);
     test_strings.push_back(min_iter_string);
+    valid_strings.push_back(valid);
     if (debug_mode)
       cout << min_iter_string << endl;
   }
@@ -102,14 +125,32 @@ TestGenerator::gen_evil_strings()
 {
   vector <Path>::iterator path_iter;
   for (path_iter = paths.begin(); path_iter != paths.end(); path_iter++) {
-    vector <string> evil_strings = path_iter->gen_evil_strings(punct_marks);
-    vector <string>::iterator si;
-    for (si = evil_strings.begin(); si != evil_strings.end(); si++) {
-      test_strings.push_back(*si);
+    vector <bool> valid;
+    vector <string> evil_strings = path_iter->gen_evil_strings(punct_marks, valid);
+    for (unsigned int i = 0; i < evil_strings.size(); i++) {
+      test_strings.push_back(evil_strings[i]);
+      valid_strings.push_back(valid[i]);
     }
   }
 }
 
+MatchVerdict
+TestGenerator::get_verdict(const string &str, bool valid, const bitset <256> &chars)
+{
+  // Ignored elements can change the result, and character sets do not use
+  // the same rules as Python for non-ASCII characters.
+  if (ignored) return MATCH_UNKNOWN;
+  for (unsigned int i = 0; i < str.size(); i++) {
+    if ((unsigned char) str[i] >= 128) return MATCH_UNKNOWN;
+  }
+
+  if (valid) return MATCH_ACCEPT;
+  for (unsigned int i = 0; i < str.size(); i++) {
+    if (!chars[(unsigned char) str[i]]) return MATCH_REJECT;
+  }
+  return MATCH_UNKNOWN;
+}
+
 // STAT FUNCTION
 
 void
@@ -118,4 +159,6 @@ TestGenerator::add_stats(Stats &stats)
   // TODO: Should paths be included here?
   stats.add("PATHS", "Paths", paths.size());
   stats.add("PATHS", "Strings", num_gen_strings);
+  stats.add("PATHS", "Known matches", num_known_accept);
+  stats.add("PATHS", "Known non-matches", num_known_reject);
 }
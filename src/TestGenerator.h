@@ -25,24 +25,32 @@
 #ifndef TEST_GENERATOR_H
 #define TEST_GENERATOR_H
 
+#include <bitset>
 #include <set>
 #include <string>
 #include <vector>
+#include "MatchVerdict.h"
 #include "Path.h"
+#include "Util.h"
 using namespace std;
 
 class TestGenerator {
 
 public:
 
-  TestGenerator(vector <Path> p, set <char> m, bool d) {
+  TestGenerator(vector <Path> p, set <char> m, bool i, bool d) {
     paths = p;
     punct_marks = m;
+    ignored = i;
     debug_mode = d;
   }
 
-  // generate test strings
-  vector <string> gen_test_strings();
+  // generate test strings (generation and duplicate removal are timed in stats)
+  vector <string> gen_test_strings(Stats &stats);
+
+  // returns the verdict of each test string known from its construction
+  // (MATCH_UNKNOWN if the string must be matched)
+  vector <MatchVerdict> get_verdicts() { return verdicts; }
 
   // add test generation stats
   void add_stats(Stats &stats);
@@ -51,11 +59,16 @@ private:
 
   vector <Path> paths;		// list of paths
   set <char> punct_marks;	// set of punct marks
+  bool ignored;			// set if regex has ignored elements (no verdicts are known)
   bool debug_mode;		// set if debug mode is on
 
   vector <string> test_strings;     // list of test strings
+  vector <bool> valid_strings;      // set if test string is known to match the regex
+  vector <MatchVerdict> verdicts;   // verdicts for returned test strings
 
   int num_gen_strings;          // number of generated strings (for stats)
+  int num_known_accept;         // number of strings known to match (for stats)
+  int num_known_reject;         // number of strings known not to match (for stats)
 
   // TEST STRING GENERATION FUNCTIONS
 
@@ -67,5 +80,8 @@ private:
 
   // generates evil strings
   void gen_evil_strings();
+
+  // returns the verdict for a test string
+  MatchVerdict get_verdict(const string &str, bool valid, const bitset <256> &chars);
 };
 #endif // TEST_GENERATOR_H
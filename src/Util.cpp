@@ -24,13 +24,16 @@
 #include "Util.h"
 using namespace std;
 
-// global static pointer for singleton class
-Util* Util::inst = NULL;
+// static pointer for singleton class (one per thread)
+thread_local Util* Util::inst = NULL;
 
 Util *
 Util::get() 
 {
-  if (inst == NULL) inst = new Util;
+  if (inst == NULL) {
+    static thread_local Util thread_inst;
+    inst = &thread_inst;
+  }
   return inst;
 }
 
@@ -42,20 +45,26 @@ Util::init(string r, bool c, bool w, string s)
   web_mode = w;
   base_substring = s;
   alerts.clear();
+  check_warnings.clear();
   prev_alerts.clear();
 }
 
+void
+Util::end_check_mode()
+{
+  // The checker alerts are replaced by the warnings hidden in check mode, which
+  // are the alerts test generation would find
+  check_mode = false;
+  alerts = check_warnings;
+  check_warnings.clear();
+}
+
 void
 Util::add_alert(Alert alert)
 {
   // Create type, location pair
   pair <string, int> alert_pair = make_pair(alert.type, alert.loc1.first);
 
-  // Line break
-  string lb = web_mode ? "<br>" : "\n";
-  string start = web_mode ? "<mark>" : "\033[33;44;1m";
-  string end = web_mode ? "</mark>" : "\033[0m";
-
   if (prev_alerts.find(alert_pair) == prev_alerts.end()) {
     // New error - add to list of previous alerts
     prev_alerts.insert(alert_pair);
@@ -65,8 +74,33 @@ Util::add_alert(Alert alert)
     return;
   }
 
-  // Ignore warnings in check mode (warnings only relevant in test generation mode)
-  if (alert.warning && check_mode) return;
+  // Hide warnings in check mode (warnings only relevant in test generation mode)
+  if (alert.warning && check_mode) {
+    check_warnings.push_back(alert);
+  }
+  else {
+    alerts.push_back(alert);
+  }
+}
+
+vector <string>
+Util::get_alerts()
+{
+  vector <string> formatted;
+  vector <Alert>::iterator it;
+  for (it = alerts.begin(); it != alerts.end(); it++) {
+    formatted.push_back(format_alert(*it, regex, web_mode));
+  }
+  return formatted;
+}
+
+string
+Util::format_alert(const Alert &alert, const string &regex, bool web_mode)
+{
+  // Line break
+  string lb = web_mode ? "<br>" : "\n";
+  string start = web_mode ? "<mark>" : "\033[33;44;1m";
+  string end = web_mode ? "</mark>" : "\033[0m";
 
   // Produce alert message
   stringstream s;
@@ -98,5 +132,5 @@ Util::add_alert(Alert alert)
   if (alert.has_example) {
     s << "...Example accepted string: " << alert.example << lb;
   }
-  alerts.push_back(s.str());
+  return s.str();
 }
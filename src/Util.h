@@ -72,23 +72,39 @@ struct Alert {
 class Util {
 
 public:
+  // returns the instance of the current thread (each thread processes its own regex)
   static Util* get();
 
+  // makes the current thread use the instance of another thread (for worker threads)
+  static void share(Util *util) { inst = util; }
+
   void init(string r, bool c, bool w, string s);
 
+  // switches from check mode to test generation mode (when both are run on the
+  // same regex), only the alerts relevant to test generation are kept
+  void end_check_mode();
+
   bool is_check_mode() { return check_mode; }
   bool is_web_mode() { return web_mode; }
   string get_base_substring() { return base_substring; }
   string get_regex() { return regex; }
-  vector<string> get_alerts() { return alerts; }
 
   // Alerts 
   void add_alert(Alert alert);
 
+  // returns the alert records (formatted only by get_alerts)
+  vector <Alert> &get_alert_records() { return alerts; }
+
+  // returns the formatted alerts
+  vector <string> get_alerts();
+
+  // formats an alert, highlighting its locations in the regex
+  static string format_alert(const Alert &alert, const string &regex, bool web_mode);
+
 // TODO: Possibly create a new regex class where the "fixing" functions reside?
 private:
   Util() {};            // singleton class, private constructor
-  static Util *inst;
+  static thread_local Util *inst;
 
   // Global options
   bool check_mode;
@@ -98,7 +114,8 @@ private:
   string regex;                                 // original regular expression
 
   // Alerts
-  vector <string> alerts;                       // vector of alert strings
+  vector <Alert> alerts;                        // vector of alerts
+  vector <Alert> check_warnings;                // warnings hidden in check mode
   set <pair <string, int>> prev_alerts;         // all previous alerts
 
 };
@@ -0,0 +1,277 @@
+/*  acre_scan.cpp: runs the checker on the regex literals in a source tree
+
+    Copyright (C) 2016-2018  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Each regex literal is printed as a JSON object on its own line (file, line,
+// regex, and either the checker alerts or an error).  Identical regexes are only
+// checked once and the unique regexes are checked on a pool of threads.  Regexes
+// compiled with flags are not checked since the flags (re.X in particular) change
+// their meaning, and regexes longer than the length budget are not checked since
+// building their NFA can take seconds: these are printed with the reason they
+// were skipped (and the flags) instead.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "SourceScanner.h"
+#include "Stats.h"
+#include "egret.h"
+using namespace std;
+
+// default length budget (longer regexes are not checked)
+#define MAX_LENGTH 1000
+
+static char *get_arg(int &idx, int argc, char **argv);
+static const char *skip_reason(const RegexLiteral &literal, unsigned int max_length);
+static string json_string(const string &str);
+static string json_location(const Location &loc);
+
+int
+main(int argc, char *argv[])
+{
+  int idx = 1;
+  unsigned int num_threads = thread::hardware_concurrency();
+  unsigned int rules = CHECK_ALL;
+  unsigned int max_length = MAX_LENGTH;
+  bool stat_mode = false;
+  vector <string> paths;
+
+  // Process arguments
+  while (idx < argc) {
+
+    char *arg = get_arg(idx, argc, argv);
+
+    // -j: number of threads
+    if (strcmp(arg, "-j") == 0) {
+      num_threads = atoi(get_arg(idx, argc, argv));
+    }
+
+    // -k: comma separated list of checker rules to run
+    else if (strcmp(arg, "-k") == 0) {
+      char *names = get_arg(idx, argc, argv);
+      if (!get_rule_mask(names, rules)) {
+        cerr << "USAGE: Invalid checker rule list: " << names << endl;
+        return -1;
+      }
+    }
+
+    // -l: length budget (0 checks every regex)
+    else if (strcmp(arg, "-l") == 0) {
+      max_length = atoi(get_arg(idx, argc, argv));
+    }
+
+    // -s: print stats
+    else if (strcmp(arg, "-s") == 0) {
+      stat_mode = true;
+    }
+
+    // everything else is a file or directory to scan
+    else if (arg[0] != '-') {
+      paths.push_back(arg);
+    }
+
+    else {
+      cerr << "USAGE: Invalid command line option: " << arg << endl;
+      return -1;
+    }
+  }
+
+  if (paths.empty()) {
+    cerr << "USAGE: acre_scan [-j threads] [-k rules] [-l length] [-s] path ..." << endl;
+    return -1;
+  }
+  if (num_threads == 0) num_threads = 1;
+
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+  // Find the regex literals
+  vector <SourceScanner> scanners(paths.size());
+  for (unsigned int i = 0; i < paths.size(); i++) {
+    try {
+      scanners[i].build(paths[i]);
+    }
+    catch (EgretException const &e) {
+      cerr << e.get_error() << endl;
+      return -1;
+    }
+  }
+
+  // Collect the unique regexes
+  map <string, unsigned int> regex_ids;
+  vector <string> regexes;
+  for (unsigned int i = 0; i < scanners.size(); i++) {
+    vector <RegexLiteral> &literals = scanners[i].get_literals();
+    vector <RegexLiteral>::iterator it;
+    for (it = literals.begin(); it != literals.end(); it++) {
+      if (skip_reason(*it, max_length) != NULL) continue;
+      if (regex_ids.find(it->regex) == regex_ids.end()) {
+        regex_ids[it->regex] = regexes.size();
+        regexes.push_back(it->regex);
+      }
+    }
+  }
+
+  // Check the unique regexes (each thread takes the next unchecked regex)
+  vector <CheckResult> results(regexes.size());
+  atomic <unsigned int> next(0);
+  if (num_threads > regexes.size()) num_threads = regexes.size();
+  vector <thread> workers;
+  for (unsigned int t = 0; t < num_threads; t++) {
+    workers.push_back(thread([&]() {
+      unsigned int i;
+      while ((i = next++) < regexes.size()) {
+        results[i] = run_check_engine(regexes[i], "evil", rules);
+      }
+    }));
+  }
+  for (unsigned int t = 0; t < workers.size(); t++) {
+    workers[t].join();
+  }
+
+  // Print the results for each literal
+  unsigned int num_literals = 0;
+  unsigned int num_alerts = 0;
+  unsigned int num_errors = 0;
+  unsigned int num_skipped = 0;
+  for (unsigned int i = 0; i < scanners.size(); i++) {
+    vector <string> &files = scanners[i].get_files();
+    vector <RegexLiteral> &literals = scanners[i].get_literals();
+    vector <RegexLiteral>::iterator it;
+    for (it = literals.begin(); it != literals.end(); it++) {
+      stringstream s;
+      s << "{\"file\": " << json_string(files[it->file])
+        << ", \"line\": " << it->line
+        << ", \"regex\": " << json_string(it->regex);
+      const char *reason = skip_reason(*it, max_length);
+      if (reason != NULL) {
+        if (it->flags != "") s << ", \"flags\": " << json_string(it->flags);
+        s << ", \"skipped\": " << json_string(reason) << "}";
+        cout << s.str() << endl;
+        num_literals++;
+        num_skipped++;
+        continue;
+      }
+      CheckResult &result = results[regex_ids[it->regex]];
+      if (result.error != "") {
+        s << ", \"error\": " << json_string(result.error);
+        num_errors++;
+      }
+      else {
+        s << ", \"alerts\": [";
+        vector <Alert>::iterator alert_it;
+        for (alert_it = result.alerts.begin(); alert_it != result.alerts.end(); alert_it++) {
+          if (alert_it != result.alerts.begin()) s << ", ";
+          s << "{\"warning\": " << (alert_it->warning ? "true" : "false")
+            << ", \"type\": " << json_string(alert_it->type)
+            << ", \"message\": " << json_string(alert_it->message)
+            << ", \"suggest\": " << (alert_it->has_suggest ? json_string(alert_it->suggest) : "null")
+            << ", \"example\": " << (alert_it->has_example ? json_string(alert_it->example) : "null")
+            << ", \"loc1\": " << json_location(alert_it->loc1)
+            << ", \"loc2\": " << json_location(alert_it->loc2) << "}";
+        }
+        s << "]";
+        num_alerts += result.alerts.size();
+      }
+      s << "}";
+      cout << s.str() << endl;
+      num_literals++;
+    }
+  }
+
+  chrono::duration <double> elapsed = chrono::steady_clock::now() - start;
+  cerr << "Literals: " << num_literals << " (unique " << regexes.size() << ")"
+       << ", skipped: " << num_skipped
+       << ", alerts: " << num_alerts << ", errors: " << num_errors
+       << ", time: " << elapsed.count() << " seconds" << endl;
+
+  if (stat_mode) {
+    Stats stats;
+    for (unsigned int i = 0; i < scanners.size(); i++) {
+      scanners[i].add_stats(stats);
+    }
+    stats.print();
+  }
+
+  return 0;
+}
+
+static char *
+get_arg(int &idx, int argc, char **argv)
+{
+  char *arg;
+
+  if (idx >= argc) {
+    cerr << "USAGE: Invalid command line" << endl << endl;
+    exit(-1);
+  }
+
+  arg = argv[idx];
+  idx++;
+
+  return arg;
+}
+
+// returns why the literal is not checked or NULL if it is checked
+static const char *
+skip_reason(const RegexLiteral &literal, unsigned int max_length)
+{
+  if (literal.flags != "") return "flags";
+  if (max_length != 0 && literal.regex.size() > max_length) return "length";
+  return NULL;
+}
+
+static string
+json_string(const string &str)
+{
+  string value = "\"";
+  for (unsigned int i = 0; i < str.size(); i++) {
+    unsigned char c = str[i];
+    if (c == '"' || c == '\\') {
+      value += '\\';
+      value += c;
+    }
+    else if (c < 32 || c == 127) {
+      char code[8];
+      snprintf(code, sizeof(code), "\\u%04x", c);
+      value += code;
+    }
+    else {
+      value += c;
+    }
+  }
+  return value + "\"";
+}
+
+static string
+json_location(const Location &loc)
+{
+  if (loc.first == -1) return "null";
+  stringstream s;
+  s << "[" << loc.first << ", " << loc.second << "]";
+  return s.str();
+}
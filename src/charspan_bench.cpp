@@ -0,0 +1,127 @@
+/*  charspan_bench.cpp: measures the character span kernels
+
+    Copyright (C) 2016-2018  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// For each character set and string length, a string of characters from the
+// set (ending with a character outside of it) is scanned repeatedly with each
+// supported kernel.  The throughput is reported in bytes per cycle, where the
+// cycles are time stamp counter ticks (or nanoseconds on other processors).
+
+#include <bitset>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "CharSpan.h"
+using namespace std;
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+static unsigned long long get_ticks() { return __rdtsc(); }
+static const char *TICK_NAME = "cycle";
+#else
+static unsigned long long get_ticks()
+{
+  return chrono::duration_cast <chrono::nanoseconds>(
+      chrono::steady_clock::now().time_since_epoch()).count();
+}
+static const char *TICK_NAME = "ns";
+#endif
+
+// Number of bytes scanned for each measurement.
+static const size_t BYTES_PER_RUN = 64 * 1024 * 1024;
+
+struct BenchSet {
+  const char *name;		// character set in regex syntax
+  bitset <256> chars;		// characters in the set
+};
+
+static bitset <256>
+make_set(const char *ranges)
+{
+  bitset <256> chars;
+  for (unsigned int i = 0; ranges[i] != '\0'; i += 2) {
+    for (int c = (unsigned char) ranges[i]; c <= (unsigned char) ranges[i + 1]; c++) chars.set(c);
+  }
+  return chars;
+}
+
+int
+main()
+{
+  vector <BenchSet> sets;
+  BenchSet alnum = { "[A-Za-z0-9]", make_set("AZaz09") };
+  BenchSet word = { "\\w", make_set("AZaz09__") };
+  BenchSet quoted = { "[^\"]", ~make_set("\"\"") };
+  sets.push_back(alnum);
+  sets.push_back(word);
+  sets.push_back(quoted);
+
+  const SpanKernel kernels[3] = { SPAN_SCALAR, SPAN_SSE42, SPAN_AVX2 };
+  const char *kernel_names[3] = { "scalar", "sse4.2", "avx2" };
+  const size_t lengths[4] = { 16, 64, 1024, 65536 };
+
+  printf("%-12s %8s", "set", "length");
+  for (unsigned int k = 0; k < 3; k++) printf(" %10s", kernel_names[k]);
+  printf("   (bytes per %s)\n", TICK_NAME);
+
+  srand(1);
+  for (unsigned int s = 0; s < sets.size(); s++) {
+    vector <char> members;
+    for (unsigned int c = 1; c < 256; c++) {
+      if (sets[s].chars[c]) members.push_back(c);
+    }
+    char stop = 0;
+    while (sets[s].chars[(unsigned char) stop]) stop++;
+
+    CharSpan span;
+    span.build(sets[s].chars);
+
+    for (unsigned int l = 0; l < 4; l++) {
+      string str;
+      for (size_t i = 0; i < lengths[l]; i++) str += members[rand() % members.size()];
+      str += stop;
+
+      printf("%-12s %8zu", sets[s].name, lengths[l]);
+      for (unsigned int k = 0; k < 3; k++) {
+        if (!CharSpan::is_supported(kernels[k])) {
+          printf(" %10s", "-");
+          continue;
+        }
+        size_t runs = BYTES_PER_RUN / lengths[l];
+        size_t total = 0;
+        unsigned long long start = get_ticks();
+        for (size_t r = 0; r < runs; r++) {
+          total += span.find_end(str.data(), 0, str.size(), kernels[k]);
+        }
+        unsigned long long ticks = get_ticks() - start;
+        if (total != runs * lengths[l]) {
+          fprintf(stderr, "ERROR: %s kernel found the wrong end\n", kernel_names[k]);
+          return 1;
+        }
+        printf(" %10.2f", (double) total / ticks);
+      }
+      printf("\n");
+    }
+  }
+
+  return 0;
+}
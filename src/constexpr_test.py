@@ -0,0 +1,76 @@
+# constexpr_test.py: Creates a C++20 test of egret_constexpr.h from degret
+#
+# Copyright (C) 2016-2018  Eric Larson and Anna Kirk
+# elarson@seattleu.edu
+#
+# This file is part of EGRET.
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+# For each regex, the initial and minimum iteration strings printed by degret
+# (in debug mode) become static_asserts on egret::tests, so the constexpr
+# front end fails to compile when it no longer generates the engine's strings.
+# The source file is written to the standard output.
+
+import subprocess
+import sys
+
+# the first regex is the example in egret_constexpr.h
+REGEXES = [
+    r"^[a-z]*\d{2}$",
+    r"abc",
+    r"a|bc|",
+    r"(ab)+c?",
+    r"[^0-9]{2,4}x*",
+    r"\w+@\w+\.com",
+    r"(a|b(c|d)*)?e",
+    r"x{3}y{1,}z{0,2}",
+    r"^(\d+\.)*\d+$",
+]
+
+# returns the strings degret generates before the evil strings (first occurrences only)
+def degret_strings(degret, regex):
+    output = subprocess.run([degret, "-d", "-r", regex], check = True,
+        stdout = subprocess.PIPE, universal_newlines = True).stdout
+    lines = output.split("\n")
+    start = lines.index("Initial Test Strings: ") + 1
+    end = lines.index("BEGIN", start)
+    strings = []
+    for line in lines[start:end]:
+        if line != "Minimum Iteration Test Strings: " and line not in strings:
+            strings.append(line)
+    return strings
+
+def cpp_string(s):
+    return '"' + s.replace("\\", "\\\\").replace('"', '\\"') + '"'
+
+degret = sys.argv[1] if len(sys.argv) > 1 else "./degret"
+
+print("// Generated by constexpr_test.py: checks egret_constexpr.h against degret")
+print()
+print('#include "egret_constexpr.h"')
+print()
+for (i, regex) in enumerate(REGEXES):
+    strings = degret_strings(degret, regex)
+    print("// %s" % cpp_string(regex))
+    print("constexpr auto tests%d = egret::tests<%s>();" % (i, cpp_string(regex)))
+    print("static_assert(tests%d.size() == %d);" % (i, len(strings)))
+    for (j, s) in enumerate(strings):
+        print("static_assert(tests%d[%d] == %s);" % (i, j, cpp_string(s)))
+    print()
+print("int")
+print("main()")
+print("{")
+print("  return 0;")
+print("}")
@@ -21,9 +21,15 @@
 
 #include <algorithm>
 #include <iostream>
+#include <set>
+#include <sstream>
 #include <string>
 #include <vector>
 #include "Checker.h"
+#include "CodeGenerator.h"
+#include "egret.h"
+#include "Matcher.h"
+#include "MultiMatcher.h"
 #include "NFA.h"
 #include "ParseTree.h"
 #include "Path.h"
@@ -34,68 +40,125 @@
 
 using namespace std;
 
-vector <string>
-run_engine(string regex, string base_substring, bool check_mode = false, bool web_mode = false,
-    bool debug_mode = false, bool stat_mode = false)
+// run_pipeline: runs the engine on the regex and returns the test strings (if not
+// in check mode, which only checks the rules in the rule mask), also returns the
+// verdicts known from generating the strings and builds the matcher from the NFA
+// if they are provided.  If check alerts are provided (not in check mode), the
+// checker is run with every rule before generating the test strings.  The phases
+// are timed in stats if its timers are enabled (they are in stat mode).
+static vector <string>
+run_pipeline(string regex, string base_substring, bool check_mode, unsigned int rules,
+    bool web_mode, bool debug_mode, bool stat_mode, Stats &stats, vector <MatchVerdict> *verdicts,
+    Matcher *matcher, vector <string> *check_alerts = NULL)
 {
-  Stats stats;
   vector <string> test_strings;
 
-  try {
-
-    // check and convert base substring
-    if (base_substring.length() < 2) {
-      throw EgretException("ERROR (bad arguments): Base substring must have at least two letters");
-    }
-    for (unsigned int i = 0; i < base_substring.length(); i++) {
-      if (!isalpha(base_substring[i])) {
-        throw EgretException("ERROR (bad arguments): Base substring can only contain letters");
-      }
+  // check and convert base substring
+  if (base_substring.length() < 2) {
+    throw EgretException("ERROR (bad arguments): Base substring must have at least two letters");
+  }
+  for (unsigned int i = 0; i < base_substring.length(); i++) {
+    if (!isalpha(base_substring[i])) {
+      throw EgretException("ERROR (bad arguments): Base substring can only contain letters");
     }
+  }
+
+  // set global options (test generation follows the checker when checking first)
+  bool check_first = !check_mode && check_alerts != NULL;
+  if (check_first) rules = CHECK_ALL;
+  Util::get()->init(regex, check_mode || check_first, web_mode, base_substring);
+  if (stat_mode) stats.enable_timers();
 
-    // set global options
-    Util::get()->init(regex, check_mode, web_mode, base_substring);
-
-    // start debug mode
-    if (debug_mode) cout << "RegEx: " << regex << endl;
-     
-    // initialize scanner with regex
-    Scanner scanner;
-    scanner.init(regex);
-    if (debug_mode) scanner.print();
-    if (stat_mode) scanner.add_stats(stats);
-  
-    // build parse tree
-    ParseTree tree;
-    tree.build(scanner);
-    if (debug_mode) tree.print();
-    if (stat_mode) tree.add_stats(stats);
-
-    // build NFA
-    NFA nfa;
-    nfa.build(tree);
-    if (debug_mode) nfa.print();
-    if (stat_mode) nfa.add_stats(stats);
-
-    // traverse NFA basis paths and process them
-    vector <Path> paths = nfa.find_basis_paths();
-    vector <Path>::iterator path_iter;
+  // start debug mode
+  if (debug_mode) cout << "RegEx: " << regex << endl;
+   
+  // initialize scanner with regex
+  stats.start_timer("Scan");
+  Scanner scanner;
+  scanner.init(regex);
+  if (debug_mode) scanner.print();
+  if (stat_mode) scanner.add_stats(stats);
+
+  // build parse tree
+  stats.start_timer("Parse");
+  ParseTree tree;
+  tree.build(scanner);
+  if (debug_mode) tree.print();
+  if (stat_mode) tree.add_stats(stats);
+
+  // build NFA
+  stats.start_timer("NFA build");
+  NFA nfa;
+  nfa.build(tree);
+  if (debug_mode) nfa.print();
+  if (stat_mode) nfa.add_stats(stats);
+
+  // traverse NFA basis paths and process them (the checker does not need the
+  // prefixes used for evil strings or the test strings unless an anchor rule is
+  // selected, and does not need any paths without rules)
+  vector <Path> paths;
+  stats.start_timer("Path search");
+  if (!check_mode || rules != 0) paths = nfa.find_basis_paths();
+  stats.start_timer("Path processing");
+  bool need_test_strings = (rules & (CHECK_ANCHOR_USAGE | CHECK_ANCHOR_MIDDLE)) != 0;
+  vector <Path>::iterator path_iter;
+  for (path_iter = paths.begin(); path_iter != paths.end(); path_iter++) {
+    if (check_mode || check_first) path_iter->process_check_path(need_test_strings);
+    else path_iter->process_path();
+  }
+
+  // run checker
+  if (check_mode || check_first) {
+    stats.start_timer("Check");
+    Checker checker(paths, scanner.get_tokens(), rules);
+    checker.check();
+  }
+
+  // switch to test generation after checking, the edges are processed again since
+  // the substrings depend on the mode
+  if (check_first) {
+    *check_alerts = Util::get()->get_alerts();
+    if (check_alerts->empty()) check_alerts->push_back("No violations detected.");
+    if (scanner.get_check_only_error() != "") {
+      throw EgretException(scanner.get_check_only_error());
+    }
+    Util::get()->end_check_mode();
+    stats.start_timer("Path processing");
+    nfa.clear_processed();
     for (path_iter = paths.begin(); path_iter != paths.end(); path_iter++) {
       path_iter->process_path();
     }
+  }
 
-    // run checker
-    if (check_mode) {
-      Checker checker(paths, scanner.get_tokens());
-      checker.check();
-    }
+  // generate tests
+  if (!check_mode) {
+    TestGenerator gen(paths, tree.get_punct_marks(), nfa.has_ignored_elements(), debug_mode);
+    test_strings = gen.gen_test_strings(stats);
+    if (verdicts != NULL) *verdicts = gen.get_verdicts();
+    if (stat_mode) gen.add_stats(stats);
+  }
 
-    // generate tests
-    if (!check_mode) {
-      TestGenerator gen(paths, tree.get_punct_marks(), debug_mode);
-      test_strings = gen.gen_test_strings();
-      if (stat_mode) gen.add_stats(stats);
-    }
+  // build matcher
+  if (matcher != NULL) {
+    stats.start_timer("Matcher build");
+    matcher->build(nfa);
+    if (debug_mode) matcher->print();
+  }
+
+  stats.stop_timer();
+  return test_strings;
+}
+
+// run_engine_stats: runs the engine as run_engine does with the given stats
+static vector <string>
+run_engine_stats(string regex, string base_substring, bool check_mode, bool web_mode,
+    bool debug_mode, bool stat_mode, unsigned int rules, Stats &stats)
+{
+  vector <string> test_strings;
+
+  try {
+    test_strings = run_pipeline(regex, base_substring, check_mode, rules, web_mode,
+        debug_mode, stat_mode, stats, NULL, NULL);
     
     // print stats
     if (stat_mode) stats.print();
@@ -119,3 +182,275 @@ run_engine(string regex, string base_substring, bool check_mode = false, bool we
 
   return test_strings;
 }
+
+vector <string>
+run_engine(string regex, string base_substring, bool check_mode, bool web_mode,
+    bool debug_mode, bool stat_mode, unsigned int rules)
+{
+  Stats stats;
+  return run_engine_stats(regex, base_substring, check_mode, web_mode, debug_mode, stat_mode,
+      rules, stats);
+}
+
+vector <string>
+run_timed_engine(string regex, string base_substring, bool check_mode, bool web_mode,
+    unsigned int rules, vector <Stats::Timer> &timers)
+{
+  Stats stats;
+  stats.enable_timers();
+  vector <string> result = run_engine_stats(regex, base_substring, check_mode, web_mode, false,
+      false, rules, stats);
+
+  // the running phase is stopped by an error
+  stats.stop_timer();
+  timers = stats.get_timers();
+  return result;
+}
+
+CheckResult
+run_check_engine(string regex, string base_substring, unsigned int rules,
+    bool debug_mode, bool stat_mode)
+{
+  Stats stats;
+  CheckResult result;
+
+  // the empty regex (only matching the empty string) is valid but has nothing to check
+  if (regex == "") return result;
+
+  try {
+    run_pipeline(regex, base_substring, true, rules, false, debug_mode, stat_mode, stats,
+        NULL, NULL);
+
+    // print stats
+    if (stat_mode) stats.print();
+  }
+  catch (EgretException const &e) {
+    result.error = e.get_error();
+    return result;
+  }
+
+  result.alerts = Util::get()->get_alert_records();
+  return result;
+}
+
+bool
+get_rule_mask(string names, unsigned int &rules)
+{
+  const unsigned int NUM_RULES = 8;
+  const string RULE_NAMES[NUM_RULES] = { "anchor-usage", "anchor-middle", "charset",
+    "duplicate-punc", "optional-brace", "wild-punctuation", "repeat-punctuation",
+    "digit-too-optional" };
+  const unsigned int RULE_BITS[NUM_RULES] = { CHECK_ANCHOR_USAGE, CHECK_ANCHOR_MIDDLE,
+    CHECK_CHARSET, CHECK_DUPLICATE_PUNC, CHECK_OPTIONAL_BRACE, CHECK_WILD_PUNCTUATION,
+    CHECK_REPEAT_PUNCTUATION, CHECK_DIGIT_TOO_OPTIONAL };
+
+  rules = 0;
+  stringstream s(names);
+  string name;
+  while (getline(s, name, ',')) {
+    if (name == "") continue;
+    if (name == "all") {
+      rules |= CHECK_ALL;
+      continue;
+    }
+    unsigned int i = 0;
+    while (i < NUM_RULES && RULE_NAMES[i] != name) i++;
+    if (i == NUM_RULES) return false;
+    rules |= RULE_BITS[i];
+  }
+  return true;
+}
+
+// classify_strings: adds the test strings to the result as matches, non-matches, or
+// unknown (along with the extra strings that were not generated) and finds the groups
+static void
+classify_strings(Matcher &matcher, vector <string> &test_strings, vector <MatchVerdict> &verdicts,
+    vector <string> &extra_strings, MatchResult &result)
+{
+  // strings with a known verdict do not need to be matched
+  set <string> match_strings;
+  for (unsigned int i = 0; i < test_strings.size(); i++) {
+    switch (verdicts[i]) {
+      case MATCH_ACCEPT:
+        result.matches.push_back(test_strings[i]);
+        break;
+      case MATCH_REJECT:
+        result.non_matches.push_back(test_strings[i]);
+        break;
+      case MATCH_UNKNOWN:
+        match_strings.insert(test_strings[i]);
+        break;
+    }
+  }
+
+  // add extra strings that were not generated
+  set <string> generated(test_strings.begin(), test_strings.end());
+  vector <string>::iterator it;
+  for (it = extra_strings.begin(); it != extra_strings.end(); it++) {
+    if (generated.find(*it) == generated.end()) match_strings.insert(*it);
+  }
+
+  // classify remaining strings
+  test_strings.assign(match_strings.begin(), match_strings.end());
+  matcher.classify(test_strings, result.matches, result.non_matches, result.unknown);
+  sort(result.matches.begin(), result.matches.end());
+  sort(result.non_matches.begin(), result.non_matches.end());
+
+  // find the groups of each match
+  if (matcher.get_num_groups() > 0) {
+    result.groups.resize(result.matches.size());
+    for (unsigned int i = 0; i < result.matches.size(); i++) {
+      vector <int> spans;
+      if (matcher.match_groups(result.matches[i], spans) == MATCH_ACCEPT) {
+        result.groups[i] = spans;
+      }
+    }
+  }
+}
+
+MatchResult
+run_match_engine(string regex, string base_substring, vector <string> extra_strings,
+    bool web_mode, bool debug_mode, bool stat_mode)
+{
+  Stats stats;
+  Matcher matcher;
+  MatchResult result;
+
+  try {
+    vector <MatchVerdict> verdicts;
+    vector <string> test_strings = run_pipeline(regex, base_substring, false, CHECK_ALL, web_mode,
+        debug_mode, stat_mode, stats, &verdicts, &matcher);
+    classify_strings(matcher, test_strings, verdicts, extra_strings, result);
+    if (stat_mode) matcher.add_stats(stats);
+
+    // print stats
+    if (stat_mode) stats.print();
+  }
+  catch (EgretException const &e) {
+    result.alerts.push_back(e.get_error());
+    return result;
+  }
+
+  result.alerts = Util::get()->get_alerts();
+  return result;
+}
+
+MatchResult
+run_check_match_engine(string regex, string base_substring, vector <string> extra_strings,
+    bool web_mode, bool debug_mode, bool stat_mode)
+{
+  Stats stats;
+  Matcher matcher;
+  MatchResult result;
+
+  try {
+    vector <MatchVerdict> verdicts;
+    vector <string> test_strings = run_pipeline(regex, base_substring, false, CHECK_ALL, web_mode,
+        debug_mode, stat_mode, stats, &verdicts, &matcher, &result.check_alerts);
+    classify_strings(matcher, test_strings, verdicts, extra_strings, result);
+    if (stat_mode) matcher.add_stats(stats);
+
+    // print stats
+    if (stat_mode) stats.print();
+  }
+  catch (EgretException const &e) {
+    // An error before the checker finished may not be the error test generation
+    // finds (the checker supports more characters), so generation is run alone.
+    if (result.check_alerts.empty()) {
+      MatchResult match_result =
+        run_match_engine(regex, base_substring, extra_strings, web_mode, debug_mode, stat_mode);
+      match_result.check_alerts.push_back(e.get_error());
+      return match_result;
+    }
+    result.alerts.push_back(e.get_error());
+    return result;
+  }
+
+  result.alerts = Util::get()->get_alerts();
+  return result;
+}
+
+vector <MatchResult>
+run_multi_match_engine(vector <string> regexes, string base_substring, vector <string> extra_strings,
+    bool web_mode, bool debug_mode, bool stat_mode)
+{
+  Stats stats;
+  vector <MatchResult> results(regexes.size());
+  vector <Matcher> matchers(regexes.size());		// built in place (not copied)
+  vector <Matcher *> built(regexes.size(), (Matcher *) NULL);
+  set <string> all_strings(extra_strings.begin(), extra_strings.end());
+
+  // generate test strings and build the matcher for each regex
+  for (unsigned int i = 0; i < regexes.size(); i++) {
+    try {
+      vector <string> test_strings = run_pipeline(regexes[i], base_substring, false, CHECK_ALL,
+          web_mode, debug_mode, false, stats, NULL, &matchers[i]);
+      all_strings.insert(test_strings.begin(), test_strings.end());
+      results[i].alerts = Util::get()->get_alerts();
+      built[i] = &matchers[i];
+    }
+    catch (EgretException const &e) {
+      results[i].alerts.push_back(e.get_error());
+    }
+  }
+
+  // classify every string against every regex
+  MultiMatcher multi_matcher;
+  multi_matcher.build(built);
+  vector <MatchVerdict> verdicts;
+  set <string>::iterator it;
+  for (it = all_strings.begin(); it != all_strings.end(); it++) {
+    multi_matcher.match(*it, verdicts);
+    for (unsigned int i = 0; i < regexes.size(); i++) {
+      if (built[i] == NULL) continue;
+      switch (verdicts[i]) {
+        case MATCH_ACCEPT:
+          results[i].matches.push_back(*it);
+          break;
+        case MATCH_REJECT:
+          results[i].non_matches.push_back(*it);
+          break;
+        case MATCH_UNKNOWN:
+          results[i].unknown.push_back(*it);
+          break;
+      }
+    }
+  }
+
+  // print stats
+  if (stat_mode) {
+    multi_matcher.add_stats(stats);
+    stats.print();
+  }
+
+  return results;
+}
+
+string
+run_codegen_engine(string regex, string base_substring, string function_name,
+    bool debug_mode, bool stat_mode)
+{
+  Stats stats;
+  Matcher matcher;
+  CodeGenerator generator;
+  string source;
+
+  try {
+    vector <MatchVerdict> verdicts;
+    vector <string> test_strings = run_pipeline(regex, base_substring, false, CHECK_ALL, false,
+        debug_mode, stat_mode, stats, &verdicts, &matcher);
+
+    generator.build(&matcher);
+    source = generator.gen_function(function_name, regex);
+    source += generator.gen_test(function_name, test_strings, verdicts);
+    if (stat_mode) generator.add_stats(stats);
+
+    // print stats
+    if (stat_mode) stats.print();
+  }
+  catch (EgretException const &e) {
+    return e.get_error();
+  }
+
+  return source;
+}
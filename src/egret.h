@@ -24,11 +24,85 @@
 
 #include <string>
 #include <vector>
+#include "Stats.h"
+#include "Util.h"
 using namespace std;
 
-// run_engine: entry point into EGRET engine
+// Checker rules (combined into a rule mask to select the rules run in check mode)
+typedef enum {
+  CHECK_ANCHOR_USAGE = 0x01,		// some but not all strings use an anchor
+  CHECK_ANCHOR_MIDDLE = 0x02,		// anchor in the middle of a string
+  CHECK_CHARSET = 0x04,			// character set separators, ranges, duplicates, braces
+  CHECK_DUPLICATE_PUNC = 0x08,		// duplicate character sets of punctuation
+  CHECK_OPTIONAL_BRACE = 0x10,		// optional brace without its partner
+  CHECK_WILD_PUNCTUATION = 0x20,	// wildcard next to a punctuation mark
+  CHECK_REPEAT_PUNCTUATION = 0x40,	// repeated punctuation mark
+  CHECK_DIGIT_TOO_OPTIONAL = 0x80,	// digits that may be omitted
+  CHECK_ALL = 0xff
+} CheckRule;
+
+// Result of running the engine with native classification of the test strings
+struct MatchResult {
+  vector <string> alerts;	// alerts (or a single error message)
+  vector <string> matches;	// sorted list of strings accepted by the regex
+  vector <string> non_matches;	// sorted list of strings rejected by the regex
+  vector <string> unknown;	// sorted list of strings the native matcher could not classify
+  vector <vector <int> > groups;	// group start and end positions for each match (empty if
+				// the regex has no groups or the groups are not known)
+  vector <string> check_alerts;	// checker alerts (or an error message) if checked
+};
+
+// Result of running the checker with the alerts kept as records (not formatted)
+struct CheckResult {
+  string error;			// error message (blank if none)
+  vector <Alert> alerts;	// alerts found by the checker
+};
+
+// run_engine: entry point into EGRET engine, only the checker rules in the rule
+// mask are run in check mode
 vector <string>
 run_engine(string regex, string base_substring,
-    bool check_mode = false, bool web_mode = false, bool debug_mode = false, bool stat_mode = false);
+    bool check_mode = false, bool web_mode = false, bool debug_mode = false, bool stat_mode = false,
+    unsigned int rules = CHECK_ALL);
+
+// run_timed_engine: same as run_engine (without debug and stat output), also returns
+// the time spent in each phase of the engine
+vector <string>
+run_timed_engine(string regex, string base_substring, bool check_mode, bool web_mode,
+    unsigned int rules, vector <Stats::Timer> &timers);
+
+// run_check_engine: runs the checker with the rules in the rule mask and returns
+// the alerts as records, which can be formatted with Util::format_alert
+CheckResult
+run_check_engine(string regex, string base_substring, unsigned int rules = CHECK_ALL,
+    bool debug_mode = false, bool stat_mode = false);
+
+// get_rule_mask: converts a comma separated list of rule names (such as
+// "anchor-usage,charset") into a rule mask, returns false if a name is unknown
+bool
+get_rule_mask(string names, unsigned int &rules);
+
+// run_match_engine: generates test strings and classifies them (along with the extra strings)
+MatchResult
+run_match_engine(string regex, string base_substring, vector <string> extra_strings,
+    bool web_mode = false, bool debug_mode = false, bool stat_mode = false);
+
+// run_check_match_engine: runs the checker (with every rule) and then generates and
+// classifies the test strings as run_match_engine does, sharing one run of the pipeline
+MatchResult
+run_check_match_engine(string regex, string base_substring, vector <string> extra_strings,
+    bool web_mode = false, bool debug_mode = false, bool stat_mode = false);
+
+// run_multi_match_engine: generates test strings for each regex and classifies all of
+// them (along with the extra strings) against every regex, returns a result per regex
+vector <MatchResult>
+run_multi_match_engine(vector <string> regexes, string base_substring, vector <string> extra_strings,
+    bool web_mode = false, bool debug_mode = false, bool stat_mode = false);
+
+// run_codegen_engine: returns C++ source code for a function that matches the regex
+// followed by a test driver using the test strings (or an error message)
+string
+run_codegen_engine(string regex, string base_substring, string function_name,
+    bool debug_mode = false, bool stat_mode = false);
 
 #endif // EGRET_H
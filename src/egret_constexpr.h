@@ -0,0 +1,1223 @@
+/*  egret_constexpr.h: Compile-time test string generation for literal regexes
+
+    Copyright (C) 2016-2018  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// A constexpr version of the front end of EGRET (scanner, parser, NFA, and
+// basis paths) that produces the test strings of a regex at compile time:
+//
+//   constexpr auto tests = egret::tests<"^[a-z]*\\d{2}$">();
+//   static_assert(tests.size() == 2);
+//   static_assert(tests[0] == "evil00" && tests[1] == "00");
+//
+// The strings are the initial strings of the basis paths followed by the
+// minimum iteration strings, in the order they are first generated.  These
+// are the same strings the engine generates before the evil strings are added.
+//
+// Only a subset of regexes is supported.  Backreferences, elements the engine
+// ignores (word boundaries, lookarounds, flags), and escaped characters given
+// by code (\n, \t, octal, hex) are rejected: egret::tests fails to compile and
+// egret::error returns the reason.
+//
+// This header requires C++20 (class type template parameters and constexpr
+// std::string and std::vector).  The rest of EGRET only requires C++11.
+
+#ifndef EGRET_CONSTEXPR_H
+#define EGRET_CONSTEXPR_H
+
+#if __cplusplus < 202002L
+#error "egret_constexpr.h requires C++20"
+#else
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace egret {
+
+// string literal used as a template argument
+template <std::size_t N>
+struct literal {
+  char value[N];
+
+  constexpr literal(const char (&str)[N])
+  {
+    for (std::size_t i = 0; i < N; i++) value[i] = str[i];
+  }
+
+  constexpr std::string_view view() const { return std::string_view(value, N - 1); }
+};
+
+// test strings stored in a single character array
+template <std::size_t COUNT, std::size_t CHARS>
+struct string_table {
+  char data[CHARS + 1] = {};
+  std::size_t offsets[COUNT + 1] = {};
+
+  constexpr std::size_t size() const { return COUNT; }
+
+  constexpr std::string_view
+  operator[](std::size_t i) const
+  {
+    return std::string_view(data + offsets[i], offsets[i + 1] - offsets[i]);
+  }
+
+  constexpr bool
+  contains(std::string_view str) const
+  {
+    for (std::size_t i = 0; i < COUNT; i++) {
+      if ((*this)[i] == str) return true;
+    }
+    return false;
+  }
+};
+
+namespace detail {
+
+// SCANNER
+
+typedef enum {
+  ALTERNATION,
+  STAR,
+  PLUS,
+  QUESTION,
+  REPEAT,
+  LEFT_PAREN,
+  RIGHT_PAREN,
+  CHARACTER,
+  CHAR_CLASS,
+  LEFT_BRACKET,
+  RIGHT_BRACKET,
+  CARET,
+  DOLLAR,
+  HYPHEN,
+  NO_GROUP_EXT,
+  NAMED_GROUP_EXT,
+  ERR
+} TokenType;
+
+struct Token {
+  TokenType type = ERR;
+  char character = '\0';	// for CHARACTER and CHAR_CLASS
+  int repeat_lower = -1;	// for REPEAT
+  int repeat_upper = -1;	// for REPEAT (-1 for no limit)
+};
+
+constexpr bool
+is_digit(char c)
+{
+  return c >= '0' && c <= '9';
+}
+
+constexpr bool
+is_space(char c)
+{
+  // Python's \s also matches the separators \x1c-\x1f
+  return c == ' ' || (c >= '\t' && c <= '\r') || (c >= '\x1c' && c <= '\x1f');
+}
+
+// advances to the next character, returns false at the end of the regex
+constexpr bool
+next_char(std::string_view in, unsigned int &idx, char &c)
+{
+  idx++;
+  if (idx >= in.size()) return false;
+  c = in[idx];
+  return true;
+}
+
+// processes a possible repeat quantifier, a malformed quantifier is a '{' character
+constexpr const char *
+scan_repeat(std::string_view in, unsigned int &idx, Token &token)
+{
+  unsigned int current_idx = idx;
+  token.type = CHARACTER;
+  token.character = '{';
+
+  // lower bound
+  int count = 0;
+  bool has_count = false;
+  char c = '\0';
+  if (!next_char(in, idx, c)) return "ERROR (parse error): Input string ended prematurely";
+  while (is_digit(c)) {
+    count = count * 10 + (c - '0');
+    has_count = true;
+    if (!next_char(in, idx, c)) return "ERROR (parse error): Input string ended prematurely";
+  }
+
+  if (c == ',') {
+    token.repeat_lower = has_count ? count : -1;
+  }
+  else if (c == '}') {
+    if (!has_count) {
+      idx = current_idx;
+      return nullptr;
+    }
+    token.repeat_lower = count;
+    token.repeat_upper = count;
+    token.type = REPEAT;
+    if (count == 0) return "ERROR (pointless repeat): pointless repeat quantifier {0}";
+    return nullptr;
+  }
+  else {
+    idx = current_idx;
+    return nullptr;
+  }
+
+  // upper bound
+  count = 0;
+  has_count = false;
+  if (!next_char(in, idx, c)) return "ERROR (parse error): Input string ended prematurely";
+  while (is_digit(c)) {
+    count = count * 10 + (c - '0');
+    has_count = true;
+    if (!next_char(in, idx, c)) return "ERROR (parse error): Input string ended prematurely";
+  }
+
+  if (c != '}') {
+    idx = current_idx;
+    return nullptr;
+  }
+  token.repeat_upper = has_count ? count : -1;
+  if (token.repeat_lower == -1 && token.repeat_upper == -1) {
+    idx = current_idx;
+    return nullptr;
+  }
+  if (token.repeat_lower == -1) token.repeat_lower = 0;
+  if (token.repeat_upper != -1) {
+    if (token.repeat_lower > token.repeat_upper) {
+      return "ERROR (parse error): Invalid repeat quantifier: lower bound is greater than upper bound";
+    }
+    if (token.repeat_upper == 0) return "ERROR (pointless repeat): pointless repeat quantifier {0,0}";
+  }
+  token.type = REPEAT;
+  return nullptr;
+}
+
+// processes a group extension (after "(?")
+constexpr const char *
+scan_extension(std::string_view in, unsigned int &idx, Token &token)
+{
+  char c = '\0';
+  if (!next_char(in, idx, c)) return "ERROR (parse error): Input string ended prematurely";
+
+  if (c == ':') {
+    token.type = NO_GROUP_EXT;
+    return nullptr;
+  }
+  if (c != 'P') return "ERROR (unsupported): Regex contains an extension that is ignored by EGRET";
+
+  if (!next_char(in, idx, c)) return "ERROR (parse error): Input string ended prematurely";
+  if (c == '=') return "ERROR (unsupported): Regex contains a backreference";
+  if (c != '<') return "ERROR (parse error): Improperly specified named group - expected < after (?P";
+  while (c != '>') {
+    if (!next_char(in, idx, c)) return "ERROR (parse error): Input string ended prematurely";
+  }
+  token.type = NAMED_GROUP_EXT;
+  return nullptr;
+}
+
+constexpr const char *
+scan(std::string_view in, std::vector <Token> &tokens)
+{
+  unsigned int idx = 0;
+  bool in_set = false;	// set to true when in the middle of set []
+  while (idx < in.size()) {
+
+    Token token;
+    char curr = in[idx];
+    bool next_is_question = idx + 1 < in.size() && in[idx + 1] == '?';
+    bool first_in_set = in_set && !tokens.empty() && tokens.back().type == LEFT_BRACKET;
+
+    switch (curr) {
+
+    case '\\':
+    {
+      char c = '\0';
+      if (!next_char(in, idx, c)) return "ERROR (parse error): Input string ended prematurely";
+      switch (c) {
+        case 'd': case 'D': case 'w': case 'W': case 's': case 'S':
+          token.type = CHAR_CLASS;
+          token.character = c;
+          break;
+        case 'A':
+          token.type = CARET;
+          break;
+        case 'Z':
+          token.type = DOLLAR;
+          break;
+        case 'b':
+          if (!in_set) return "ERROR (unsupported): Regex contains a word boundary";
+          token.type = CHARACTER;
+          token.character = '\b';
+          break;
+        case 'B':
+          return "ERROR (unsupported): Regex contains a word boundary";
+        case 'a': case 'f': case 'n': case 'r': case 't': case 'v': case 'p': case 'N':
+        case 'x': case 'u': case 'U':
+          return "ERROR (unsupported): Regex contains an unsupported escaped character";
+        case '0': case '1': case '2': case '3': case '4':
+        case '5': case '6': case '7': case '8': case '9':
+          return "ERROR (unsupported): Regex contains a backreference or octal value";
+        default:
+          token.type = CHARACTER;
+          token.character = c;
+      }
+      break;
+    }
+
+    case '[':
+      if (in_set) {
+        token.type = CHARACTER;
+        token.character = curr;
+      }
+      else {
+        token.type = LEFT_BRACKET;
+        in_set = true;
+      }
+      break;
+
+    case ']':
+      if (first_in_set || !in_set) {
+        token.type = CHARACTER;
+        token.character = curr;
+      }
+      else {
+        token.type = RIGHT_BRACKET;
+        in_set = false;
+      }
+      break;
+
+    case '-':
+      if (in_set && !first_in_set && !(idx + 1 < in.size() && in[idx + 1] == ']')) {
+        token.type = HYPHEN;
+      }
+      else {
+        token.type = CHARACTER;
+        token.character = curr;
+      }
+      break;
+
+    case '|':
+      if (in_set) {
+        token.type = CHARACTER;
+        token.character = curr;
+      }
+      else {
+        token.type = ALTERNATION;
+      }
+      break;
+
+    case '*':
+    case '+':
+      if (in_set) {
+        token.type = CHARACTER;
+        token.character = curr;
+      }
+      else {
+        if (next_is_question) idx++;	// lazy version
+        token.type = (curr == '*') ? STAR : PLUS;
+      }
+      break;
+
+    case '?':
+      if (!tokens.empty() && tokens.back().type == LEFT_PAREN) {
+        const char *error = scan_extension(in, idx, token);
+        if (error != nullptr) return error;
+      }
+      else if (in_set) {
+        token.type = CHARACTER;
+        token.character = curr;
+      }
+      else {
+        if (next_is_question) idx++;	// lazy version
+        token.type = QUESTION;
+      }
+      break;
+
+    case '(':
+    case ')':
+      if (in_set) {
+        token.type = CHARACTER;
+        token.character = curr;
+      }
+      else {
+        token.type = (curr == '(') ? LEFT_PAREN : RIGHT_PAREN;
+      }
+      break;
+
+    case '.':
+      token.type = in_set ? CHARACTER : CHAR_CLASS;
+      token.character = curr;
+      break;
+
+    case '{':
+      if (in_set) {
+        token.type = CHARACTER;
+        token.character = curr;
+      }
+      else {
+        const char *error = scan_repeat(in, idx, token);
+        if (error != nullptr) return error;
+        if (token.type != CHARACTER && idx + 1 < in.size() && in[idx + 1] == '?') idx++;
+      }
+      break;
+
+    case '^':
+      token.type = CARET;
+      break;
+
+    case '$':
+      token.type = DOLLAR;
+      break;
+
+    default:
+      token.type = CHARACTER;
+      token.character = curr;
+    }
+
+    tokens.push_back(token);
+    idx++;
+  }
+
+  return nullptr;
+}
+
+// CHARACTER SETS
+
+typedef enum {
+  CHARACTER_ITEM,
+  CHAR_CLASS_ITEM,
+  CHAR_RANGE_ITEM
+} CharSetItemType;
+
+struct CharSetItem {
+  CharSetItemType type = CHARACTER_ITEM;
+  char character = '\0';	// for CHARACTER_ITEM and CHAR_CLASS_ITEM
+  char range_start = '\0';	// for CHAR_RANGE_ITEM
+  char range_end = '\0';	// for CHAR_RANGE_ITEM
+};
+
+struct CharSet {
+  std::vector <CharSetItem> items;
+  bool complement = false;
+
+  constexpr bool
+  is_single_char() const
+  {
+    return items.size() == 1 && items[0].type == CHARACTER_ITEM;
+  }
+
+  constexpr bool
+  is_string_candidate() const
+  {
+    if (complement) return true;
+
+    bool candidate = false;
+    for (const CharSetItem &item : items) {
+      if (item.type == CHAR_CLASS_ITEM) {
+        if (item.character == 'w' || item.character == 'D' || item.character == 'S' ||
+            item.character == '.') {
+          candidate = true;
+        }
+      }
+      else if (item.type == CHAR_RANGE_ITEM) {
+        if ((item.range_start == 'a' && item.range_end == 'z') ||
+            (item.range_start == 'A' && item.range_end == 'Z')) {
+          candidate = true;
+        }
+        else if (!(item.range_start == '0' && item.range_end == '9')) {
+          return false;
+        }
+      }
+    }
+    return candidate;
+  }
+
+  constexpr bool
+  is_valid_character(char c) const
+  {
+    bool word = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || is_digit(c) || c == '_';
+    for (const CharSetItem &item : items) {
+      switch (item.type) {
+        case CHARACTER_ITEM:
+          if (c == item.character) return !complement;
+          break;
+        case CHAR_CLASS_ITEM:
+          switch (item.character) {
+            case 'w': if (word) return !complement; break;
+            case 'd': if (is_digit(c)) return !complement; break;
+            case 's': if (is_space(c)) return !complement; break;
+            case 'W': if (!word) return !complement; break;
+            case 'D': if (!is_digit(c)) return !complement; break;
+            case 'S': if (!is_space(c)) return !complement; break;
+            case '.': if (c != '\n') return !complement; break;
+          }
+          break;
+        case CHAR_RANGE_ITEM:
+          if (c >= item.range_start && c <= item.range_end) return !complement;
+          break;
+      }
+    }
+    return complement;
+  }
+
+  // returns a valid character (same choice as the engine), '\0' if there is none
+  constexpr char
+  get_valid_character() const
+  {
+    if (!complement) {
+      // first explicit character
+      for (const CharSetItem &item : items) {
+        if (item.type == CHARACTER_ITEM && item.character != '\0') return item.character;
+      }
+      // first character that meets the criteria
+      for (const CharSetItem &item : items) {
+        if (item.type == CHAR_CLASS_ITEM) {
+          switch (item.character) {
+            case 'w': return 'a';
+            case 'd': return '0';
+            case 's': return ' ';
+            case 'W': return ';';
+            case 'D': return 'a';
+            case 'S': return 'a';
+            case '.': return 'a';
+          }
+        }
+        if (item.type == CHAR_RANGE_ITEM) {
+          return (item.range_start != '\0') ? item.range_start : item.range_start + 1;
+        }
+      }
+      return '\0';
+    }
+
+    // complemented set - first valid character
+    for (char c = 'a'; c <= 'z'; c++) if (is_valid_character(c)) return c;
+    for (char c = 'A'; c <= 'Z'; c++) if (is_valid_character(c)) return c;
+    for (char c = '0'; c <= '9'; c++) if (is_valid_character(c)) return c;
+    if (is_valid_character(' ')) return ' ';
+    for (char c = 33; c <= 47; c++) if (is_valid_character(c)) return c;
+    for (char c = 58; c <= 64; c++) if (is_valid_character(c)) return c;
+    for (char c = 91; c <= 96; c++) if (is_valid_character(c)) return c;
+    for (char c = 123; c <= 126; c++) if (is_valid_character(c)) return c;
+    return '\0';
+  }
+};
+
+// PARSE TREE
+
+typedef enum {
+  ALTERNATION_NODE,
+  CONCAT_NODE,
+  REPEAT_NODE,
+  GROUP_NODE,
+  CHARACTER_NODE,
+  CARET_NODE,
+  DOLLAR_NODE,
+  CHAR_SET_NODE
+} NodeType;
+
+struct ParseNode {
+  NodeType type = CHARACTER_NODE;
+  int left = -1;		// child nodes (index into nodes)
+  int right = -1;
+  char character = '\0';	// for CHARACTER_NODE
+  int char_set = -1;		// for CHAR_SET_NODE (index into char sets)
+  int repeat_lower = 0;		// for REPEAT_NODE
+  int repeat_upper = 0;		// for REPEAT_NODE (-1 for no limit)
+};
+
+// recursive descent parser, same grammar as ParseTree
+struct Parser {
+  std::vector <Token> tokens;
+  unsigned int index = 0;
+  std::vector <ParseNode> nodes;
+  std::vector <CharSet> char_sets;
+  const char *error = nullptr;
+
+  constexpr TokenType
+  get_type() const
+  {
+    return index < tokens.size() ? tokens[index].type : ERR;
+  }
+
+  constexpr int
+  add_node(ParseNode node)
+  {
+    nodes.push_back(node);
+    return nodes.size() - 1;
+  }
+
+  constexpr int
+  fail(const char *msg)
+  {
+    if (error == nullptr) error = msg;
+    return -1;
+  }
+
+  constexpr bool
+  is_concat() const
+  {
+    if (index >= tokens.size()) return false;
+    TokenType prev_type = tokens[index - 1].type;
+    TokenType next_type = get_type();
+    bool valid_prev_type = prev_type == STAR || prev_type == PLUS || prev_type == QUESTION ||
+      prev_type == REPEAT || prev_type == RIGHT_PAREN || prev_type == CHARACTER ||
+      prev_type == CARET || prev_type == DOLLAR || prev_type == CHAR_CLASS ||
+      prev_type == RIGHT_BRACKET;
+    bool invalid_next_type = next_type == ALTERNATION || next_type == STAR ||
+      next_type == PLUS || next_type == QUESTION || next_type == REPEAT ||
+      next_type == RIGHT_PAREN || next_type == RIGHT_BRACKET;
+    return valid_prev_type && !invalid_next_type;
+  }
+
+  constexpr bool
+  is_char_range() const
+  {
+    if (index + 3 > tokens.size()) return false;
+    return tokens[index].type == CHARACTER && tokens[index + 1].type == HYPHEN &&
+      tokens[index + 2].type == CHARACTER;
+  }
+
+  // expr ::= concat '|' expr | concat '|' | '|' expr | '|' | concat
+  constexpr int
+  expr()
+  {
+    int left = -1;
+    if (get_type() != ALTERNATION) {
+      left = concat();
+      if (error != nullptr) return -1;
+    }
+    if (get_type() != ALTERNATION) return left;
+    index++;
+
+    int right = -1;
+    if (get_type() != RIGHT_PAREN && get_type() != ERR) {
+      right = expr();
+      if (error != nullptr) return -1;
+    }
+
+    ParseNode node;
+    if (left == -1 && right == -1) {
+      return fail("ERROR (pointless alternation): both clauses are empty");
+    }
+    else if (left == -1 || right == -1) {
+      node.type = REPEAT_NODE;
+      node.left = (left == -1) ? right : left;
+      node.repeat_lower = 0;
+      node.repeat_upper = 1;
+    }
+    else {
+      node.type = ALTERNATION_NODE;
+      node.left = left;
+      node.right = right;
+    }
+    return add_node(node);
+  }
+
+  // concat ::= rep concat | rep
+  constexpr int
+  concat()
+  {
+    int left = rep();
+    if (error != nullptr) return -1;
+    if (!is_concat()) return left;
+
+    int right = concat();
+    if (error != nullptr) return -1;
+    ParseNode node;
+    node.type = CONCAT_NODE;
+    node.left = left;
+    node.right = right;
+    return add_node(node);
+  }
+
+  // rep ::= atom '*' | atom '?' | atom '+' | atom '{n,m}' | atom '{n,}' | atom
+  constexpr int
+  rep()
+  {
+    int atom_node = atom();
+    if (error != nullptr) return -1;
+
+    ParseNode node;
+    node.type = REPEAT_NODE;
+    node.left = atom_node;
+    switch (get_type()) {
+      case STAR:
+        node.repeat_lower = 0;
+        node.repeat_upper = -1;
+        break;
+      case PLUS:
+        node.repeat_lower = 1;
+        node.repeat_upper = -1;
+        break;
+      case QUESTION:
+        node.repeat_lower = 0;
+        node.repeat_upper = 1;
+        break;
+      case REPEAT:
+        node.repeat_lower = tokens[index].repeat_lower;
+        node.repeat_upper = tokens[index].repeat_upper;
+        break;
+      default:
+        return atom_node;
+    }
+    index++;
+    return add_node(node);
+  }
+
+  // atom ::= group | character | char_class | char_set
+  constexpr int
+  atom()
+  {
+    switch (get_type()) {
+      case LEFT_PAREN:
+        return group();
+      case LEFT_BRACKET:
+        return char_set();
+      case CHAR_CLASS:
+      {
+        CharSetItem item;
+        item.type = CHAR_CLASS_ITEM;
+        item.character = tokens[index].character;
+        index++;
+        CharSet set;
+        set.items.push_back(item);
+        char_sets.push_back(set);
+        ParseNode node;
+        node.type = CHAR_SET_NODE;
+        node.char_set = char_sets.size() - 1;
+        return add_node(node);
+      }
+      default:
+        return character();
+    }
+  }
+
+  // group ::= '(' expr ')' | '(' NO_GROUP_EXT expr ')' | '(' NAMED_GROUP_EXT expr ')'
+  constexpr int
+  group()
+  {
+    index++;
+    if (get_type() == NO_GROUP_EXT) index++;
+    if (get_type() == NAMED_GROUP_EXT) index++;
+
+    int left = expr();
+    if (error != nullptr) return -1;
+    if (get_type() != RIGHT_PAREN) return fail("ERROR (parse error): expected ')'");
+    index++;
+
+    ParseNode node;
+    node.type = GROUP_NODE;
+    node.left = left;
+    return add_node(node);
+  }
+
+  // character ::= CHARACTER | '^' | '$' | '-'
+  constexpr int
+  character()
+  {
+    ParseNode node;
+    switch (get_type()) {
+      case CHARACTER:
+        node.type = CHARACTER_NODE;
+        node.character = tokens[index].character;
+        break;
+      case CARET:
+        node.type = CARET_NODE;
+        break;
+      case DOLLAR:
+        node.type = DOLLAR_NODE;
+        break;
+      case HYPHEN:
+        node.type = CHARACTER_NODE;
+        node.character = '-';
+        break;
+      default:
+        return fail("ERROR (parse error): expected character type");
+    }
+    index++;
+    return add_node(node);
+  }
+
+  // char_set ::= '[' char_list ']' | '[' '^' char_list ']'
+  constexpr int
+  char_set()
+  {
+    index++;
+    CharSet set;
+    if (get_type() == CARET) {
+      set.complement = true;
+      index++;
+    }
+
+    // items are added in reverse order (as the engine does)
+    std::vector <CharSetItem> items;
+    do {
+      CharSetItem item;
+      if (is_char_range()) {
+        item.type = CHAR_RANGE_ITEM;
+        item.range_start = tokens[index].character;
+        item.range_end = tokens[index + 2].character;
+        index += 3;
+      }
+      else if (get_type() == CHAR_CLASS) {
+        item.type = CHAR_CLASS_ITEM;
+        item.character = tokens[index].character;
+        index++;
+      }
+      else {
+        item.type = CHARACTER_ITEM;
+        switch (get_type()) {
+          case CHARACTER: item.character = tokens[index].character; break;
+          case CARET: item.character = '^'; break;
+          case DOLLAR: item.character = '$'; break;
+          case HYPHEN: item.character = '-'; break;
+          default: return fail("ERROR (parse error): expected character type");
+        }
+        index++;
+      }
+      items.push_back(item);
+    } while (get_type() != RIGHT_BRACKET);
+    for (unsigned int i = items.size(); i > 0; i--) set.items.push_back(items[i - 1]);
+    index++;
+
+    ParseNode node;
+    if (set.is_single_char() && !set.complement) {
+      node.type = CHARACTER_NODE;
+      node.character = set.items[0].character;
+    }
+    else {
+      char_sets.push_back(set);
+      node.type = CHAR_SET_NODE;
+      node.char_set = char_sets.size() - 1;
+    }
+    return add_node(node);
+  }
+};
+
+// NFA
+
+typedef enum {
+  CHARACTER_EDGE,
+  CHAR_SET_EDGE,
+  STRING_EDGE,
+  BEGIN_LOOP_EDGE,
+  END_LOOP_EDGE,
+  CARET_EDGE,
+  DOLLAR_EDGE,
+  EPSILON_EDGE
+} EdgeType;
+
+struct Edge {
+  EdgeType type = EPSILON_EDGE;
+  char character = '\0';	// for CHARACTER_EDGE
+  int index = -1;		// char set (CHAR_SET_EDGE, STRING_EDGE) or loop (LOOP edges)
+  int repeat_lower = 0;		// for STRING_EDGE
+};
+
+struct NFAEdge {
+  unsigned int from;
+  unsigned int to;
+  Edge edge;
+};
+
+struct NFA {
+  unsigned int size = 0;
+  unsigned int initial = 0;
+  unsigned int final = 0;
+  std::vector <NFAEdge> edges;
+
+  constexpr void
+  shift_states(unsigned int shift)
+  {
+    size += shift;
+    initial += shift;
+    final += shift;
+    for (NFAEdge &e : edges) {
+      e.from += shift;
+      e.to += shift;
+    }
+  }
+
+  constexpr void
+  add_edge(unsigned int from, unsigned int to, Edge edge)
+  {
+    NFAEdge e = { from, to, edge };
+    edges.push_back(e);
+  }
+};
+
+struct RegexLoop {
+  int repeat_lower = 0;
+  std::string curr_prefix;
+  std::string curr_substring;
+
+  // additional iterations beyond the one in the test string
+  constexpr std::string
+  get_substring() const
+  {
+    std::string extra;
+    for (int j = 1; j < repeat_lower; j++) extra += curr_substring;
+    return extra;
+  }
+};
+
+// builds NFAs and test strings, same construction as NFA, Path, and TestGenerator
+struct Generator {
+  Parser parser;
+  std::vector <RegexLoop> loops;
+  std::string base_substring;
+  const char *error = nullptr;
+
+  constexpr NFA
+  single_edge(Edge edge)
+  {
+    NFA nfa;
+    nfa.size = 2;
+    nfa.initial = 0;
+    nfa.final = 1;
+    nfa.add_edge(0, 1, edge);
+    return nfa;
+  }
+
+  constexpr NFA
+  concat_nfa(NFA nfa1, NFA nfa2)
+  {
+    nfa2.shift_states(nfa1.size);
+    NFA nfa = nfa2;
+    nfa.edges.insert(nfa.edges.end(), nfa1.edges.begin(), nfa1.edges.end());
+    Edge epsilon;
+    nfa.add_edge(nfa1.final, nfa2.initial, epsilon);
+    nfa.initial = nfa1.initial;
+    return nfa;
+  }
+
+  constexpr NFA
+  build_nfa(int node_index)
+  {
+    const ParseNode node = parser.nodes[node_index];
+    Edge edge;
+
+    switch (node.type) {
+
+      case ALTERNATION_NODE:
+      {
+        NFA nfa1 = build_nfa(node.left);
+        NFA nfa2 = build_nfa(node.right);
+        nfa1.shift_states(1);
+        nfa2.shift_states(nfa1.size);
+        NFA nfa = nfa2;
+        nfa.edges.insert(nfa.edges.end(), nfa1.edges.begin(), nfa1.edges.end());
+        nfa.add_edge(0, nfa1.initial, edge);
+        nfa.add_edge(0, nfa2.initial, edge);
+        nfa.initial = 0;
+        nfa.size++;
+        nfa.final = nfa.size - 1;
+        nfa.add_edge(nfa1.final, nfa.final, edge);
+        nfa.add_edge(nfa2.final, nfa.final, edge);
+        return nfa;
+      }
+
+      case CONCAT_NODE:
+        return concat_nfa(build_nfa(node.left), build_nfa(node.right));
+
+      case REPEAT_NODE:
+      {
+        const ParseNode &child = parser.nodes[node.left];
+
+        // repeated character set that represents a string
+        if (child.type == CHAR_SET_NODE && node.repeat_upper == -1 &&
+            (node.repeat_lower == 0 || node.repeat_lower == 1) &&
+            parser.char_sets[child.char_set].is_string_candidate()) {
+          edge.type = STRING_EDGE;
+          edge.index = child.char_set;
+          edge.repeat_lower = node.repeat_lower;
+          return single_edge(edge);
+        }
+
+        NFA nfa = build_nfa(node.left);
+        nfa.shift_states(1);
+        nfa.size++;
+        RegexLoop loop;
+        loop.repeat_lower = node.repeat_lower;
+        loops.push_back(loop);
+        edge.index = loops.size() - 1;
+        edge.type = BEGIN_LOOP_EDGE;
+        nfa.add_edge(0, nfa.initial, edge);
+        edge.type = END_LOOP_EDGE;
+        nfa.add_edge(nfa.final, nfa.size - 1, edge);
+        nfa.initial = 0;
+        nfa.final = nfa.size - 1;
+        return nfa;
+      }
+
+      case GROUP_NODE:
+        return build_nfa(node.left);
+
+      case CHARACTER_NODE:
+        edge.type = CHARACTER_EDGE;
+        edge.character = node.character;
+        return single_edge(edge);
+
+      case CARET_NODE:
+        edge.type = CARET_EDGE;
+        return single_edge(edge);
+
+      case DOLLAR_NODE:
+        edge.type = DOLLAR_EDGE;
+        return single_edge(edge);
+
+      case CHAR_SET_NODE:
+        edge.type = CHAR_SET_EDGE;
+        edge.index = node.char_set;
+        return single_edge(edge);
+    }
+    return NFA();
+  }
+
+  // substring added to the initial test string for an edge
+  constexpr std::string
+  get_substring(const Edge &edge)
+  {
+    std::string s;
+    switch (edge.type) {
+      case CHARACTER_EDGE:
+        s += edge.character;
+        break;
+      case CHAR_SET_EDGE:
+      {
+        char c = parser.char_sets[edge.index].get_valid_character();
+        if (c == '\0' && error == nullptr) error = "ERROR (internal): Could not find valid character in char set";
+        s += c;
+        break;
+      }
+      case STRING_EDGE:
+        s = base_substring;
+        break;
+      case END_LOOP_EDGE:
+        s = loops[edge.index].get_substring();
+        break;
+      default:
+        break;
+    }
+    return s;
+  }
+
+  // finds the basis paths (as lists of edges) in the same order as NFA::find_basis_paths
+  constexpr std::vector <std::vector <Edge> >
+  find_basis_paths(const NFA &nfa)
+  {
+    // outgoing edges of each state ordered by destination
+    std::vector <std::vector <unsigned int> > out(nfa.size);
+    for (unsigned int i = 0; i < nfa.edges.size(); i++) {
+      std::vector <unsigned int> &list = out[nfa.edges[i].from];
+      unsigned int pos = list.size();
+      while (pos > 0 && nfa.edges[list[pos - 1]].to > nfa.edges[i].to) pos--;
+      list.insert(list.begin() + pos, i);
+    }
+
+    struct Frame {
+      unsigned int state;
+      unsigned int next;	// next outgoing edge to try
+      bool been_here;		// state was visited when the frame was created
+    };
+
+    std::vector <std::vector <Edge> > paths;
+    std::vector <bool> visited(nfa.size, false);
+    std::vector <unsigned int> path_states(1, nfa.initial);
+    std::vector <Edge> path_edges;
+    std::vector <Frame> stack;
+    stack.push_back(Frame { nfa.initial, 0, false });
+
+    while (!stack.empty()) {
+      Frame &top = stack.back();
+
+      // final state --> record the path
+      if (top.state == nfa.final) {
+        for (unsigned int state : path_states) visited[state] = true;
+        paths.push_back(path_edges);
+      }
+
+      // out of edges, or already visited and first edge done --> back up
+      bool done = top.state == nfa.final || top.next >= out[top.state].size() ||
+        (top.been_here && top.next > 0);
+      if (done) {
+        stack.pop_back();
+        if (!path_edges.empty()) {
+          path_edges.pop_back();
+          path_states.pop_back();
+        }
+        continue;
+      }
+
+      const NFAEdge &e = nfa.edges[out[top.state][top.next++]];
+      path_edges.push_back(e.edge);
+      path_states.push_back(e.to);
+      stack.push_back(Frame { e.to, 0, visited[e.to] });
+    }
+
+    return paths;
+  }
+
+  constexpr std::vector <std::string>
+  gen_test_strings(std::string_view regex)
+  {
+    std::vector <std::string> strings;
+
+    if (base_substring.size() < 2) {
+      error = "ERROR (bad arguments): Base substring must have at least two letters";
+      return strings;
+    }
+    for (char c : base_substring) {
+      if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))) {
+        error = "ERROR (bad arguments): Base substring can only contain letters";
+        return strings;
+      }
+    }
+
+    error = scan(regex, parser.tokens);
+    if (error != nullptr) return strings;
+    int root = parser.expr();
+    if (parser.error == nullptr && parser.get_type() != ERR) {
+      parser.error = "ERROR (parse error): expected end of regex";
+    }
+    error = parser.error;
+    if (error != nullptr) return strings;
+
+    NFA nfa = build_nfa(root);
+    std::vector <std::vector <Edge> > paths = find_basis_paths(nfa);
+
+    // initial strings (process every path before the minimum iteration strings)
+    std::vector <std::string> initial;
+    for (const std::vector <Edge> &path : paths) {
+      std::string test_string;
+      for (const Edge &edge : path) {
+        if (edge.type == BEGIN_LOOP_EDGE) loops[edge.index].curr_prefix = test_string;
+        if (edge.type == END_LOOP_EDGE) {
+          RegexLoop &loop = loops[edge.index];
+          loop.curr_substring = test_string.substr(loop.curr_prefix.size());
+        }
+        test_string += get_substring(edge);
+      }
+      initial.push_back(test_string);
+    }
+
+    // minimum iteration strings
+    std::vector <std::string> min_iter;
+    for (const std::vector <Edge> &path : paths) {
+      std::string min_iter_string;
+      for (const Edge &edge : path) {
+        switch (edge.type) {
+          case STRING_EDGE:
+            if (edge.repeat_lower != 0) min_iter_string += base_substring;
+            break;
+          case BEGIN_LOOP_EDGE:
+            loops[edge.index].curr_prefix = min_iter_string;
+            break;
+          case END_LOOP_EDGE:
+            if (loops[edge.index].repeat_lower != 0) {
+              min_iter_string += loops[edge.index].get_substring();
+            }
+            else {
+              min_iter_string = loops[edge.index].curr_prefix;
+            }
+            break;
+          default:
+            min_iter_string += get_substring(edge);
+        }
+      }
+      min_iter.push_back(min_iter_string);
+    }
+    if (error != nullptr) return strings;
+
+    // remove duplicates
+    initial.insert(initial.end(), min_iter.begin(), min_iter.end());
+    for (const std::string &str : initial) {
+      bool found = false;
+      for (const std::string &prev : strings) {
+        if (prev == str) found = true;
+      }
+      if (!found) strings.push_back(str);
+    }
+    return strings;
+  }
+};
+
+struct Result {
+  const char *error = nullptr;
+  std::vector <std::string> strings;
+};
+
+constexpr Result
+run(std::string_view regex, std::string_view base_substring)
+{
+  Generator generator;
+  generator.base_substring = std::string(base_substring);
+  Result result;
+  result.strings = generator.gen_test_strings(regex);
+  result.error = generator.error;
+  return result;
+}
+
+constexpr std::size_t
+total_size(const Result &result)
+{
+  std::size_t total = 0;
+  for (const std::string &str : result.strings) total += str.size();
+  return total;
+}
+
+} // namespace detail
+
+// returns the reason the regex is not supported (nullptr if supported)
+template <literal REGEX, literal BASE = "evil">
+constexpr const char *
+error()
+{
+  return detail::run(REGEX.view(), BASE.view()).error;
+}
+
+// returns the test strings for the regex
+template <literal REGEX, literal BASE = "evil">
+constexpr auto
+tests()
+{
+  static_assert(detail::run(REGEX.view(), BASE.view()).error == nullptr,
+      "EGRET: regex is not supported at compile time (egret::error gives the reason)");
+
+  constexpr std::size_t COUNT = detail::run(REGEX.view(), BASE.view()).strings.size();
+  constexpr std::size_t CHARS = detail::total_size(detail::run(REGEX.view(), BASE.view()));
+
+  string_table <COUNT, CHARS> table;
+  detail::Result result = detail::run(REGEX.view(), BASE.view());
+  std::size_t pos = 0;
+  for (std::size_t i = 0; i < COUNT; i++) {
+    table.offsets[i] = pos;
+    for (char c : result.strings[i]) table.data[pos++] = c;
+  }
+  table.offsets[COUNT] = pos;
+  return table;
+}
+
+} // namespace egret
+
+#endif // __cplusplus
+#endif // EGRET_CONSTEXPR_H
@@ -20,6 +20,8 @@
 */
 
 #include <Python.h>
+#include <cctype>
+#include <regex>
 #include <string>
 #include <vector>
 #include "egret.h"
@@ -36,25 +38,374 @@ egret_run(PyObject *self, PyObject *args)
   int web_mode;
   int debug_mode;
   int stat_mode;
+  unsigned int rules = CHECK_ALL;
 
-  if (!PyArg_ParseTuple(args, "sspppp", &regex, &base_substring,
-        &check_mode, &web_mode, &debug_mode, &stat_mode))
+  if (!PyArg_ParseTuple(args, "sspppp|I", &regex, &base_substring,
+        &check_mode, &web_mode, &debug_mode, &stat_mode, &rules))
     return NULL;
 
   vector <string> tests =
-    run_engine(regex, base_substring, check_mode, web_mode, debug_mode, stat_mode);
+    run_engine(regex, base_substring, check_mode, web_mode, debug_mode, stat_mode, rules);
 
   PyObject *list = PyList_New(0);
   vector <string>::iterator it;
   for (it = tests.begin(); it != tests.end(); it++) {
-    PyList_Append(list, PyUnicode_FromString((*it).c_str()));
+    PyList_Append(list, PyUnicode_FromStringAndSize(it->data(), it->size()));
   }
 
   return list;
 }
 
+// Converts a comma separated list of checker rule names into a rule mask.
+static PyObject *
+egret_rule_mask(PyObject *self, PyObject *args)
+{
+  const char *names;
+
+  if (!PyArg_ParseTuple(args, "s", &names))
+    return NULL;
+
+  unsigned int rules;
+  if (!get_rule_mask(names, rules)) {
+    PyErr_Format(EgretExtError, "invalid checker rule list: %s", names);
+    return NULL;
+  }
+  return PyLong_FromUnsignedLong(rules);
+}
+
+// Returns a dictionary for an alert record (suggest, example, and unused locations
+// are None).
+static PyObject *
+alert_dict(const Alert &alert)
+{
+  PyObject *locs[2];
+  Location alert_locs[2] = { alert.loc1, alert.loc2 };
+  for (int i = 0; i < 2; i++) {
+    if (alert_locs[i].first == -1) {
+      Py_INCREF(Py_None);
+      locs[i] = Py_None;
+    }
+    else {
+      locs[i] = Py_BuildValue("(ii)", alert_locs[i].first, alert_locs[i].second);
+    }
+  }
+
+  PyObject *suggest;
+  if (alert.has_suggest) {
+    suggest = PyUnicode_FromStringAndSize(alert.suggest.data(), alert.suggest.size());
+  }
+  else {
+    Py_INCREF(Py_None);
+    suggest = Py_None;
+  }
+  PyObject *example;
+  if (alert.has_example) {
+    example = PyUnicode_FromStringAndSize(alert.example.data(), alert.example.size());
+  }
+  else {
+    Py_INCREF(Py_None);
+    example = Py_None;
+  }
+
+  return Py_BuildValue("{s:O,s:s,s:s,s:N,s:N,s:N,s:N}",
+      "warning", alert.warning ? Py_True : Py_False, "type", alert.type.c_str(),
+      "message", alert.message.c_str(), "suggest", suggest, "example", example,
+      "loc1", locs[0], "loc2", locs[1]);
+}
+
+// Runs the checker, returns the error (None if there is no error) and a list of
+// alert dictionaries.
+static PyObject *
+egret_run_check(PyObject *self, PyObject *args)
+{
+  const char *regex;
+  const char *base_substring;
+  unsigned int rules = CHECK_ALL;
+
+  if (!PyArg_ParseTuple(args, "ss|I", &regex, &base_substring, &rules))
+    return NULL;
+
+  CheckResult result = run_check_engine(regex, base_substring, rules);
+
+  PyObject *list = PyList_New(0);
+  vector <Alert>::iterator it;
+  for (it = result.alerts.begin(); it != result.alerts.end(); it++) {
+    PyObject *item = alert_dict(*it);
+    PyList_Append(list, item);
+    Py_DECREF(item);
+  }
+
+  if (result.error == "") {
+    Py_INCREF(Py_None);
+    return Py_BuildValue("(NN)", Py_None, list);
+  }
+  return Py_BuildValue("(sN)", result.error.c_str(), list);
+}
+
+static PyObject *
+string_list(const vector <string> &strings)
+{
+  PyObject *list = PyList_New(0);
+  vector <string>::const_iterator it;
+  for (it = strings.begin(); it != strings.end(); it++) {
+    PyObject *item = PyUnicode_FromStringAndSize(it->data(), it->size());
+    PyList_Append(list, item);
+    Py_DECREF(item);
+  }
+  return list;
+}
+
+// Returns a list with a tuple of group strings for each match (None for groups that did
+// not participate) or None if the groups of the match are not known.
+static PyObject *
+group_list(const vector <string> &matches, const vector <vector <int> > &groups)
+{
+  PyObject *list = PyList_New(0);
+  for (unsigned int i = 0; i < groups.size(); i++) {
+    const vector <int> &spans = groups[i];
+    PyObject *item;
+    if (spans.empty()) {
+      Py_INCREF(Py_None);
+      item = Py_None;
+    }
+    else {
+      item = PyTuple_New(spans.size() / 2);
+      for (unsigned int g = 0; g < spans.size() / 2; g++) {
+        int start = spans[2 * g];
+        int end = spans[2 * g + 1];
+        PyObject *group;
+        if (start == -1 || end < start) {
+          Py_INCREF(Py_None);
+          group = Py_None;
+        }
+        else {
+          group = PyUnicode_FromStringAndSize(matches[i].c_str() + start, end - start);
+        }
+        PyTuple_SET_ITEM(item, g, group);
+      }
+    }
+    PyList_Append(list, item);
+    Py_DECREF(item);
+  }
+  return list;
+}
+
+static bool
+string_vector(PyObject *list, vector <string> &strings)
+{
+  for (Py_ssize_t i = 0; i < PyList_Size(list); i++) {
+    // strings can contain NUL characters
+    Py_ssize_t size;
+    const char *str = PyUnicode_AsUTF8AndSize(PyList_GetItem(list, i), &size);
+    if (str == NULL) return false;
+    strings.push_back(string(str, size));
+  }
+  return true;
+}
+
+// Same as run, but also returns a dictionary with the wall clock and CPU time (in
+// milliseconds) of each phase of the engine.
+static PyObject *
+egret_run_timed(PyObject *self, PyObject *args)
+{
+  const char *regex;
+  const char *base_substring;
+  int check_mode;
+  int web_mode;
+  unsigned int rules = CHECK_ALL;
+
+  if (!PyArg_ParseTuple(args, "sspp|I", &regex, &base_substring, &check_mode, &web_mode, &rules))
+    return NULL;
+
+  vector <Stats::Timer> timers;
+  vector <string> tests =
+    run_timed_engine(regex, base_substring, check_mode, web_mode, rules, timers);
+
+  PyObject *times = PyDict_New();
+  vector <Stats::Timer>::iterator it;
+  for (it = timers.begin(); it != timers.end(); it++) {
+    PyObject *item = Py_BuildValue("(dd)", it->wall_time, it->cpu_time);
+    PyDict_SetItemString(times, it->name.c_str(), item);
+    Py_DECREF(item);
+  }
+
+  return Py_BuildValue("(NN)", string_list(tests), times);
+}
+
+static PyObject *
+egret_run_match(PyObject *self, PyObject *args)
+{
+  const char *regex;
+  const char *base_substring;
+  PyObject *extra_list;
+  int web_mode;
+  int debug_mode;
+  int stat_mode;
+
+  if (!PyArg_ParseTuple(args, "ssO!ppp", &regex, &base_substring, &PyList_Type, &extra_list,
+        &web_mode, &debug_mode, &stat_mode))
+    return NULL;
+
+  vector <string> extra_strings;
+  if (!string_vector(extra_list, extra_strings)) return NULL;
+
+  MatchResult result =
+    run_match_engine(regex, base_substring, extra_strings, web_mode, debug_mode, stat_mode);
+
+  return Py_BuildValue("(NNNNN)", string_list(result.alerts), string_list(result.matches),
+      string_list(result.non_matches), string_list(result.unknown),
+      group_list(result.matches, result.groups));
+}
+
+static PyObject *
+egret_run_check_match(PyObject *self, PyObject *args)
+{
+  const char *regex;
+  const char *base_substring;
+  PyObject *extra_list;
+  int web_mode;
+  int debug_mode;
+  int stat_mode;
+
+  if (!PyArg_ParseTuple(args, "ssO!ppp", &regex, &base_substring, &PyList_Type, &extra_list,
+        &web_mode, &debug_mode, &stat_mode))
+    return NULL;
+
+  vector <string> extra_strings;
+  if (!string_vector(extra_list, extra_strings)) return NULL;
+
+  MatchResult result =
+    run_check_match_engine(regex, base_substring, extra_strings, web_mode, debug_mode, stat_mode);
+
+  return Py_BuildValue("(NNNNNN)", string_list(result.check_alerts), string_list(result.alerts),
+      string_list(result.matches), string_list(result.non_matches), string_list(result.unknown),
+      group_list(result.matches, result.groups));
+}
+
+static PyObject *
+egret_run_multi_match(PyObject *self, PyObject *args)
+{
+  PyObject *regex_list;
+  const char *base_substring;
+  PyObject *extra_list;
+  int web_mode;
+  int debug_mode;
+  int stat_mode;
+
+  if (!PyArg_ParseTuple(args, "O!sO!ppp", &PyList_Type, &regex_list, &base_substring,
+        &PyList_Type, &extra_list, &web_mode, &debug_mode, &stat_mode))
+    return NULL;
+
+  vector <string> regexes;
+  vector <string> extra_strings;
+  if (!string_vector(regex_list, regexes)) return NULL;
+  if (!string_vector(extra_list, extra_strings)) return NULL;
+
+  vector <MatchResult> results =
+    run_multi_match_engine(regexes, base_substring, extra_strings, web_mode, debug_mode, stat_mode);
+
+  PyObject *list = PyList_New(0);
+  vector <MatchResult>::iterator it;
+  for (it = results.begin(); it != results.end(); it++) {
+    PyObject *item = Py_BuildValue("(NNNN)", string_list(it->alerts), string_list(it->matches),
+        string_list(it->non_matches), string_list(it->unknown));
+    PyList_Append(list, item);
+    Py_DECREF(item);
+  }
+  return list;
+}
+
+// std::regex matches recursively (its depth grows with the string length) and expands
+// bounded repeats, so longer strings and larger repeat counts are not matched
+#define MAX_STD_LENGTH 1000
+#define MAX_STD_REPEAT 1000
+
+// returns the largest count of a bounded repeat in the regex (counts above
+// MAX_STD_REPEAT are not read exactly)
+static unsigned long
+std_max_repeat(const string &regex)
+{
+  unsigned long max_count = 0;
+  bool in_class = false;
+  for (unsigned int i = 0; i < regex.size(); i++) {
+    char c = regex[i];
+    if (c == '\\') i++;
+    else if (c == '[') in_class = true;
+    else if (c == ']') in_class = false;
+    else if (c == '{' && !in_class) {
+      unsigned long count = 0;
+      while (i + 1 < regex.size() && (isdigit(regex[i + 1]) || regex[i + 1] == ',')) {
+        i++;
+        if (regex[i] == ',') count = 0;
+        else if (count <= MAX_STD_REPEAT) count = count * 10 + (regex[i] - '0');
+        if (count > max_count) max_count = count;
+      }
+    }
+  }
+  return max_count;
+}
+
+// Classifies strings with std::regex (ECMAScript grammar), returns a list of booleans
+// (None for strings that are too long to match) or None if std::regex does not accept
+// the regex or its repeat counts are too large.
+static PyObject *
+egret_std_match(PyObject *self, PyObject *args)
+{
+  const char *regex_str;
+  PyObject *string_list_obj;
+
+  if (!PyArg_ParseTuple(args, "sO!", &regex_str, &PyList_Type, &string_list_obj))
+    return NULL;
+
+  vector <string> strings;
+  if (!string_vector(string_list_obj, strings)) return NULL;
+
+  if (std_max_repeat(regex_str) > MAX_STD_REPEAT) Py_RETURN_NONE;
+
+  regex re;
+  try {
+    re.assign(regex_str, regex::ECMAScript);
+  }
+  catch (regex_error const &e) {
+    Py_RETURN_NONE;
+  }
+
+  PyObject *list = PyList_New(0);
+  vector <string>::iterator it;
+  for (it = strings.begin(); it != strings.end(); it++) {
+    if (it->size() > MAX_STD_LENGTH) {
+      PyList_Append(list, Py_None);
+      continue;
+    }
+    bool accepted;
+    try {
+      accepted = regex_match(*it, re);
+    }
+    catch (regex_error const &e) {
+      Py_DECREF(list);
+      Py_RETURN_NONE;
+    }
+    PyList_Append(list, accepted ? Py_True : Py_False);
+  }
+  return list;
+}
+
 static PyMethodDef EgretExtMethods[] = {
   {"run", egret_run, METH_VARARGS, "Run EGRET."},
+  {"run_timed", egret_run_timed, METH_VARARGS,
+    "Run EGRET and return the time spent in each phase."},
+  {"run_check", egret_run_check, METH_VARARGS,
+    "Run the EGRET checker and return the alerts as dictionaries."},
+  {"rule_mask", egret_rule_mask, METH_VARARGS,
+    "Convert a comma separated list of checker rules into a rule mask."},
+  {"run_match", egret_run_match, METH_VARARGS,
+    "Run EGRET and classify the test strings as matches and non-matches."},
+  {"run_check_match", egret_run_check_match, METH_VARARGS,
+    "Run the EGRET checker and classify the test strings in one run."},
+  {"run_multi_match", egret_run_multi_match, METH_VARARGS,
+    "Run EGRET on several regexes and classify all of the test strings against each regex."},
+  {"std_match", egret_std_match, METH_VARARGS,
+    "Classify strings with std::regex (ECMAScript grammar), None for skipped strings."},
   {NULL, NULL, 0, NULL}        /* Sentinel */
 };
 
@@ -32,7 +32,6 @@ static char *get_arg(int &idx, int argc, char **argv);
 int
 main(int argc, char *argv[])
 {
-  cout << "RUNNING PROGRAM" << endl;
   int idx = 1;
   string regex = "";
   string base_substring = "evil";
@@ -40,6 +39,8 @@ main(int argc, char *argv[])
   bool web_mode = false;
   bool debug_mode = false;
   bool stat_mode = false;
+  unsigned int rules = CHECK_ALL;
+  string function_name = "";
 
   // Process arguments
   while (idx < argc) {
@@ -90,6 +91,20 @@ main(int argc, char *argv[])
       debug_mode = true;
     }
 
+    // -g: generate C++ source code for a matcher function with the given name
+    else if (strcmp(arg, "-g") == 0) {
+      function_name = get_arg(idx, argc, argv);
+    }
+
+    // -k: comma separated list of checker rules to run in check mode
+    else if (strcmp(arg, "-k") == 0) {
+      char *names = get_arg(idx, argc, argv);
+      if (!get_rule_mask(names, rules)) {
+        cerr << "USAGE: Invalid checker rule list: " << names << endl;
+        return -1;
+      }
+    }
+
     // -s: print stats
     else if (strcmp(arg, "-s") == 0) {
       stat_mode = true;
@@ -113,8 +128,24 @@ main(int argc, char *argv[])
     return -1;
   }
 
+  // generated source code is the only output (errors go to stderr)
+  if (function_name != "") {
+    if (debug_mode || stat_mode) {
+      cerr << "USAGE: Cannot print debug information or stats when generating code" << endl;
+      return -1;
+    }
+    string source = run_codegen_engine(regex, base_substring, function_name);
+    if (source.compare(0, 5, "ERROR") == 0) {
+      cerr << source << endl;
+      return -1;
+    }
+    cout << source;
+    return 0;
+  }
+
+  cout << "RUNNING PROGRAM" << endl;
   vector <string> test_strings =
-    run_engine(regex, base_substring, check_mode, web_mode, debug_mode, stat_mode);
+    run_engine(regex, base_substring, check_mode, web_mode, debug_mode, stat_mode, rules);
 
   vector <string>::iterator it;
   for (it = test_strings.begin(); it != test_strings.end(); it++) {
@@ -0,0 +1,95 @@
+/*  scanner_bench.cpp: measures the scanner on a corpus of regexes
+
+    Copyright (C) 2016-2018  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// The regexes in the corpus files (one per line) are scanned repeatedly in
+// check mode, as when linting a batch of regexes, and the throughput is
+// reported.  Regexes that the scanner rejects are scanned as well.
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "Scanner.h"
+#include "Util.h"
+using namespace std;
+
+// Minimum number of regex characters scanned for the measurement.
+static const size_t BYTES_PER_RUN = 64 * 1024 * 1024;
+
+int
+main(int argc, char *argv[])
+{
+  if (argc < 2) {
+    cerr << "USAGE: scanner_bench corpus ..." << endl;
+    return -1;
+  }
+
+  vector <string> regexes;
+  size_t corpus_bytes = 0;
+  for (int i = 1; i < argc; i++) {
+    ifstream corpus(argv[i]);
+    if (!corpus) {
+      cerr << "ERROR: cannot read " << argv[i] << endl;
+      return -1;
+    }
+    string regex;
+    while (getline(corpus, regex)) {
+      if (regex == "") continue;
+      regexes.push_back(regex);
+      corpus_bytes += regex.size();
+    }
+  }
+  if (regexes.empty()) {
+    cerr << "ERROR: corpus is empty" << endl;
+    return -1;
+  }
+
+  size_t runs = BYTES_PER_RUN / corpus_bytes + 1;
+  size_t num_tokens = 0;
+  size_t num_errors = 0;
+  Scanner scanner;
+
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  for (size_t r = 0; r < runs; r++) {
+    for (unsigned int i = 0; i < regexes.size(); i++) {
+      Util::get()->init(regexes[i], true, false, "evil");
+      try {
+        scanner.init(regexes[i]);
+        num_tokens += scanner.get_tokens().size();
+      }
+      catch (EgretException const &e) {
+        num_errors++;
+      }
+    }
+  }
+  chrono::duration <double> elapsed = chrono::steady_clock::now() - start;
+
+  size_t num_regexes = runs * regexes.size();
+  printf("Regexes: %zu (%zu characters, %zu rejected), scanned %zu times\n",
+      regexes.size(), corpus_bytes, num_errors / runs, runs);
+  printf("%.1f ns per regex, %.2f ns per token, %.1f MB per second\n",
+      elapsed.count() * 1e9 / num_regexes, elapsed.count() * 1e9 / num_tokens,
+      runs * corpus_bytes / elapsed.count() / 1e6);
+
+  return 0;
+}